@@ -0,0 +1,242 @@
+/********************************************************************************
+ * File: ini_stream.hpp
+ * Author: ppkantorski
+ * Description:
+ *   This header file provides the streaming INI reader shared by the INI
+ *   functions, the libtesla settings helpers and the hekate config loaders in
+ *   payload.cpp. Lines are read through one large buffer and reported to
+ *   callbacks as string views, which may stop the read at any point.
+ *
+ *   The header is self-contained and only has inline or template functions,
+ *   so it can be included from both the source and common trees.
+ *
+ *   For the latest updates and contributions, visit the project's GitHub repository.
+ *   (GitHub Repository: https://github.com/ppkantorski/Ultrahand-Overlay)
+ *
+ *   Note: Please be aware that this notice cannot be altered or removed. It is a part
+ *   of the project's documentation and must remain intact.
+ *
+ *  Licensed under both GPLv2 and CC-BY-4.0
+ *  Copyright (c) 2024 ppkantorski
+ ********************************************************************************/
+
+#pragma once
+#include <cstdio>   // For FILE*, fopen(), fread(), etc.
+#include <cstring>  // For std::memmove
+#include <string>   // For std::string
+#include <string_view> // For std::string_view
+#include <vector>   // For std::vector
+
+
+constexpr size_t IniStreamInitialBufferSize = 4096; // Enough for lookups that stop near the start
+constexpr size_t IniStreamBufferSize = 65536;
+
+/**
+ * @brief Trims leading and trailing whitespaces from a string view without copying.
+ *
+ * @param str The input string view to trim.
+ * @return A view of the trimmed range within the input.
+ */
+inline std::string_view trimView(std::string_view str) {
+    size_t first = str.find_first_not_of(" \t\n\r\f\v");
+    if (first == std::string_view::npos)
+        return std::string_view();
+    size_t last = str.find_last_not_of(" \t\n\r\f\v");
+    return str.substr(first, last - first + 1);
+}
+
+/**
+ * @brief Skips a UTF-8 byte order mark at the start of INI content, as inih and hekate do.
+ *
+ * @param content The content, from its first byte.
+ * @return The content without the byte order mark.
+ */
+inline std::string_view skipIniByteOrderMark(std::string_view content) {
+    if (content.substr(0, 3) == "\xEF\xBB\xBF")
+        content.remove_prefix(3);
+    return content;
+}
+
+/**
+ * @brief Kind of a single INI line.
+ */
+enum class IniLineType {
+    Other,    // Empty line or line without '='
+    Section,  // "[name]", optionally followed by a comment
+    KeyValue  // "key = value"
+};
+
+/**
+ * @brief A classified INI line. Both views point into the line that was parsed.
+ */
+struct IniLine {
+    IniLineType type;
+    std::string_view name;  // Section name or key
+    std::string_view value;
+};
+
+/**
+ * @brief Finds the closing bracket of a section header.
+ *
+ * The header either ends the line, or is followed by a ';' or '#' comment as inih and hekate
+ * allow. "[]" is a header with an empty name.
+ *
+ * @param line The trimmed line.
+ * @return The position of the closing ']', or std::string_view::npos if the line is no header.
+ */
+inline size_t findIniSectionEnd(std::string_view line) {
+    if (line.size() < 2 || line.front() != '[')
+        return std::string_view::npos;
+    
+    size_t closePos = line.find(']', 1);
+    size_t tailPos;
+    while (closePos != std::string_view::npos) {
+        tailPos = line.find_first_not_of(" \t", closePos + 1);
+        if (tailPos == std::string_view::npos)
+            return closePos;
+        if (line[tailPos] == ';' || line[tailPos] == '#')
+            return closePos;
+        closePos = line.find(']', closePos + 1);
+    }
+    return std::string_view::npos;
+}
+
+/**
+ * @brief Classifies one INI line.
+ *
+ * Lines are trimmed, sections look like "[name]" (see findIniSectionEnd()) and key-value pairs are
+ * split on the first '='.
+ *
+ * @param line The raw line, with or without its line ending.
+ * @return The classified line.
+ */
+inline IniLine parseIniLine(std::string_view line) {
+    line = trimView(line);
+    
+    const size_t sectionEnd = findIniSectionEnd(line);
+    if (sectionEnd != std::string_view::npos)
+        return {IniLineType::Section, line.substr(1, sectionEnd - 1), std::string_view()};
+    
+    const size_t delimiterPos = line.find('=');
+    if (delimiterPos != std::string_view::npos)
+        return {IniLineType::KeyValue, trimView(line.substr(0, delimiterPos)), trimView(line.substr(delimiterPos + 1))};
+    
+    return {IniLineType::Other, std::string_view(), std::string_view()};
+}
+
+/**
+ * @brief Streams an already opened INI file line by line through a single read buffer.
+ *
+ * Handlers receive string views that are only valid during the call and return false to stop.
+ * When stopped early, the file is left positioned right after the line that stopped the read.
+ *
+ * The buffer starts at IniStreamInitialBufferSize and doubles after each read up to
+ * IniStreamBufferSize, so a read that stops early allocates and reads little.
+ *
+ * @param file The open file, read from its current position.
+ * @param onSection Called as onSection(sectionName) for each section header.
+ * @param onKeyValue Called as onKeyValue(sectionName, key, value) for each pair.
+ * @param sectionsOnly Skips all lines that cannot be section headers without splitting them.
+ * @return True if a handler stopped the read, false if the end of the file was reached.
+ */
+template <typename SectionHandler, typename KeyValueHandler>
+bool readIniStream(FILE* file, SectionHandler&& onSection, KeyValueHandler&& onKeyValue, bool sectionsOnly = false) {
+    std::vector<char> buffer(IniStreamInitialBufferSize);
+    std::string currentSection; // Owned copy, the buffer is reused between reads
+    
+    size_t filled = 0, bytesRead, lineStart, lineEnd, firstChar;
+    bool atEnd = false, firstLine = true;
+    std::string_view data, line;
+    IniLine iniLine;
+    
+    while (!atEnd) {
+        if (filled == buffer.size())
+            buffer.resize(buffer.size() * 2); // A single line is longer than the buffer
+        
+        bytesRead = fread(buffer.data() + filled, 1, buffer.size() - filled, file);
+        filled += bytesRead;
+        atEnd = (filled < buffer.size());
+        
+        data = std::string_view(buffer.data(), filled);
+        lineStart = 0;
+        
+        // Skip a UTF-8 byte order mark
+        if (firstLine)
+            lineStart = filled - skipIniByteOrderMark(data).size();
+        firstLine = false;
+        
+        while (lineStart < filled) {
+            lineEnd = data.find('\n', lineStart);
+            if (lineEnd == std::string_view::npos) {
+                if (!atEnd)
+                    break; // Incomplete line, read more first
+                lineEnd = filled;
+            }
+            line = data.substr(lineStart, lineEnd - lineStart);
+            lineStart = lineEnd + 1;
+            
+            if (sectionsOnly) {
+                firstChar = line.find_first_not_of(" \t\r\f\v");
+                if (firstChar == std::string_view::npos || line[firstChar] != '[')
+                    continue;
+            }
+            
+            iniLine = parseIniLine(line);
+            if (iniLine.type == IniLineType::Section) {
+                currentSection.assign(iniLine.name);
+                if (!onSection(std::string_view(currentSection))) {
+                    if (lineStart < filled)
+                        fseek(file, -static_cast<long>(filled - lineStart), SEEK_CUR);
+                    return true;
+                }
+            } else if (iniLine.type == IniLineType::KeyValue && !sectionsOnly) {
+                if (!onKeyValue(std::string_view(currentSection), iniLine.name, iniLine.value)) {
+                    if (lineStart < filled)
+                        fseek(file, -static_cast<long>(filled - lineStart), SEEK_CUR);
+                    return true;
+                }
+            }
+        }
+        
+        // Keep the incomplete line for the next read
+        if (lineStart < filled) {
+            std::memmove(buffer.data(), buffer.data() + lineStart, filled - lineStart);
+            filled -= lineStart;
+        } else
+            filled = 0;
+        
+        if (!atEnd && buffer.size() < IniStreamBufferSize)
+            buffer.resize(buffer.size() * 2);
+    }
+    return false;
+}
+
+/**
+ * @brief Streams the INI file at the specified path, see readIniStream(FILE*, ...).
+ *
+ * @return False if the file could not be opened, true otherwise.
+ */
+template <typename SectionHandler, typename KeyValueHandler>
+bool readIniStream(const char* filePath, SectionHandler&& onSection, KeyValueHandler&& onKeyValue, bool sectionsOnly = false) {
+    FILE* file = fopen(filePath, "rb");
+    if (!file)
+        return false;
+    
+    readIniStream(file, onSection, onKeyValue, sectionsOnly);
+    fclose(file);
+    return true;
+}
+
+/**
+ * @brief Streams only the section headers of the INI file at the specified path.
+ *
+ * Key-value lines are skipped without being parsed.
+ *
+ * @param filePath The path to the INI file.
+ * @param onSection Called as onSection(sectionName) for each section header, returns false to stop.
+ * @return False if the file could not be opened, true otherwise.
+ */
+template <typename SectionHandler>
+bool readIniSections(const char* filePath, SectionHandler&& onSection) {
+    return readIniStream(filePath, onSection, [](std::string_view, std::string_view, std::string_view) { return true; }, true);
+}
@@ -19,7 +19,7 @@
 #include "rtc_r2p.hpp"
 #include "reboot_to_payload.h"
 #include "ams_bpc.h"
-#include "ini.h"
+#include "ini_stream.hpp"
 
 #include <unistd.h>
 #include <cstdio>
@@ -48,29 +48,24 @@ namespace Payload {
                 smc_reboot_to_payload();
         }
 
-        int HekateConfigHandler(void *user, char const *section, char const *name, char const *value) {
-            auto const list = reinterpret_cast<HekateConfigList *>(user);
-
+        bool HekateConfigHandler(HekateConfigList &list, std::string_view section) {
             /* Ignore pre-config and global config entries. */
-            if (section[0] == '\0' || std::strcmp(section, "config") == 0) {
-                return 1;
+            if (section.empty() || section == "config") {
+                return true;
             }
 
             /* Find existing entry. */
-            auto it = std::find_if(list->begin(), list->end(), [section](HekateConfig &cfg) {
+            auto it = std::find_if(list.begin(), list.end(), [section](HekateConfig &cfg) {
                 return cfg.name == section;
             });
 
             /* Create config entry if not existant. */
-            HekateConfig &config = (it != list->end()) ? *it : list->emplace_back(section, list->size() + 1);
+            if (it == list.end())
+                list.emplace_back(std::string(section), list.size() + 1);
 
             /* TODO: parse more information and display that. */
-            (void)config;
-
-            (void)name;
-            (void)value;
 
-            return 1;
+            return true;
         }
 
         constexpr char const *const HekatePaths[] = {
@@ -127,7 +122,9 @@ namespace Payload {
 
     HekateConfigList LoadHekateConfigList() {
         HekateConfigList configs;
-        ini_parse("sdmc:/bootloader/hekate_ipl.ini", HekateConfigHandler, &configs);
+        readIniSections("sdmc:/bootloader/hekate_ipl.ini", [&configs](std::string_view section) {
+            return HekateConfigHandler(configs, section);
+        });
         return configs;
     }
 
@@ -170,9 +167,11 @@ namespace Payload {
             }
         }
 
-        /* parse config */
+        /* parse config, only the section headers are read */
         for (auto const &entry : std::span(dir_entries, count))
-            ini_parse(entry, HekateConfigHandler, &configs);
+            readIniSections(entry, [&configs](std::string_view section) {
+                return HekateConfigHandler(configs, section);
+            });
 
         closedir(dirp);
 
@@ -53,6 +53,7 @@
 #include <functional>
 #include <type_traits>
 #include <mutex>
+#include <atomic>
 #include <memory>
 #include <chrono>
 #include <list>
@@ -64,8 +65,6 @@
 #include "../../../source/ini_funcs.hpp"
 #include "../../../source/json_funcs.hpp"
 
-static std::unordered_map<std::string, std::string> hexSumCache;
-
 /**
  * @brief Shutdown modes for the Ultrahand-Overlay project.
  *
@@ -1090,6 +1089,219 @@ namespace tsl {
         return hexToRGB444Floats(defaultHexColor);
     }
     
+    // CUSTOM MODIFICATION start
+    /**
+     * @brief Default theme.ini entries, in the order they are written when a theme is initialized.
+     */
+    static const std::vector<std::pair<std::string, std::string>> defaultThemeSettings = {
+        {"clock_color", "#FFFFFF"},
+        {"battery_color", "#FFFFFF"},
+        {"bg_alpha", "13"},
+        {"bg_color", "#000000"},
+        {"seperator_alpha", "7"},
+        {"seperator_color", "#777777"},
+        {"text_color", "#FFFFFF"},
+        {"info_text_color", "#FFFFFF"},
+        {"version_text_color", "#AAAAAA"},
+        {"on_text_color", "#00FFDD"},
+        {"off_text_color", "#AAAAAA"},
+        {"invalid_text_color", "#FF0000"},
+        {"selection_text_color", "#FFFFFF"},
+        {"selection_bg_color", "#000000"},
+        {"trackbar_color", "#555555"},
+        {"highlight_color_1", "#2288CC"},
+        {"highlight_color_2", "#88FFFF"},
+        {"click_text_color", "#000000"},
+        {"click_color", "#F7253E"},
+        {"invert_bg_click_color", "false"},
+        {"disable_selection_bg", "true"},
+        {"disable_colorful_logo", "false"},
+        {"logo_color_1", "#FFFFFF"},
+        {"logo_color_2", "#F7253E"},
+        {"dynamic_logo_color_1", "#00E669"},
+        {"dynamic_logo_color_2", "#8080EA"}
+    };
+    
+    /**
+     * @brief Hashes the content of theme.ini, so an edit is noticed even when it keeps the file's size and mtime.
+     *
+     * @param themeIniPath Path to theme.ini
+     * @return FNV-1a hash of the file, or the hash of an empty file if it cannot be read
+     */
+    static u64 hashThemeFile(const std::string& themeIniPath) {
+        u64 hash = 0xCBF29CE484222325ULL;
+        FILE* file = fopen(themeIniPath.c_str(), "rb");
+        if (!file)
+            return hash;
+        
+        unsigned char buffer[4096];
+        size_t bytesRead;
+        while ((bytesRead = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            for (size_t i = 0; i < bytesRead; ++i)
+                hash = (hash ^ buffer[i]) * 0x100000001B3ULL;
+        }
+        fclose(file);
+        return hash;
+    }
+    
+    /**
+     * @brief Resolved theme colors and flags, parsed once from theme.ini and shared by every element.
+     */
+    struct ThemeTable {
+        u64 sourceHash = 0; // hashThemeFile() of the theme.ini the table was built from
+        
+        bool disableSelectionBG = true;
+        bool invertBGClickColor = false;
+        bool disableColorfulLogo = false;
+        
+        Color selectionBGColor = {0x0, 0x0, 0x0, 0xF};
+        Color highlightColor1 = {0x2, 0x8, 0xC, 0xF};
+        Color highlightColor2 = {0x8, 0xF, 0xF, 0xF};
+        Color clickColor = {0xF, 0x2, 0x3, 0xF};
+        
+        Color logoColor1 = {0xF, 0xF, 0xF, 0xF};
+        Color logoColor2 = {0xF, 0x2, 0x3, 0xF};
+        Color defaultBackgroundColor = {0x0, 0x0, 0x0, 0xD};
+        Color defaultTextColor = {0xF, 0xF, 0xF, 0xF};
+        Color infoTextColor = {0xF, 0xF, 0xF, 0xF};
+        Color clockColor = {0xF, 0xF, 0xF, 0xF};
+        Color batteryColor = {0xF, 0xF, 0xF, 0xF};
+        Color versionTextColor = {0xA, 0xA, 0xA, 0xF};
+        Color onTextColor = {0x0, 0xF, 0xD, 0xF};
+        Color offTextColor = {0xA, 0xA, 0xA, 0xF};
+        Color invalidTextColor = {0xF, 0x0, 0x0, 0xF};
+        Color selectedTextColor = {0xF, 0xF, 0xF, 0xF};
+        Color clickTextColor = {0x0, 0x0, 0x0, 0xF};
+        Color trackBarColor = {0x5, 0x5, 0x5, 0xF};
+        Color seperatorColor = {0x7, 0x7, 0x7, 0x7};
+        
+        std::tuple<float, float, float> dynamicLogoRGB1 = {0.0f, 0.0f, 0.0f};
+        std::tuple<float, float, float> dynamicLogoRGB2 = {0.0f, 0.0f, 0.0f};
+        
+        ThemeTable() {}
+        
+        /**
+         * @brief Parses the [theme] section of the given file into resolved colors.
+         * Missing or invalid entries fall back to the same defaults the elements used before.
+         *
+         * @param themeIniPath Path to theme.ini
+         */
+        explicit ThemeTable(const std::string& themeIniPath) {
+            sourceHash = hashThemeFile(themeIniPath);
+            
+            IniTable themeTable;
+            themeTable.load(themeIniPath);
+            
+            auto get = [&themeTable](const char* key) -> std::string {
+                return themeTable.getValue("theme", key);
+            };
+            
+            std::string value = get("disable_selection_bg");
+            disableSelectionBG = (!value.empty() && value != "false");
+            invertBGClickColor = (get("invert_bg_click_color") == "true");
+            value = get("disable_colorful_logo");
+            disableColorfulLogo = (!value.empty() && value == "true");
+            
+            selectionBGColor = RGB888(get("selection_bg_color"), "#000000");
+            highlightColor1 = RGB888(get("highlight_color_1"), "#2288CC");
+            highlightColor2 = RGB888(get("highlight_color_2"), "#88FFFF");
+            clickColor = RGB888(get("click_color"), "#F7253E");
+            
+            logoColor1 = RGB888(get("logo_color_1"), "#FFFFFF");
+            logoColor2 = RGB888(get("logo_color_2"), "#F7253E");
+            
+            value = get("bg_alpha");
+            size_t backgroundAlpha = (!value.empty()) ? std::stoi(value) : 13;
+            defaultBackgroundColor = RGB888(get("bg_color"), "#000000", backgroundAlpha);
+            
+            defaultTextColor = RGB888(get("text_color"));
+            infoTextColor = RGB888(get("info_text_color"));
+            clockColor = RGB888(get("clock_color"));
+            batteryColor = RGB888(get("battery_color"));
+            versionTextColor = RGB888(get("version_text_color"), "#AAAAAA");
+            onTextColor = RGB888(get("on_text_color"), "#00FFDD");
+            offTextColor = RGB888(get("off_text_color"), "#AAAAAA");
+            invalidTextColor = RGB888(get("invalid_text_color"), "#FF0000");
+            selectedTextColor = RGB888(get("selection_text_color"));
+            clickTextColor = RGB888(get("click_text_color"));
+            trackBarColor = RGB888(get("trackbar_color"), "#555555");
+            
+            value = get("seperator_alpha");
+            size_t seperatorAlpha = (!value.empty()) ? std::stoi(value) : 7;
+            seperatorColor = RGB888(get("seperator_color"), "#777777", seperatorAlpha);
+            
+            dynamicLogoRGB1 = hexToRGB444Floats(get("dynamic_logo_color_1"), "#00E669");
+            dynamicLogoRGB2 = hexToRGB444Floats(get("dynamic_logo_color_2"), "#8080EA");
+        }
+    };
+    
+    static std::atomic<const ThemeTable*> activeThemeTable{nullptr};
+    static std::shared_ptr<const ThemeTable> activeThemeTableHolder;
+    static std::atomic<bool> themeFrameInProgress{false}; // Set by Overlay::loop() while a frame is drawn
+    static std::string deferredThemeIniPath;              // Reload requested while a frame was drawn
+    static std::mutex themeTableMutex;
+    
+    /**
+     * @brief Rebuilds the shared theme table from theme.ini and publishes it.
+     *
+     * Elements hold a plain reference to the table while they draw, so it is only replaced between
+     * frames: a reload requested while a frame is drawn is deferred until Overlay::loop() has finished
+     * the frame. References must not be kept past the frame or input handler that took them.
+     *
+     * @param themeIniPath Path to theme.ini
+     */
+    static void reloadThemeTable(const std::string& themeIniPath = "/config/ultrahand/theme.ini") {
+        std::lock_guard<std::mutex> lock(themeTableMutex);
+        if (themeFrameInProgress.load(std::memory_order_acquire) && activeThemeTable.load(std::memory_order_acquire) != nullptr) {
+            deferredThemeIniPath = themeIniPath;
+            return;
+        }
+        
+        activeThemeTableHolder = std::make_shared<const ThemeTable>(themeIniPath);
+        activeThemeTable.store(activeThemeTableHolder.get(), std::memory_order_release);
+    }
+    
+    /**
+     * @brief Applies a reload that reloadThemeTable() deferred during the last frame.
+     */
+    static void applyDeferredThemeTableReload() {
+        std::string themeIniPath;
+        {
+            std::lock_guard<std::mutex> lock(themeTableMutex);
+            themeIniPath.swap(deferredThemeIniPath);
+        }
+        if (!themeIniPath.empty())
+            reloadThemeTable(themeIniPath);
+    }
+    
+    /**
+     * @brief Rebuilds the theme table if theme.ini changed since the table was built.
+     * Package commands can copy over or edit theme.ini, so this runs after every command batch.
+     *
+     * @param themeIniPath Path to theme.ini
+     */
+    static void refreshThemeTable(const std::string& themeIniPath = "/config/ultrahand/theme.ini") {
+        const ThemeTable* themeTable = activeThemeTable.load(std::memory_order_acquire);
+        if (themeTable != nullptr && themeTable->sourceHash == hashThemeFile(themeIniPath))
+            return;
+        reloadThemeTable(themeIniPath);
+    }
+    
+    /**
+     * @brief Returns the active theme table, loading it on first use.
+     *
+     * @return Shared theme table
+     */
+    static const ThemeTable& getThemeTable() {
+        const ThemeTable* themeTable = activeThemeTable.load(std::memory_order_acquire);
+        if (themeTable == nullptr) {
+            reloadThemeTable();
+            themeTable = activeThemeTable.load(std::memory_order_acquire);
+        }
+        return *themeTable;
+    }
+    // CUSTOM MODIFICATION end
+    
     
     
     namespace style {
@@ -2197,18 +2409,8 @@ namespace tsl {
             Element() {}
             virtual ~Element() { }
             
-            std::string disableSelectionBGStr = parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "disable_selection_bg");
-            bool disableSelectionBG = (!disableSelectionBGStr.empty() && disableSelectionBGStr != "false");
-            
-            bool invertBGClickColor = (parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "invert_bg_click_color") == "true");
-            Color selectionBGColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "selection_bg_color"), "#000000");
-            
-            Color highlightColor1 = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "highlight_color_1"), "#2288CC");
-            Color highlightColor2 = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "highlight_color_2"), "#88FFFF");
             Color highlightColor = {0xf,0xf,0xf,0xf};
             
-            Color clickColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "click_color"), "#F7253E");
-            
             std::chrono::duration<long int, std::ratio<1, 1000000000>> t;
             //double timeCounter;
             u8 saturation;
@@ -2357,10 +2559,11 @@ namespace tsl {
              * @param renderer Renderer
              */
             virtual void drawClickAnimation(gfx::Renderer *renderer) {
+                const ThemeTable& theme = getThemeTable();
                 
-                if (!disableSelectionBG) {
+                if (!theme.disableSelectionBG) {
                     saturation = tsl::style::ListItemHighlightSaturation * (float(this->m_clickAnimationProgress) / float(tsl::style::ListItemHighlightLength));
-                    if (invertBGClickColor) {
+                    if (theme.invertBGClickColor) {
                         animColor.r = 15-saturation;
                         animColor.g = 15-saturation;
                         animColor.b = 15;
@@ -2371,15 +2574,15 @@ namespace tsl {
                     }
                     renderer->drawRect(ELEMENT_BOUNDS(this), (animColor));
                 } else {
-                    clickColor1 = highlightColor1;
-                    clickColor2 = clickColor;
+                    clickColor1 = theme.highlightColor1;
+                    clickColor2 = theme.clickColor;
                     
                     //half progress = half((std::sin(2.0 * M_PI * fmod(std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count(), 1.0)) + 1.0) / 2.0);
                     progress = (std::sin(2.0 * M_PI * fmod(std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count(), 1.0)) + 1.0) / 2.0;
                     
                     if (progress >= 0.5) {
-                        clickColor1 = clickColor;
-                        clickColor2 = highlightColor2;
+                        clickColor1 = theme.clickColor;
+                        clickColor2 = theme.highlightColor2;
                     }
                     
                     highlightColor = {
@@ -2447,8 +2650,9 @@ namespace tsl {
              * @param renderer Renderer
              */
             virtual void drawFocusBackground(gfx::Renderer *renderer) {
-                if (!disableSelectionBG)
-                    renderer->drawRect(ELEMENT_BOUNDS(this), selectionBGColor); // CUSTOM MODIFICATION 
+                const ThemeTable& theme = getThemeTable();
+                if (!theme.disableSelectionBG)
+                    renderer->drawRect(ELEMENT_BOUNDS(this), theme.selectionBGColor); // CUSTOM MODIFICATION 
                 
                 if (this->m_clickAnimationProgress > 0) {
                     this->drawClickAnimation(renderer);
@@ -2463,6 +2667,7 @@ namespace tsl {
              * @param renderer Renderer
              */
             virtual void drawHighlight(gfx::Renderer *renderer) { // CUSTOM MODIFICATION start
+                const ThemeTable& theme = getThemeTable();
                 
                 //Color highlightColor1 = {0x2, 0x8, 0xC, 0xF};
                 //Color highlightColor2 = {0x8, 0xF, 0xF, 0xF};
@@ -2479,9 +2684,9 @@ namespace tsl {
                 progress = ((std::sin(2.0 * M_PI * fmod(std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count(), 1.0)) + 1.0) / 2.0);
                 
                 highlightColor = {
-                    static_cast<u8>((highlightColor1.r - highlightColor2.r) * progress + highlightColor2.r),
-                    static_cast<u8>((highlightColor1.g - highlightColor2.g) * progress + highlightColor2.g),
-                    static_cast<u8>((highlightColor1.b - highlightColor2.b) * progress + highlightColor2.b),
+                    static_cast<u8>((theme.highlightColor1.r - theme.highlightColor2.r) * progress + theme.highlightColor2.r),
+                    static_cast<u8>((theme.highlightColor1.g - theme.highlightColor2.g) * progress + theme.highlightColor2.g),
+                    static_cast<u8>((theme.highlightColor1.b - theme.highlightColor2.b) * progress + theme.highlightColor2.b),
                     0xF
                 };
                 x = 0;
@@ -2515,7 +2720,7 @@ namespace tsl {
                         y = std::clamp(y, -amplitude, amplitude);
                     }
                 }
-                if ((disableSelectionBG && this->m_clickAnimationProgress == 0) || !disableSelectionBG) {
+                if ((theme.disableSelectionBG && this->m_clickAnimationProgress == 0) || !theme.disableSelectionBG) {
                     
                     renderer->drawRect(this->getX() + x + 5 -1, this->getY() + y - 4, this->getWidth() - 5 +2 +4, 5, highlightColor);
                     renderer->drawRect(this->getX() + x + 5 -1, this->getY() + y + this->getHeight(), this->getWidth() - 5 +2 +4, 5, highlightColor);
@@ -2779,29 +2984,8 @@ namespace tsl {
             std::string m_pageLeftName; // CUSTOM MODIFICATION
             std::string m_pageRightName; // CUSTOM MODIFICATION
             
-            std::string disableColorfulLogoStr = parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "disable_colorful_logo");
-            bool disableColorfulLogo = (!disableColorfulLogoStr.empty() && disableColorfulLogoStr == "true");
-            tsl::Color logoColor1 = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "logo_color_1"), "#FFFFFF");
-            tsl::Color logoColor2 = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "logo_color_2"), "#F7253E");
-            
-            
-            std::string backgroundAlphaStr = parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "bg_alpha");
-            size_t defaultBackgroundAlpha = (!backgroundAlphaStr.empty()) ? std::stoi(backgroundAlphaStr) : 13;
-            
-            tsl::Color defaultBackgroundColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "bg_color"), "#000000", defaultBackgroundAlpha);
-            
-            tsl::Color defaultTextColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "text_color"));
-            tsl::Color clockColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "clock_color"));
-            tsl::Color batteryColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "battery_color"));
             tsl::Color highlightColor = {0xF, 0xF, 0xF, 0xF};
             
-            tsl::Color versionTextColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "version_text_color"), "#AAAAAA");
-            tsl::Color onTextColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "on_text_color"), "#00FFDD");
-            tsl::Color offTextColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "off_text_color"), "#AAAAAA");
-            
-            std::tuple<float,float,float> dynamicLogoRGB1 = hexToRGB444Floats(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "dynamic_logo_color_1"), "#00E669");
-            std::tuple<float,float,float> dynamicLogoRGB2 = hexToRGB444Floats(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "dynamic_logo_color_2"), "#8080EA");
-            
             std::string firstHalf, secondHalf;
             //tsl::Color handColor = RGB888("#F7253E");
             tsl::Color titleColor = {0xF, 0xF, 0xF, 0xF};
@@ -2834,7 +3018,8 @@ namespace tsl {
             
             // CUSTOM SECTION START
             virtual void draw(gfx::Renderer *renderer) override {
-                renderer->fillScreen(defaultBackgroundColor);
+                const ThemeTable& theme = getThemeTable();
+                renderer->fillScreen(theme.defaultBackgroundColor);
                 //renderer->fillScreen(tsl::style::color::ColorFrameBackground);
                 //renderer->drawRect(tsl::cfg::FramebufferWidth - 1, 0, 1, tsl::cfg::FramebufferHeight, a(0xF222)); // CUSTOM MODIFICATION, not sure why this call was even necessary after comparisons.
                 
@@ -2855,7 +3040,7 @@ namespace tsl {
                     
                     countOffset = 0;
                     
-                    if (!disableColorfulLogo) {
+                    if (!theme.disableColorfulLogo) {
                         for (char letter : firstHalf) {
                             
                             // Calculate the progress for each letter based on the counter
@@ -2883,9 +3068,9 @@ namespace tsl {
                             progress = std::sin(counter); // -1 to 1
                             
                             highlightColor = {
-                                static_cast<u8>((std::get<0>(dynamicLogoRGB2) - std::get<0>(dynamicLogoRGB1)) * (progress + 1.) / 2. + std::get<0>(dynamicLogoRGB1)),
-                                static_cast<u8>((std::get<1>(dynamicLogoRGB2) - std::get<1>(dynamicLogoRGB1)) * (progress + 1.) / 2. + std::get<1>(dynamicLogoRGB1)),
-                                static_cast<u8>((std::get<2>(dynamicLogoRGB2) - std::get<2>(dynamicLogoRGB1)) * (progress + 1.) / 2. + std::get<2>(dynamicLogoRGB1)),
+                                static_cast<u8>((std::get<0>(theme.dynamicLogoRGB2) - std::get<0>(theme.dynamicLogoRGB1)) * (progress + 1.) / 2. + std::get<0>(theme.dynamicLogoRGB1)),
+                                static_cast<u8>((std::get<1>(theme.dynamicLogoRGB2) - std::get<1>(theme.dynamicLogoRGB1)) * (progress + 1.) / 2. + std::get<1>(theme.dynamicLogoRGB1)),
+                                static_cast<u8>((std::get<2>(theme.dynamicLogoRGB2) - std::get<2>(theme.dynamicLogoRGB1)) * (progress + 1.) / 2. + std::get<2>(theme.dynamicLogoRGB1)),
                                 15
                             };
                             
@@ -2916,7 +3101,7 @@ namespace tsl {
                         }
                     } else {
                         for (char letter : firstHalf) {
-                            renderer->drawString(std::string(1, letter).c_str(), false, x, y + offset, fontSize, logoColor1);
+                            renderer->drawString(std::string(1, letter).c_str(), false, x, y + offset, fontSize, theme.logoColor1);
                             
                             // Manually calculate the width of the current letter
                             letterWidth = calculateStringWidth(std::string(1, letter), fontSize);
@@ -2931,7 +3116,7 @@ namespace tsl {
                     
                     
                     // Draw the second half of the string in red color
-                    renderer->drawString(secondHalf.c_str(), false, x, y+offset, fontSize, logoColor2);
+                    renderer->drawString(secondHalf.c_str(), false, x, y+offset, fontSize, theme.logoColor2);
                     
                     
                     // Time drawing implementation
@@ -2951,7 +3136,7 @@ namespace tsl {
                         
                         localizeTimeStr(timeStr); // for language localizations
                         
-                        renderer->drawString(timeStr, false, tsl::cfg::FramebufferWidth - calculateStringWidth(timeStr, 20) - 20, y_offset, 20, clockColor);
+                        renderer->drawString(timeStr, false, tsl::cfg::FramebufferWidth - calculateStringWidth(timeStr, 20) - 20, y_offset, 20, theme.clockColor);
                         y_offset += 22;
                     }
                     
@@ -2995,7 +3180,7 @@ namespace tsl {
                             if (batteryCharge <= 20) {
                                 renderer->drawString(chargeStringSTD.c_str(), false, tsl::cfg::FramebufferWidth - calculateStringWidth(chargeStringSTD, 20) - 19, y_offset, 20, tsl::Color(0xF, 0x0, 0x0, 0xF));
                             } else {
-                                renderer->drawString(chargeStringSTD.c_str(), false, tsl::cfg::FramebufferWidth - calculateStringWidth(chargeStringSTD, 20) - 19, y_offset, 20, batteryColor);
+                                renderer->drawString(chargeStringSTD.c_str(), false, tsl::cfg::FramebufferWidth - calculateStringWidth(chargeStringSTD, 20) - 19, y_offset, 20, theme.batteryColor);
                             }
                         }
                     }
@@ -3094,17 +3279,17 @@ namespace tsl {
                     } else if (this->m_subtitle == "Ultrahand Script") {
                         renderer->drawString(this->m_title.c_str(), false, 20, 50, 32, Color(0xFF, 0x33, 0x3F, 0xFF));
                     } else {
-                        renderer->drawString(this->m_title.c_str(), false, 20, 50, 30, defaultTextColor);
+                        renderer->drawString(this->m_title.c_str(), false, 20, 50, 30, theme.defaultTextColor);
                     }
                 }
                 
                 
                 if (this->m_title == "Ultrahand") {
-                    renderer->drawString(versionLabel.c_str(), false, 20, y+25, 15, versionTextColor);
+                    renderer->drawString(versionLabel.c_str(), false, 20, y+25, 15, theme.versionTextColor);
                 } else
-                    renderer->drawString(this->m_subtitle.c_str(), false, 20, y+20, 15, versionTextColor);
+                    renderer->drawString(this->m_subtitle.c_str(), false, 20, y+20, 15, theme.versionTextColor);
                 
-                renderer->drawRect(15, tsl::cfg::FramebufferHeight - 73, tsl::cfg::FramebufferWidth - 30, 1, defaultTextColor);
+                renderer->drawRect(15, tsl::cfg::FramebufferHeight - 73, tsl::cfg::FramebufferWidth - 30, 1, theme.defaultTextColor);
                 
                 menuBottomLine = "\uE0E1"+GAP_2+BACK+GAP_1+"\uE0E0"+GAP_2+OK+GAP_1;
                 if (this->m_menuMode == "packages") {
@@ -3121,7 +3306,7 @@ namespace tsl {
                     menuBottomLine += "\uE0EE"+GAP_2 + this->m_pageRightName;
                 }
                 
-                renderer->drawString(menuBottomLine.c_str(), false, 30, 693, 23, defaultTextColor);
+                renderer->drawString(menuBottomLine.c_str(), false, 30, 693, 23, theme.defaultTextColor);
                 
                 if (this->m_contentElement != nullptr)
                     this->m_contentElement->frame(renderer);
@@ -3201,11 +3386,6 @@ namespace tsl {
          */
         class HeaderOverlayFrame : public Element {
         public:
-            std::string backgroundAlphaStr = parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "bg_alpha");
-            size_t defaultBackgroundAlpha = (!backgroundAlphaStr.empty()) ? std::stoi(backgroundAlphaStr) : 13;
-            tsl::Color defaultBackgroundColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "bg_color"), "#000000", defaultBackgroundAlpha);
-            
-            tsl::Color defaultTextColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "text_color"));
             
             HeaderOverlayFrame(u16 headerHeight = 175) : Element(), m_headerHeight(headerHeight) {}
             virtual ~HeaderOverlayFrame() {
@@ -3217,13 +3397,14 @@ namespace tsl {
             }
             
             virtual void draw(gfx::Renderer *renderer) override {
-                renderer->fillScreen(defaultBackgroundColor);
+                const ThemeTable& theme = getThemeTable();
+                renderer->fillScreen(theme.defaultBackgroundColor);
                 //renderer->fillScreen(tsl::style::color::ColorFrameBackground);
                 renderer->drawRect(tsl::cfg::FramebufferWidth - 1, 0, 1, tsl::cfg::FramebufferHeight, a(0xF222));
                 
-                renderer->drawRect(15, tsl::cfg::FramebufferHeight - 73, tsl::cfg::FramebufferWidth - 30, 1, defaultTextColor);
+                renderer->drawRect(15, tsl::cfg::FramebufferHeight - 73, tsl::cfg::FramebufferWidth - 30, 1, theme.defaultTextColor);
                 
-                renderer->drawString(("\uE0E1  "+BACK+"     \uE0E0  "+OK).c_str(), false, 30, 693, 23, defaultTextColor); // CUSTOM MODIFICATION
+                renderer->drawString(("\uE0E1  "+BACK+"     \uE0E0  "+OK).c_str(), false, 30, 693, 23, theme.defaultTextColor); // CUSTOM MODIFICATION
                 
                 if (this->m_header != nullptr)
                     this->m_header->frame(renderer);
@@ -3345,7 +3526,6 @@ namespace tsl {
                     delete item;
             }
             
-            Color trackBarColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "trackbar_color"), "#555555");
             float scrollbarHeight;
             float scrollbarOffset;
             int offset;
@@ -3355,6 +3535,7 @@ namespace tsl {
             u16 i;
             
             virtual void draw(gfx::Renderer *renderer) override {
+                const ThemeTable& theme = getThemeTable();
                 
                 
                 if (this->m_clearList) {
@@ -3414,12 +3595,12 @@ namespace tsl {
                     scrollbarOffset = (static_cast<float>(this->m_offset)) / static_cast<float>(this->m_listHeight - this->getHeight()) * static_cast<float>(this->getHeight() - std::ceil(scrollbarHeight + 50));
                     
                     offset = 11;
-                    renderer->drawRect(this->getRightBound() + 10+offset, this->getY() + scrollbarOffset, 5, scrollbarHeight, trackBarColor);
-                    renderer->drawCircle(this->getRightBound() + 12+offset, this->getY() + scrollbarOffset, 2, true, trackBarColor);
-                    renderer->drawCircle(this->getRightBound() + 12+offset, ( this->getY() + scrollbarOffset + (this->getY() + scrollbarOffset + this->getY() + scrollbarOffset + scrollbarHeight)/2)/2, 2, true, trackBarColor);
-                    renderer->drawCircle(this->getRightBound() + 12+offset, (this->getY() + scrollbarOffset + this->getY() + scrollbarOffset + scrollbarHeight)/2, 2, true, trackBarColor);
-                    renderer->drawCircle(this->getRightBound() + 12+offset, (this->getY() + scrollbarOffset + scrollbarHeight + (this->getY() + scrollbarOffset + this->getY() + scrollbarOffset + scrollbarHeight)/2)/2, 2, true, trackBarColor);
-                    renderer->drawCircle(this->getRightBound() + 12+offset, this->getY() + scrollbarOffset + scrollbarHeight, 2, true, trackBarColor);
+                    renderer->drawRect(this->getRightBound() + 10+offset, this->getY() + scrollbarOffset, 5, scrollbarHeight, theme.trackBarColor);
+                    renderer->drawCircle(this->getRightBound() + 12+offset, this->getY() + scrollbarOffset, 2, true, theme.trackBarColor);
+                    renderer->drawCircle(this->getRightBound() + 12+offset, ( this->getY() + scrollbarOffset + (this->getY() + scrollbarOffset + this->getY() + scrollbarOffset + scrollbarHeight)/2)/2, 2, true, theme.trackBarColor);
+                    renderer->drawCircle(this->getRightBound() + 12+offset, (this->getY() + scrollbarOffset + this->getY() + scrollbarOffset + scrollbarHeight)/2, 2, true, theme.trackBarColor);
+                    renderer->drawCircle(this->getRightBound() + 12+offset, (this->getY() + scrollbarOffset + scrollbarHeight + (this->getY() + scrollbarOffset + this->getY() + scrollbarOffset + scrollbarHeight)/2)/2, 2, true, theme.trackBarColor);
+                    renderer->drawCircle(this->getRightBound() + 12+offset, this->getY() + scrollbarOffset + scrollbarHeight, 2, true, theme.trackBarColor);
                     
                     prevOffset = this->m_offset;
                     
@@ -3673,21 +3854,7 @@ namespace tsl {
          */
         class ListItem : public Element {
         public:
-            std::string seperatorAlphaStr = parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "seperator_alpha");
-            size_t seperatorAlpha = (!seperatorAlphaStr.empty()) ? std::stoi(seperatorAlphaStr) : 7;
             
-            tsl::Color seperatorColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "seperator_color"), "#777777", seperatorAlpha);
-            
-            tsl::Color defaultTextColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "text_color")); ; // CUSTOM MODIFICATION
-            tsl::Color selectedTextColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "selection_text_color"));
-            
-            tsl::Color invalidTextColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "invalid_text_color"), "#FF0000");
-            tsl::Color onTextColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "on_text_color"), "#00FFDD");
-            tsl::Color offTextColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "off_text_color"), "#AAAAAA");
-            
-            tsl::Color clickTextColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "click_text_color"));
-            tsl::Color clickColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "click_color"));
-
             std::chrono::system_clock::time_point timeIn;// = std::chrono::system_clock::now();
             std::chrono::duration<long int, std::ratio<1, 1000000000>> t;
             u32 width, height;
@@ -3703,10 +3870,11 @@ namespace tsl {
             virtual ~ListItem() {}
             
             virtual void draw(gfx::Renderer *renderer) override {
+                const ThemeTable& theme = getThemeTable();
                 bool useClickTextColor = false;
                 if (this->m_touched && Element::getInputMode() == InputMode::Touch) {
                     if (touchInBounds) {
-                        renderer->drawRect(ELEMENT_BOUNDS(this), clickColor);
+                        renderer->drawRect(ELEMENT_BOUNDS(this), theme.clickColor);
                         useClickTextColor = true;
                     }
                     //renderer->drawRect(ELEMENT_BOUNDS(this), tsl::style::color::ColorClickAnimation);
@@ -3742,14 +3910,14 @@ namespace tsl {
                 //renderer->drawRect(this->getX()+4, this->getTopBound(), this->getWidth()-4, 1, a(0x0000));
                 
                 //renderer->drawRect(this->getX()+5, this->getTopBound(), this->getWidth()-5+10, 1, tsl::style::color::ColorFrame);
-                renderer->drawRect(this->getX()+5, this->getTopBound(), this->getWidth()-5+10, 1, seperatorColor);
+                renderer->drawRect(this->getX()+5, this->getTopBound(), this->getWidth()-5+10, 1, theme.seperatorColor);
                 
                 if (this->m_trunctuated) {
                     if (this->m_focused) {
                         renderer->enableScissoring(this->getX()+7, 97, this->m_maxWidth + 40 - 10+2+4, tsl::cfg::FramebufferHeight-73-97);
                         //renderer->enableScissoring(this->getX(), this->getY(), this->m_maxWidth + 40, this->getHeight());
                         //renderer->drawString(this->m_scrollText.c_str(), false, this->getX() + 20.0 - std::round(this->m_scrollOffset*10000.0)/10000.0, this->getY() + 45, 23, defaultTextColor);
-                        renderer->drawString(this->m_scrollText.c_str(), false, this->getX() + 20.0 - this->m_scrollOffset, this->getY() + 45, 23, selectedTextColor);
+                        renderer->drawString(this->m_scrollText.c_str(), false, this->getX() + 20.0 - this->m_scrollOffset, this->getY() + 45, 23, theme.selectedTextColor);
                         renderer->disableScissoring();
                         t = std::chrono::system_clock::now() - this->timeIn;
                         if (t >= 2000ms) {
@@ -3765,13 +3933,13 @@ namespace tsl {
                             }
                         } // CUSTOM MODIFICATION END
                     } else {
-                        renderer->drawString(this->m_ellipsisText.c_str(), false, this->getX() + 20, this->getY() + 45, 23, !useClickTextColor ? defaultTextColor : clickTextColor);
+                        renderer->drawString(this->m_ellipsisText.c_str(), false, this->getX() + 20, this->getY() + 45, 23, !useClickTextColor ? theme.defaultTextColor : theme.clickTextColor);
                     }
                 } else {
                     if (this->m_focused) {
-                        renderer->drawString(this->m_text.c_str(), false, this->getX() + 20, this->getY() + 45, 23, !useClickTextColor ? selectedTextColor : clickTextColor);
+                        renderer->drawString(this->m_text.c_str(), false, this->getX() + 20, this->getY() + 45, 23, !useClickTextColor ? theme.selectedTextColor : theme.clickTextColor);
                     } else {
-                        renderer->drawString(this->m_text.c_str(), false, this->getX() + 20, this->getY() + 45, 23, !useClickTextColor ? defaultTextColor : clickTextColor);
+                        renderer->drawString(this->m_text.c_str(), false, this->getX() + 20, this->getY() + 45, 23, !useClickTextColor ? theme.defaultTextColor : theme.clickTextColor);
                     }
                 }
                 
@@ -3779,13 +3947,13 @@ namespace tsl {
                 // CUSTOM SECTION START (modification for submenu footer color)
                 if (this->m_value == DROPDOWN_SYMBOL || this->m_value == OPTION_SYMBOL) {
                     if (this->m_focused)
-                        renderer->drawString(this->m_value.c_str(), false, this->getX() + this->m_maxWidth + 45 + 10 +4, this->getY() + 45, 20, !useClickTextColor ? (this->m_faint ? offTextColor : selectedTextColor) : clickTextColor);
+                        renderer->drawString(this->m_value.c_str(), false, this->getX() + this->m_maxWidth + 45 + 10 +4, this->getY() + 45, 20, !useClickTextColor ? (this->m_faint ? theme.offTextColor : theme.selectedTextColor) : theme.clickTextColor);
                     else
-                        renderer->drawString(this->m_value.c_str(), false, this->getX() + this->m_maxWidth + 45 + 10 +4, this->getY() + 45, 20, !useClickTextColor ? (this->m_faint ? offTextColor : defaultTextColor) : clickTextColor);
+                        renderer->drawString(this->m_value.c_str(), false, this->getX() + this->m_maxWidth + 45 + 10 +4, this->getY() + 45, 20, !useClickTextColor ? (this->m_faint ? theme.offTextColor : theme.defaultTextColor) : theme.clickTextColor);
                 } else if (this->m_value == CROSSMARK_SYMBOL) {
-                    renderer->drawString(this->m_value.c_str(), false, this->getX() + this->m_maxWidth + 45 + 10 +4, this->getY() + 45, 20, !useClickTextColor ? (this->m_faint ? offTextColor : invalidTextColor) : clickTextColor);
+                    renderer->drawString(this->m_value.c_str(), false, this->getX() + this->m_maxWidth + 45 + 10 +4, this->getY() + 45, 20, !useClickTextColor ? (this->m_faint ? theme.offTextColor : theme.invalidTextColor) : theme.clickTextColor);
                 } else {
-                    renderer->drawString(this->m_value.c_str(), false, this->getX() + this->m_maxWidth + 45 + 10 +4, this->getY() + 45, 20, !useClickTextColor ? (this->m_faint ? offTextColor : onTextColor) : clickTextColor);
+                    renderer->drawString(this->m_value.c_str(), false, this->getX() + this->m_maxWidth + 45 + 10 +4, this->getY() + 45, 20, !useClickTextColor ? (this->m_faint ? theme.offTextColor : theme.onTextColor) : theme.clickTextColor);
                 }
                 // CUSTOM SECTION END 
             }
@@ -3972,14 +4140,14 @@ namespace tsl {
         
         class CategoryHeader : public Element {
         public:
-            tsl::Color defaultTextColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "text_color"));
             
             CategoryHeader(const std::string &title, bool hasSeparator = false) : m_text(title), m_hasSeparator(hasSeparator) {}
             virtual ~CategoryHeader() {}
             
             virtual void draw(gfx::Renderer *renderer) override {
-                renderer->drawRect(this->getX() - 2, this->getBottomBound() - 30, 5, 23, defaultTextColor);
-                renderer->drawString(this->m_text.c_str(), false, this->getX() + 13, this->getBottomBound() - 12, 15, defaultTextColor);
+                const ThemeTable& theme = getThemeTable();
+                renderer->drawRect(this->getX() - 2, this->getBottomBound() - 30, 5, 23, theme.defaultTextColor);
+                renderer->drawString(this->m_text.c_str(), false, this->getX() + 13, this->getBottomBound() - 12, 15, theme.defaultTextColor);
                 
                 //if (this->m_hasSeparator)
                 //    renderer->drawRect(this->getX(), this->getBottomBound(), this->getWidth(), 1, tsl::style::color::ColorFrame); // CUSTOM MODIFICATION
@@ -4027,8 +4195,6 @@ namespace tsl {
          */
         class TrackBar : public Element {
         public:
-            Color defaultTextColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "text_color"));
-            Color trackBarColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "trackbar_color"), "#555555");
             std::chrono::duration<long int, std::ratio<1, 1000000000>> t;
             Color highlightColor = {0xf,0xf,0xf,0xf};
             //alf progress;
@@ -4105,10 +4271,11 @@ namespace tsl {
             }
             
             virtual void draw(gfx::Renderer *renderer) override {
+                const ThemeTable& theme = getThemeTable();
                 //renderer->drawRect(this->getX(), this->getY(), this->getWidth(), 1, tsl::style::color::ColorFrame);
                 //renderer->drawRect(this->getX(), this->getBottomBound(), this->getWidth(), 1, tsl::style::color::ColorFrame);
                 
-                renderer->drawString(this->m_icon, false, this->getX() + 15, this->getY() + 50, 23, defaultTextColor);
+                renderer->drawString(this->m_icon, false, this->getX() + 15, this->getY() + 50, 23, theme.defaultTextColor);
                 
                 //u16 handlePos = (this->getWidth() - 95) * static_cast<half>(this->m_value) / 100;
                 u16 handlePos = (this->getWidth() - 95) * (this->m_value) / 100;
@@ -4117,7 +4284,7 @@ namespace tsl {
                 //renderer->drawRect(this->getX() + 60 + handlePos, this->getY() + 40, this->getWidth() - 95 - handlePos, 5, tsl::style::color::ColorFrame);
                 renderer->drawRect(this->getX() + 60, this->getY() + 40, handlePos, 5, tsl::style::color::ColorHighlight);
                 
-                renderer->drawCircle(this->getX() + 62 + handlePos, this->getY() + 42, 18, true, trackBarColor);
+                renderer->drawCircle(this->getX() + 62 + handlePos, this->getY() + 42, 18, true, theme.trackBarColor);
                 renderer->drawCircle(this->getX() + 62 + handlePos, this->getY() + 42, 18, false, tsl::style::color::ColorFrame);
             }
             
@@ -4321,8 +4488,6 @@ namespace tsl {
             u16 trackBarWidth, stepWidth, currentDescIndex;
             u32 descWidth, descHeight;
             
-            tsl::Color offTextColor = RGB888(parseValueFromIniSection("/config/ultrahand/theme.ini", "theme", "off_text_color"), "#AAAAAA");
-            
             /**
              * @brief Constructor
              *
@@ -4335,6 +4500,7 @@ namespace tsl {
             virtual ~NamedStepTrackBar() {}
             
             virtual void draw(gfx::Renderer *renderer) override {
+                const ThemeTable& theme = getThemeTable();
                 
                 trackBarWidth = this->getWidth() - 95;
                 stepWidth = trackBarWidth / (this->m_numSteps - 1);
@@ -4346,7 +4512,7 @@ namespace tsl {
                 currentDescIndex = std::clamp(this->m_value / (100 / (this->m_numSteps - 1)), 0, this->m_numSteps - 1);
                 
                 std::tie(descWidth, descHeight) = renderer->drawString(this->m_stepDescriptions[currentDescIndex].c_str(), false, 0, 0, 15, tsl::style::color::ColorTransparent);
-                renderer->drawString(this->m_stepDescriptions[currentDescIndex].c_str(), false, ((this->getX() + 60) + (this->getWidth() - 95) / 2) - (descWidth / 2), this->getY() + 20, 15, offTextColor);
+                renderer->drawString(this->m_stepDescriptions[currentDescIndex].c_str(), false, ((this->getX() + 60) + (this->getWidth() - 95) / 2) - (descWidth / 2), this->getY() + 20, 15, theme.offTextColor);
                 
                 StepTrackBar::draw(renderer);
             }
@@ -4743,12 +4909,15 @@ namespace tsl {
             auto& renderer = gfx::Renderer::get();
             
             renderer.startFrame();
+            themeFrameInProgress.store(true, std::memory_order_release); // CUSTOM MODIFICATION
             
             this->animationLoop();
             this->getCurrentGui()->update();
             this->getCurrentGui()->draw(&renderer);
             
+            themeFrameInProgress.store(false, std::memory_order_release); // CUSTOM MODIFICATION
             renderer.endFrame();
+            applyDeferredThemeTableReload(); // CUSTOM MODIFICATION
         }
         
 
@@ -5414,7 +5583,8 @@ namespace tsl {
         bool inOverlay = false;
         if (inOverlayString == "true") {
             inOverlay = true;
-            setIniFileValue(settingsConfigPath, "ultrahand", "in_overlay", "false");
+            queueIniFileValue(settingsConfigPath, "ultrahand", "in_overlay", "false");
+            flushPendingIniWrites(settingsConfigPath); // A crash before the next flush would relaunch into the overlay
         }
         
         if (inOverlay && skipCombo) {
@@ -5455,15 +5625,19 @@ namespace tsl {
                     shData.running = false;
                 
                 if (updateMenuCombos) { // CUSTOM MODIFICATION
-                    setIniFileValue(settingsConfigPath, "ultrahand", "key_combo", "L+DDOWN+RS");
-                    setIniFileValue(teslaSettingsConfigIniPath, "tesla", "key_combo", "L+DDOWN+RS");
+                    queueIniFileValue(settingsConfigPath, "ultrahand", "key_combo", "L+DDOWN+RS");
+                    queueIniFileValue(teslaSettingsConfigIniPath, "tesla", "key_combo", "L+DDOWN+RS");
                     updateMenuCombos = false;
                 }
+                
+                flushDueIniWrites(); // CUSTOM MODIFICATION
             }
             
             overlay->clearScreen();
             overlay->resetFlags();
             
+            flushPendingIniWrites(); // CUSTOM MODIFICATION
+            
             hlp::requestForeground(false);
             
             shData.overlayOpen = false;
@@ -5475,6 +5649,8 @@ namespace tsl {
         threadWaitForExit(&backgroundThread);
         threadClose(&backgroundThread);
         
+        flushPendingIniWrites(); // CUSTOM MODIFICATION
+        
         overlay->exitScreen();
         overlay->exitServices();
         
@@ -0,0 +1,197 @@
+/********************************************************************************
+ * File: binary_reader.hpp
+ * Author: ppkantorski
+ * Description:
+ *   This header file provides the sequential binary read path used by the hex
+ *   scanning functions. Files are streamed through one large aligned buffer, or
+ *   memory mapped when built for a Linux host, and handed to callbacks in
+ *   overlapping chunks without further copies.
+ *
+ *   Every reader records the bytes it read and the time spent reading, so the
+ *   buffer size can be tuned against the overlay heap budget.
+ *
+ *   For the latest updates and contributions, visit the project's GitHub repository.
+ *   (GitHub Repository: https://github.com/ppkantorski/Ultrahand-Overlay)
+ *
+ *   Note: Please be aware that this notice cannot be altered or removed. It is a part
+ *   of the project's documentation and must remain intact.
+ *
+ *  Licensed under both GPLv2 and CC-BY-4.0
+ *  Copyright (c) 2024 ppkantorski
+ ********************************************************************************/
+
+#pragma once
+#include <cstdio>   // For FILE*, fread(), etc.
+#include <cstdint>  // For uint64_t
+#include <cstdlib>  // For std::aligned_alloc, std::free
+#include <cstring>  // For std::memmove
+#include <chrono>   // For timing reads
+#include <algorithm>
+
+#if defined(__linux__) && !defined(__SWITCH__)
+#define BINARY_READER_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+constexpr size_t binaryReaderAlignment = 4096;
+constexpr size_t binaryReaderMinBufferSize = 65536;
+constexpr size_t binaryReaderMaxBufferSize = 1048576;
+
+// Size of the read buffer, kept small enough for the overlay heap
+inline size_t binaryReaderBufferSize = 262144;
+
+/**
+ * @brief Sets the read buffer size of new readers, clamped to 64 KB - 1 MB and rounded to the alignment.
+ */
+inline void setBinaryReaderBufferSize(size_t bufferSize) {
+    bufferSize = std::clamp(bufferSize, binaryReaderMinBufferSize, binaryReaderMaxBufferSize);
+    binaryReaderBufferSize = (bufferSize + binaryReaderAlignment - 1) / binaryReaderAlignment * binaryReaderAlignment;
+}
+
+/**
+ * @brief Bytes read and time spent reading by binary readers.
+ */
+struct BinaryReadStats {
+    uint64_t bytesRead = 0;
+    uint64_t readCalls = 0;    // freads, or 1 per mapping
+    uint64_t elapsedUs = 0;    // Time spent in reads, excluding the callbacks (only the mapping itself when mapped)
+    
+    void add(const BinaryReadStats& other) {
+        bytesRead += other.bytesRead;
+        readCalls += other.readCalls;
+        elapsedUs += other.elapsedUs;
+    }
+};
+
+// Totals of all readers since the last resetBinaryReadStats()
+inline BinaryReadStats binaryReadTotals;
+
+inline const BinaryReadStats& getBinaryReadStats() {
+    return binaryReadTotals;
+}
+
+inline void resetBinaryReadStats() {
+    binaryReadTotals = BinaryReadStats();
+}
+
+/**
+ * @brief Streams an open file in overlapping chunks.
+ *
+ * Every chunk after the first starts with the last `overlap` bytes of the one before, so a
+ * pattern up to overlap + 1 bytes long that crosses a chunk boundary is seen whole in one chunk.
+ * In buffered mode, reads land on an aligned buffer and only the overlap is moved between chunks.
+ * With BINARY_READER_MMAP the whole file is mapped and handed over as a single chunk.
+ */
+class BinaryReader {
+public:
+    explicit BinaryReader(FILE* file, size_t bufferSize = binaryReaderBufferSize) : file(file),
+        bufferSize((std::max<size_t>(bufferSize, 1) + binaryReaderAlignment - 1) / binaryReaderAlignment * binaryReaderAlignment) {}
+    
+    ~BinaryReader() {
+        binaryReadTotals.add(stats);
+    }
+    
+    BinaryReader(const BinaryReader&) = delete;
+    BinaryReader& operator=(const BinaryReader&) = delete;
+    
+    const BinaryReadStats& getStats() const {
+        return stats;
+    }
+    
+    /**
+     * @brief Reads the file once from its current position.
+     *
+     * The file position is unspecified afterwards.
+     *
+     * @param overlap The number of bytes each chunk repeats from the end of the previous one.
+     * @param onChunk Called as onChunk(data, size, offset, isLast), with offset counted from the
+     *                position the read started at. The data is only valid during the call.
+     *                Returns false to stop. The last chunk may consist of the overlap only.
+     * @return True if onChunk stopped the read, false otherwise.
+     */
+    template <typename ChunkHandler>
+    bool forEachChunk(size_t overlap, ChunkHandler&& onChunk) {
+        if (!file)
+            return false;
+        
+        bool stopped = false;
+#ifdef BINARY_READER_MMAP
+        if (forEachMappedChunk(onChunk, stopped))
+            return stopped;
+#endif
+        
+        // The overlap is kept in front of the aligned read area
+        const size_t headRoom = (overlap + binaryReaderAlignment - 1) / binaryReaderAlignment * binaryReaderAlignment;
+        unsigned char* buffer = static_cast<unsigned char*>(std::aligned_alloc(binaryReaderAlignment, headRoom + bufferSize));
+        if (!buffer)
+            return false;
+        unsigned char* readArea = buffer + headRoom;
+        
+        uint64_t chunkOffset = 0; // File offset of the chunk start
+        size_t carry = 0, bytesRead, keep;
+        bool isLast = false;
+        
+        while (!isLast && !stopped) {
+            const auto start = std::chrono::steady_clock::now();
+            bytesRead = fread(readArea, 1, bufferSize, file);
+            stats.elapsedUs += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            stats.bytesRead += bytesRead;
+            ++stats.readCalls;
+            
+            isLast = (bytesRead < bufferSize);
+            if (bytesRead == 0 && carry == 0)
+                break;
+            
+            stopped = !onChunk(static_cast<const unsigned char*>(readArea - carry), carry + bytesRead, chunkOffset, isLast);
+            
+            // Keep the tail for the next chunk
+            keep = std::min(carry + bytesRead, overlap);
+            std::memmove(readArea - keep, readArea + bytesRead - keep, keep);
+            chunkOffset += carry + bytesRead - keep;
+            carry = keep;
+        }
+        
+        std::free(buffer);
+        return stopped;
+    }
+
+private:
+#ifdef BINARY_READER_MMAP
+    /**
+     * @brief Maps the rest of a regular file and hands it over as one chunk.
+     *
+     * @return False if the file cannot be mapped and must be read through the buffer.
+     */
+    template <typename ChunkHandler>
+    bool forEachMappedChunk(ChunkHandler& onChunk, bool& stopped) {
+        fflush(file); // Make pending writes of an update stream visible in the mapping
+        
+        struct stat fileStat;
+        const long position = ftell(file);
+        const int descriptor = fileno(file);
+        if (position < 0 || descriptor < 0 || fstat(descriptor, &fileStat) != 0 || !S_ISREG(fileStat.st_mode) ||
+            fileStat.st_size <= position)
+            return false;
+        
+        const auto start = std::chrono::steady_clock::now();
+        void* mapping = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (mapping == MAP_FAILED)
+            return false;
+        madvise(mapping, static_cast<size_t>(fileStat.st_size), MADV_SEQUENTIAL);
+        stats.elapsedUs += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        stats.bytesRead += static_cast<uint64_t>(fileStat.st_size - position);
+        ++stats.readCalls;
+        
+        stopped = !onChunk(static_cast<const unsigned char*>(mapping) + position, static_cast<size_t>(fileStat.st_size - position), uint64_t(0), true);
+        munmap(mapping, static_cast<size_t>(fileStat.st_size));
+        fseek(file, 0, SEEK_END);
+        return true;
+    }
+#endif
+
+    FILE* file;
+    size_t bufferSize;
+    BinaryReadStats stats;
+};
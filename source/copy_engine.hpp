@@ -0,0 +1,376 @@
+/********************************************************************************
+ * File: copy_engine.hpp
+ * Author: ppkantorski
+ * Description:
+ *   This header file provides the pipelined file copy used by the copy and
+ *   mirror functions. The calling thread reads source files into large aligned
+ *   buffers while a writer thread writes the previous ones, so reads and
+ *   writes of the SD card overlap instead of taking turns.
+ *
+ *   Every pipeline records the bytes and files it copied, so the buffer size
+ *   can be tuned against the overlay heap budget.
+ *
+ *   For the latest updates and contributions, visit the project's GitHub repository.
+ *   (GitHub Repository: https://github.com/ppkantorski/Ultrahand-Overlay)
+ *
+ *   Note: Please be aware that this notice cannot be altered or removed. It is a part
+ *   of the project's documentation and must remain intact.
+ *
+ *  Licensed under both GPLv2 and CC-BY-4.0
+ *  Copyright (c) 2024 ppkantorski
+ ********************************************************************************/
+
+#pragma once
+#include <cstdio>   // For FILE*, fread(), fwrite(), etc.
+#include <cstdint>  // For uint64_t
+#include <cstdlib>  // For std::aligned_alloc, std::free
+#include <chrono>   // For timing copies
+#include <string>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <system_error>
+#include <algorithm>
+#include <sys/stat.h>
+#include <unistd.h> // For ftruncate()
+#include <get_funcs.hpp>
+
+
+constexpr size_t copyBufferAlignment = 4096;
+constexpr size_t copyMinBufferSize = 65536;
+constexpr size_t copyMaxBufferSize = 4194304;
+
+// Size of each of the buffers handed from the reader to the writer, kept small enough for the overlay heap
+inline size_t copyBufferSize = 524288;
+
+// Number of buffers, two lets one be read while the other is written
+inline size_t copyBufferCount = 2;
+
+/**
+ * @brief Sets the buffer size of new copy pipelines, clamped to 64 KB - 4 MB and rounded to the alignment.
+ */
+inline void setCopyBufferSize(size_t bufferSize) {
+    bufferSize = std::clamp(bufferSize, copyMinBufferSize, copyMaxBufferSize);
+    copyBufferSize = (bufferSize + copyBufferAlignment - 1) / copyBufferAlignment * copyBufferAlignment;
+}
+
+/**
+ * @brief Bytes and files copied, and the time spent copying.
+ */
+struct CopyStats {
+    uint64_t bytesCopied = 0;
+    uint64_t filesCopied = 0;
+    uint64_t filesFailed = 0;
+    uint64_t elapsedUs = 0;    // Lifetime of the pipelines, from the first read to the last write
+    
+    void add(const CopyStats& other) {
+        bytesCopied += other.bytesCopied;
+        filesCopied += other.filesCopied;
+        filesFailed += other.filesFailed;
+        elapsedUs += other.elapsedUs;
+    }
+};
+
+// Totals of all pipelines since the last resetCopyStats()
+inline CopyStats copyTotals;
+
+inline const CopyStats& getCopyStats() {
+    return copyTotals;
+}
+
+inline void resetCopyStats() {
+    copyTotals = CopyStats();
+}
+
+/**
+ * @brief Copies files with reads and writes overlapping.
+ *
+ * Usage:
+ *     CopyPipeline pipeline;
+ *     pipeline.copyFile(fromFile, toFile); // Any number of files
+ *     pipeline.finish();
+ *
+ * copyFile() reads on the calling thread and queues the filled buffers for a writer thread,
+ * waiting only when all buffers are in use. Files of a directory copy share the pipeline, so
+ * the reads of one file overlap the writes of the previous one. The writer thread is started
+ * with the first file that spans several buffers, or with the second file, so copying a single
+ * small file costs no thread. Destination files are sized up front and replaced if they exist.
+ */
+class CopyPipeline {
+public:
+    /**
+     * The buffers are allocated with the first file, so an unused pipeline costs no memory.
+     */
+    explicit CopyPipeline(size_t bufferSize = copyBufferSize, size_t bufferCount = copyBufferCount) :
+        bufferSize((std::max<size_t>(bufferSize, 1) + copyBufferAlignment - 1) / copyBufferAlignment * copyBufferAlignment),
+        bufferCount(std::max<size_t>(bufferCount, 1)) {}
+    
+    ~CopyPipeline() {
+        finish();
+        if (writerStarted) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            chunkQueued.notify_one();
+            writer.join();
+        }
+        for (unsigned char* buffer : buffers)
+            std::free(buffer);
+        
+        if (!buffers.empty())
+            stats.elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        copyTotals.add(stats);
+    }
+    
+    CopyPipeline(const CopyPipeline&) = delete;
+    CopyPipeline& operator=(const CopyPipeline&) = delete;
+    
+    /**
+     * @brief Reads a file and queues it to be written to its destination.
+     *
+     * The destination directory must exist. Write errors are reported by finish().
+     *
+     * @param fromFile The path of the source file.
+     * @param toFile The path of the destination file.
+     * @return False if the source could not be opened or a read failed part-way through.
+     */
+    bool copyFile(const std::string& fromFile, const std::string& toFile) {
+        if (fromFile == toFile)
+            return true;
+        
+        if (buffers.empty())
+            allocateBuffers();
+        if (buffers.empty()) {
+            logMessage("Failed to allocate a buffer to copy " + fromFile + ".");
+            failed = true;
+            return false;
+        }
+        
+        FILE* sourceFile = fopen(fromFile.c_str(), "rb");
+        if (!sourceFile) {
+            logMessage("Failed to open " + fromFile + ".");
+            failed = true;
+            return false;
+        }
+        setvbuf(sourceFile, nullptr, _IONBF, 0); // Reads go straight into the pipeline buffers
+        
+        struct stat sourceStat;
+        const uint64_t fileSize = (fstat(fileno(sourceFile), &sourceStat) == 0) ? static_cast<uint64_t>(sourceStat.st_size) : 0;
+        
+        if (filesSubmitted > 0 || fileSize >= bufferSize)
+            startWriter();
+        ++filesSubmitted;
+        
+        uint64_t totalRead = 0;
+        bool isFirst = true, isLast = false, readFailed = false;
+        
+        while (!isLast) {
+            Chunk chunk{acquireBuffer(), 0, fileSize, isFirst ? toFile : std::string(), isFirst, false, false};
+            chunk.size = fread(chunk.data, 1, bufferSize, sourceFile);
+            totalRead += chunk.size;
+            
+            readFailed = chunk.readFailed = (ferror(sourceFile) != 0);
+            isLast = readFailed || chunk.size < bufferSize || totalRead == fileSize;
+            chunk.isLast = isLast;
+            isFirst = false;
+            
+            submitChunk(std::move(chunk));
+        }
+        
+        fclose(sourceFile);
+        return !readFailed;
+    }
+    
+    /**
+     * @brief Waits until all queued files are written.
+     *
+     * @return False if any copy of this pipeline failed.
+     */
+    bool finish() {
+        if (writerStarted) {
+            std::unique_lock<std::mutex> lock(mutex);
+            bufferFreed.wait(lock, [this] { return pendingChunks.empty() && freeBuffers.size() == buffers.size(); });
+        }
+        return !failed;
+    }
+    
+    /**
+     * @brief The bytes and files copied so far, complete after finish().
+     */
+    const CopyStats& getStats() const {
+        return stats;
+    }
+
+private:
+    /**
+     * @brief A filled buffer, the first one of a file carrying its destination.
+     */
+    struct Chunk {
+        unsigned char* data;
+        size_t size;
+        uint64_t fileSize;
+        std::string destinationPath;
+        bool isFirst;
+        bool isLast;
+        bool readFailed;
+    };
+    
+    void allocateBuffers() {
+        start = std::chrono::steady_clock::now();
+        
+        // Fall back to smaller buffers when the heap is short
+        while (buffers.size() < bufferCount) {
+            unsigned char* buffer = static_cast<unsigned char*>(std::aligned_alloc(copyBufferAlignment, bufferSize));
+            if (buffer) {
+                buffers.push_back(buffer);
+                continue;
+            }
+            if (!buffers.empty() || bufferSize <= copyMinBufferSize)
+                break;
+            bufferSize /= 2;
+        }
+        freeBuffers = buffers;
+    }
+    
+    void startWriter() {
+        if (writerStarted || writerUnavailable || buffers.size() < 2)
+            return;
+        
+        try {
+            writer = std::thread(&CopyPipeline::writerLoop, this);
+            writerStarted = true;
+        } catch (const std::system_error&) {
+            logMessage("Failed to start the copy writer thread, copying synchronously.");
+            writerUnavailable = true;
+        }
+    }
+    
+    unsigned char* acquireBuffer() {
+        std::unique_lock<std::mutex> lock(mutex);
+        bufferFreed.wait(lock, [this] { return !freeBuffers.empty(); });
+        unsigned char* buffer = freeBuffers.back();
+        freeBuffers.pop_back();
+        return buffer;
+    }
+    
+    void submitChunk(Chunk&& chunk) {
+        if (!writerStarted) {
+            writeChunk(chunk);
+            std::lock_guard<std::mutex> lock(mutex);
+            freeBuffers.push_back(chunk.data);
+            return;
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pendingChunks.push_back(std::move(chunk));
+        }
+        chunkQueued.notify_one();
+    }
+    
+    void writerLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            chunkQueued.wait(lock, [this] { return stopping || !pendingChunks.empty(); });
+            if (pendingChunks.empty())
+                return;
+            
+            Chunk chunk = std::move(pendingChunks.front());
+            pendingChunks.pop_front();
+            
+            lock.unlock();
+            writeChunk(chunk);
+            lock.lock();
+            
+            freeBuffers.push_back(chunk.data);
+            bufferFreed.notify_one();
+        }
+    }
+    
+    /**
+     * @brief Writes a chunk to the current destination file, opening or closing it as needed.
+     */
+    void writeChunk(Chunk& chunk) {
+        if (chunk.isFirst) {
+            destinationPath = std::move(chunk.destinationPath);
+            destinationFile = fopen(destinationPath.c_str(), "wb");
+            destinationFailed = !destinationFile;
+            bytesWritten = 0;
+            
+            if (destinationFile) {
+                setvbuf(destinationFile, nullptr, _IONBF, 0);
+                
+                // Sizing the file once spares the file system from growing it with every write
+                if (chunk.fileSize > 0)
+                    ftruncate(fileno(destinationFile), static_cast<off_t>(chunk.fileSize));
+            } else {
+                logMessage("Failed to open " + destinationPath + " for writing.");
+            }
+        }
+        
+        if (destinationFile && chunk.size > 0) {
+            if (fwrite(chunk.data, 1, chunk.size, destinationFile) == chunk.size)
+                bytesWritten += chunk.size;
+            else
+                destinationFailed = true;
+        }
+        
+        if (!chunk.isLast)
+            return;
+        
+        if (destinationFile) {
+            // The source may have been shorter than its size said
+            if (bytesWritten != chunk.fileSize && !destinationFailed) {
+                fflush(destinationFile);
+                ftruncate(fileno(destinationFile), static_cast<off_t>(bytesWritten));
+            }
+            destinationFailed = (fclose(destinationFile) != 0) || destinationFailed || chunk.readFailed;
+            destinationFile = nullptr;
+            
+            if (destinationFailed) {
+                logMessage("Failed to copy to " + destinationPath + ".");
+                remove(destinationPath.c_str());
+            }
+        }
+        
+        if (destinationFailed) {
+            ++stats.filesFailed;
+            failed = true;
+        } else {
+            stats.bytesCopied += bytesWritten;
+            ++stats.filesCopied;
+        }
+        invalidateDirectoryListing(destinationPath);
+    }
+    
+    size_t bufferSize;
+    size_t bufferCount;
+    std::vector<unsigned char*> buffers;
+    std::chrono::steady_clock::time_point start;
+    
+    // Shared between the reader and the writer, guarded by the mutex
+    std::mutex mutex;
+    std::condition_variable bufferFreed;
+    std::condition_variable chunkQueued;
+    std::vector<unsigned char*> freeBuffers;
+    std::deque<Chunk> pendingChunks;
+    bool stopping = false;
+    
+    // Reader side
+    std::thread writer;
+    bool writerStarted = false;
+    bool writerUnavailable = false;
+    size_t filesSubmitted = 0;
+    std::atomic<bool> failed{false};
+    
+    // Writer side
+    FILE* destinationFile = nullptr;
+    std::string destinationPath;
+    uint64_t bytesWritten = 0;
+    bool destinationFailed = false;
+    CopyStats stats;
+};
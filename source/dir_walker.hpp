@@ -0,0 +1,198 @@
+/********************************************************************************
+ * File: dir_walker.hpp
+ * Author: ppkantorski
+ * Description:
+ *   This header file provides the directory walker shared by the listing,
+ *   copy, move and delete functions. Entry types come from the dirent d_type
+ *   field, so a stat is only needed when the file system leaves it unknown.
+ *   Trees are walked with an explicit stack and one reused path buffer.
+ *
+ *   For the latest updates and contributions, visit the project's GitHub repository.
+ *   (GitHub Repository: https://github.com/ppkantorski/Ultrahand-Overlay)
+ *
+ *   Note: Please be aware that this notice cannot be altered or removed. It is a part
+ *   of the project's documentation and must remain intact.
+ *
+ *  Licensed under both GPLv2 and CC-BY-4.0
+ *  Copyright (c) 2024 ppkantorski
+ ********************************************************************************/
+
+#pragma once
+#include <sys/stat.h>
+#include <dirent.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+/**
+ * @brief Walks the entries of a directory, and optionally of all its subdirectories.
+ *
+ * Usage:
+ *     DirWalker walker(path, true);
+ *     while (walker.next())
+ *         if (walker.isFile()) ... walker.getPath() ...
+ *
+ * Entries are reported depth first, each directory right before its contents. With
+ * visitDirectoriesAfter set, every directory is reported a second time once its contents are
+ * done (isLeaving() is then true), which is the point where it can be removed.
+ */
+class DirWalker {
+public:
+    /**
+     * @param rootPath The directory to walk, with or without a trailing slash.
+     * @param recursive Descends into subdirectories.
+     * @param visitDirectoriesAfter Also reports each directory after its contents.
+     */
+    explicit DirWalker(const std::string& rootPath, bool recursive = false, bool visitDirectoriesAfter = false)
+        : recursive(recursive), visitDirectoriesAfter(visitDirectoriesAfter), path(rootPath) {
+        if (!path.empty() && path.back() != '/')
+            path += '/';
+        rootLength = path.size();
+        
+        DIR* dir = opendir(path.c_str());
+        if (dir) {
+            stack.push_back({dir, path.size()});
+            rootOpened = true;
+        }
+    }
+    
+    ~DirWalker() {
+        for (auto& frame : stack)
+            closedir(frame.dir);
+    }
+    
+    DirWalker(const DirWalker&) = delete;
+    DirWalker& operator=(const DirWalker&) = delete;
+    
+    /**
+     * @brief Moves to the next entry.
+     *
+     * @return False once all entries were reported.
+     */
+    bool next() {
+        struct dirent* entry;
+        
+        // Enter the directory reported last
+        if (descendPending) {
+            descendPending = false;
+            path += '/';
+            DIR* dir = opendir(path.c_str());
+            if (dir)
+                stack.push_back({dir, path.size()});
+            else {
+                path.pop_back();
+                if (visitDirectoriesAfter) {
+                    leaving = true;
+                    return true;
+                }
+            }
+        }
+        leaving = false;
+        
+        while (!stack.empty()) {
+            Frame& frame = stack.back();
+            entry = readdir(frame.dir);
+            
+            if (!entry) {
+                closedir(frame.dir);
+                const size_t directoryLength = frame.pathLength;
+                stack.pop_back();
+                if (stack.empty() || !visitDirectoriesAfter)
+                    continue;
+                
+                // Report the finished directory again, without its trailing slash
+                path.resize(directoryLength - 1);
+                nameOffset = stack.back().pathLength;
+                directory = true;
+                leaving = true;
+                return true;
+            }
+            
+            if (entry->d_name[0] == '.' && (entry->d_name[1] == '\0' || (entry->d_name[1] == '.' && entry->d_name[2] == '\0')))
+                continue;
+            
+            path.resize(frame.pathLength);
+            path += entry->d_name;
+            nameOffset = frame.pathLength;
+            
+            if (entry->d_type == DT_DIR)
+                directory = true;
+            else if (entry->d_type != DT_UNKNOWN)
+                directory = false;
+            else {
+                // Only file systems that leave the type unknown cost a lookup
+                struct stat entryStat;
+                directory = (stat(path.c_str(), &entryStat) == 0 && S_ISDIR(entryStat.st_mode));
+            }
+            
+            descendPending = (recursive && directory);
+            return true;
+        }
+        return false;
+    }
+    
+    /**
+     * @brief Does not descend into the directory reported last.
+     */
+    void skipDirectory() {
+        descendPending = false;
+    }
+    
+    /**
+     * @brief The full path of the entry, directories without a trailing slash. Reused by next().
+     */
+    const std::string& getPath() const {
+        return path;
+    }
+    
+    /**
+     * @brief The entry path relative to the root.
+     */
+    std::string_view getRelativePath() const {
+        return std::string_view(path).substr(rootLength);
+    }
+    
+    std::string_view getName() const {
+        return std::string_view(path).substr(nameOffset);
+    }
+    
+    bool isDirectory() const {
+        return directory;
+    }
+    
+    bool isFile() const {
+        return !directory;
+    }
+    
+    /**
+     * @brief True when a directory is reported after its contents.
+     */
+    bool isLeaving() const {
+        return leaving;
+    }
+    
+    /**
+     * @brief False if the root directory could not be opened.
+     */
+    bool isOpen() const {
+        return rootOpened;
+    }
+
+private:
+    struct Frame {
+        DIR* dir;
+        size_t pathLength; // Length of the directory path, including its trailing slash
+    };
+    
+    bool recursive;
+    bool visitDirectoriesAfter;
+    std::string path;
+    size_t rootLength = 0;
+    size_t nameOffset = 0;
+    std::vector<Frame> stack;
+    bool directory = false;
+    bool descendPending = false;
+    bool leaving = false;
+    bool rootOpened = false;
+};
@@ -172,6 +172,7 @@ bool downloadFile(const std::string& url, const std::string& toDestination) {
     CURLcode result = curl_easy_perform(curl);
     curl_easy_cleanup(curl);
     fclose(file);
+    invalidateDirectoryListing(destination);
     //delete callbackData;
     if (result != CURLE_OK) {
         logMessage(std::string("Error downloading file: ") + curl_easy_strerror(result));
@@ -286,6 +287,7 @@ bool unzipFile(const std::string& zipFilePath, const std::string& toDestination)
     }
 
     zzip_dir_close(dir);
+    invalidateDirectoryListing(toDestination);
     return success;
 }
 
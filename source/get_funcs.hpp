@@ -21,9 +21,14 @@
 #include <sys/stat.h>
 #include <dirent.h>
 #include <fnmatch.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
 #include <jansson.h>
 #include "debug_funcs.hpp"
 #include <string_funcs.hpp>
+#include <dir_walker.hpp>
 
 // Constants for overlay module
 constexpr int OverlayLoaderModuleId = 348;
@@ -181,25 +186,25 @@ std::string getParentDirNameFromPath(const std::string& path, size_t level = 0)
         directories.push_back(path.substr(pos + 1, nextPos - pos - 1));
         pos = nextPos;
     }
-
+    
     // Calculate the index of the desired directory
     size_t targetIndex = directories.size() - 2 - level; // Adjusted to get parent directory
-
+    
     // Check if the target index is valid
     if (targetIndex < directories.size() - 1) {
         // Extract the directory name at the target index
         std::string targetDir = directories[targetIndex];
-
+        
         // Check if the directory name contains spaces or special characters
         if (targetDir.find_first_of(" \t\n\r\f\v") != std::string::npos) {
             // If it does, return the directory name within quotes
             return "\"" + targetDir + "\"";
         }
-
+        
         // If it doesn't, return the directory name as is
         return targetDir;
     }
-
+    
     // If the path format is not as expected or the target directory is not found,
     // return an empty string or handle the case accordingly
     return "";
@@ -232,24 +237,10 @@ std::string getParentDirFromPath(const std::string& path) {
 std::vector<std::string> getSubdirectories(const std::string& directoryPath) {
     std::vector<std::string> subdirectories;
     
-    DIR* dir = opendir(directoryPath.c_str());
-    if (dir != nullptr) {
-        struct dirent* entry;
-        while ((entry = readdir(dir)) != nullptr) {
-            std::string entryName = entry->d_name;
-            
-            // Exclude current directory (.) and parent directory (..)
-            if (entryName != "." && entryName != "..") {
-                struct stat entryStat;
-                std::string fullPath = directoryPath + "/" + entryName;
-                
-                if (stat(fullPath.c_str(), &entryStat) == 0 && S_ISDIR(entryStat.st_mode)) {
-                    subdirectories.push_back(entryName);
-                }
-            }
-        }
-        
-        closedir(dir);
+    DirWalker walker(directoryPath);
+    while (walker.next()) {
+        if (walker.isDirectory())
+            subdirectories.emplace_back(walker.getName());
     }
     
     return subdirectories;
@@ -264,176 +255,360 @@ std::vector<std::string> getSubdirectories(const std::string& directoryPath) {
 std::vector<std::string> getFilesListFromDirectory(const std::string& directoryPath) {
     std::vector<std::string> fileList;
     
-    DIR* dir = opendir(directoryPath.c_str());
-    if (dir != nullptr) {
-        dirent* entry;
-        std::string entryName, entryPath;
-        std::vector<std::string> subDirFiles;
-        while ((entry = readdir(dir)) != nullptr) {
-            entryName = entry->d_name;
-            entryPath = directoryPath;
-            if (entryPath.back() != '/')
-                entryPath += '/';
-            entryPath += entryName;
-            
-            // Skip directories "." and ".."
-            if (entryName != "." && entryName != "..") {
-                if (isDirectory(entryPath)) {
-                    // Recursively retrieve files from subdirectories
-                    subDirFiles = getFilesListFromDirectory(entryPath);
-                    fileList.insert(fileList.end(), subDirFiles.begin(), subDirFiles.end());
-                } else {
-                    fileList.push_back(entryPath);
-                }
-            }
-        }
-        closedir(dir);
+    // Subdirectories are walked in place, files are listed in the order they are found
+    DirWalker walker(directoryPath, true);
+    while (walker.next()) {
+        if (walker.isFile())
+            fileList.push_back(walker.getPath());
     }
-
+    
     return fileList;
 }
 
 
 /**
- * @brief Gets a list of files and folders based on a wildcard pattern.
+ * @brief The entries of a directory, each as its name and whether it is a directory.
+ */
+using DirectoryEntries = std::vector<std::pair<std::string, bool>>;
+
+/**
+ * @brief A cached directory listing together with the directory's modification time when listed.
+ */
+struct DirectoryListingEntry {
+    time_t modifiedTime;
+    std::shared_ptr<const DirectoryEntries> entries;
+};
+
+constexpr size_t directoryListingCacheLimit = 512; // Directories kept before the cache starts over
+
+static std::map<std::string, DirectoryListingEntry> directoryListingCache;
+static std::mutex directoryListingCacheMutex;
+static size_t directoryListingCacheHits = 0;
+static size_t directoryListingCacheMisses = 0;
+
+/**
+ * @brief Normalizes a directory path into a listing cache key, without "sdmc:" and with a trailing slash.
+ */
+static std::string getDirectoryListingKey(const std::string& directoryPath) {
+    std::string cacheKey = (directoryPath.compare(0, 5, "sdmc:") == 0) ? directoryPath.substr(5) : directoryPath;
+    if (cacheKey.empty() || cacheKey.back() != '/')
+        cacheKey += '/';
+    return cacheKey;
+}
+
+/**
+ * @brief Returns the entries of a directory, listing it again only when it changed.
  *
- * @param pathPattern The wildcard pattern to match files and folders.
- * @return A vector of strings containing the paths of matching files and folders.
+ * The cached listing is reused as long as the directory's modification time is unchanged.
+ * Since FAT does not reliably update that time, Ultrahand's own create, delete, move, copy,
+ * download and unzip operations also invalidate the affected listings explicitly.
+ *
+ * @param directoryPath The path to the directory.
+ * @return The directory entries, or nullptr if the directory cannot be read.
  */
-std::vector<std::string> getFilesListByWildcard(const std::string& pathPattern) {
-    std::string dirPath = "";
-    std::string wildcard = "";
+std::shared_ptr<const DirectoryEntries> getCachedDirectoryListing(const std::string& directoryPath) {
+    struct stat directoryStat;
+    if (stat(directoryPath.c_str(), &directoryStat) != 0 || !S_ISDIR(directoryStat.st_mode))
+        return nullptr;
     
-    size_t wildcardPos = pathPattern.find('*');
-    if (wildcardPos != std::string::npos) {
-        size_t slashPos = pathPattern.rfind('/', wildcardPos);
-        
-        if (slashPos != std::string::npos) {
-            dirPath = pathPattern.substr(0, slashPos + 1);
-            wildcard = pathPattern.substr(slashPos + 1);
-        } else {
-            dirPath = "";
-            wildcard = pathPattern;
+    const std::string cacheKey = getDirectoryListingKey(directoryPath);
+    {
+        std::lock_guard<std::mutex> lock(directoryListingCacheMutex);
+        auto it = directoryListingCache.find(cacheKey);
+        if (it != directoryListingCache.end() && it->second.modifiedTime == directoryStat.st_mtime) {
+            ++directoryListingCacheHits;
+            return it->second.entries;
         }
-    } else {
-        dirPath = pathPattern + "/";
+        ++directoryListingCacheMisses;
     }
     
-    //logMessage("dirPath: " + dirPath);
-    //logMessage("wildcard: " + wildcard);
+    DirWalker walker(directoryPath);
+    if (!walker.isOpen())
+        return nullptr;
     
-    std::vector<std::string> fileList;
+    auto entries = std::make_shared<DirectoryEntries>();
+    while (walker.next())
+        entries->emplace_back(walker.getName(), walker.isDirectory());
     
-    bool isFolderWildcard = wildcard.back() == '/';
-    if (isFolderWildcard) {
-        wildcard = wildcard.substr(0, wildcard.size() - 1);  // Remove the trailing slash
-    }
+    std::lock_guard<std::mutex> lock(directoryListingCacheMutex);
+    if (directoryListingCache.size() >= directoryListingCacheLimit)
+        directoryListingCache.clear();
+    directoryListingCache[cacheKey] = {directoryStat.st_mtime, entries};
+    return entries;
+}
+
+/**
+ * @brief Drops the cached listings affected by a change to a path.
+ *
+ * This covers the listing of the parent directory, and if the path is a directory, the
+ * listings of the directory and everything below it.
+ *
+ * @param path The path of the created, deleted or modified file or directory.
+ */
+void invalidateDirectoryListing(const std::string& path) {
+    std::string cacheKey = getDirectoryListingKey(path);
     
-    //logMessage("isFolderWildcard: " + std::to_string(isFolderWildcard));
+    std::lock_guard<std::mutex> lock(directoryListingCacheMutex);
+    auto it = directoryListingCache.lower_bound(cacheKey);
+    while (it != directoryListingCache.end() && it->first.compare(0, cacheKey.size(), cacheKey) == 0)
+        it = directoryListingCache.erase(it);
     
-    DIR* dir = opendir(dirPath.c_str());
-    if (dir != nullptr) {
-        dirent* entry;
+    cacheKey.pop_back();
+    const size_t slashPos = cacheKey.rfind('/');
+    if (slashPos != std::string::npos)
+        directoryListingCache.erase(cacheKey.substr(0, slashPos + 1));
+}
+
+/**
+ * @brief Drops all cached directory listings.
+ */
+void clearDirectoryListingCache() {
+    std::lock_guard<std::mutex> lock(directoryListingCacheMutex);
+    directoryListingCache.clear();
+}
+
+/**
+ * @brief Retrieves the directory listing cache hit and miss counters.
+ *
+ * @param hits Receives the number of listings served from the cache.
+ * @param misses Receives the number of directories that had to be listed.
+ */
+void getDirectoryListingCacheStats(size_t& hits, size_t& misses) {
+    std::lock_guard<std::mutex> lock(directoryListingCacheMutex);
+    hits = directoryListingCacheHits;
+    misses = directoryListingCacheMisses;
+}
+
+
+/**
+ * @brief A path pattern compiled into one matcher per path segment.
+ *
+ * The wildcards are '*' and '?'. Brackets are matched literally, since they are common in
+ * mod folder names. The literal directories in front of the first wildcard become the base
+ * path. Every segment after it is matched as a literal name, a prefix/suffix pair around a
+ * single '*', an fnmatch pattern, or "**", which matches any number of directories. A
+ * trailing '/' makes the pattern match directories instead of files.
+ *
+ * Matches are found in a single depth-first traversal. Only directories that match their
+ * segment are entered, and literal segments are entered without listing their parent.
+ */
+class GlobPattern {
+public:
+    explicit GlobPattern(const std::string& pathPattern) {
+        std::string pattern = pathPattern;
+        matchDirectories = (!pattern.empty() && pattern.back() == '/');
+        if (matchDirectories)
+            pattern.pop_back();
         
-        std::string entryName, entryPath, prefix, suffix;
-        bool isEntryDirectory;
-        size_t wildcardPos;
+        // Split off the literal directories in front of the first wildcard
+        const size_t wildcardPos = pattern.find_first_of("*?");
+        const size_t slashPos = pattern.rfind('/', wildcardPos);
+        if (slashPos != std::string::npos) {
+            basePath = pattern.substr(0, slashPos + 1);
+            pattern.erase(0, slashPos + 1);
+        }
         
-        while ((entry = readdir(dir)) != nullptr) {
-            entryName = entry->d_name;
-            entryPath = dirPath + entryName;
+        size_t start = 0, end;
+        while (start <= pattern.size()) {
+            end = pattern.find('/', start);
+            if (end == std::string::npos)
+                end = pattern.size();
+            if (end > start)
+                addSegment(pattern.substr(start, end - start));
+            start = end + 1;
+        }
+    }
+    
+    /**
+     * @brief Finds all paths matching the pattern.
+     *
+     * @param onMatch Called as onMatch(path) for each match, directories with a trailing '/'.
+     * @param useListingCache Lists directories through getCachedDirectoryListing().
+     */
+    template <typename MatchHandler>
+    void forEachMatch(MatchHandler&& onMatch, bool useListingCache = false) const {
+        if (segments.empty() || basePath.empty())
+            return;
+        
+        struct PendingDirectory {
+            std::string path; // With a trailing slash
+            size_t segment;
+        };
+        std::vector<PendingDirectory> stack{{basePath, 0}};
+        std::vector<PendingDirectory> children;
+        std::string matchPath;
+        struct stat entryStat;
+        
+        // With several "**", one directory can be reached at one segment through different
+        // splits of its path, as "a/x/x/" for "a/**/x/**/y". Each is then only visited once.
+        std::unordered_set<std::string> visitedDirectories;
+        
+        while (!stack.empty()) {
+            PendingDirectory current = std::move(stack.back());
+            stack.pop_back();
             
-            isEntryDirectory = isDirectory(entryPath);
+            if (recursiveSegmentCount > 1 &&
+                !visitedDirectories.insert(std::to_string(current.segment) + ':' + current.path).second)
+                continue;
             
-            //logMessage("entryName: " + entryName);
-            //logMessage("entryPath: " + entryPath);
-            //logMessage("isFolderWildcard: " + std::to_string(isFolderWildcard));
-            //logMessage("isEntryDirectory: " + std::to_string(isEntryDirectory));
+            const bool recursive = (segments[current.segment].type == SegmentType::Recursive);
+            const size_t segmentIndex = recursive ? current.segment + 1 : current.segment;
             
-            if (isFolderWildcard && isEntryDirectory && fnmatch(wildcard.c_str(), entryName.c_str(), FNM_NOESCAPE) == 0) {
-                if (entryName != "." && entryName != "..") {
-                    fileList.push_back(entryPath+"/");
-                }
-            } else if (!isFolderWildcard && !isEntryDirectory) {
-                wildcardPos = wildcard.find('*');
-                if (wildcardPos != std::string::npos) {
-                    prefix = wildcard.substr(0, wildcardPos);
-                    if (entryName.find(prefix) == 0) {
-                        suffix = wildcard.substr(wildcardPos + 1);
-                        if (entryName.size() >= suffix.size() && entryName.compare(entryName.size() - suffix.size(), suffix.size(), suffix) == 0) {
-                            fileList.push_back(entryPath);
-                        }
+            // "**" at the end matches every entry below, at any depth
+            const bool matchAll = (segmentIndex == segments.size());
+            
+            if (!matchAll && !recursive && segments[segmentIndex].type == SegmentType::Literal) {
+                // A literal name needs no listing. A directory in the middle is entered as is,
+                // as listing it finds nothing if it is missing, only the last name is looked up.
+                matchPath = current.path + segments[segmentIndex].text;
+                if (segmentIndex + 1 < segments.size())
+                    stack.push_back({matchPath + "/", segmentIndex + 1});
+                else if (stat(matchPath.c_str(), &entryStat) == 0 && S_ISDIR(entryStat.st_mode) == matchDirectories)
+                    onMatch(matchDirectories ? matchPath + "/" : matchPath);
+                continue;
+            }
+            
+            children.clear();
+            const auto visitEntry = [&](std::string_view name, bool isDirectory) {
+                const bool matchesSegment = matchAll || segments[segmentIndex].matches(name);
+                
+                if (matchesSegment && (matchAll || segmentIndex + 1 == segments.size())) {
+                    if (isDirectory == matchDirectories) {
+                        matchPath.assign(current.path).append(name);
+                        onMatch(matchDirectories ? matchPath + "/" : matchPath);
                     }
-                } else if (fnmatch(wildcard.c_str(), entryName.c_str(), FNM_NOESCAPE) == 0) {
-                    fileList.push_back(entryPath);
+                } else if (matchesSegment && isDirectory) {
+                    children.push_back({current.path + std::string(name) + "/", segmentIndex + 1});
                 }
+                
+                // Keep descending for "**", which may match this directory as well
+                if (recursive && isDirectory)
+                    children.push_back({current.path + std::string(name) + "/", current.segment});
+            };
+            
+            if (useListingCache) {
+                const auto entries = getCachedDirectoryListing(current.path);
+                if (entries)
+                    for (const auto& entry : *entries)
+                        visitEntry(entry.first, entry.second);
+            } else {
+                DirWalker walker(current.path);
+                while (walker.next())
+                    visitEntry(walker.getName(), walker.isDirectory());
             }
+            
+            // Reversed, so subdirectories are visited in listing order
+            for (auto it = children.rbegin(); it != children.rend(); ++it)
+                stack.push_back(std::move(*it));
         }
-        closedir(dir);
     }
     
-    //std::string fileListAsString;
-    //for (const std::string& filePath : fileList) {
-    //    fileListAsString += filePath + "\n";
-    //}
-    //logMessage("File List:\n" + fileListAsString);
+    /**
+     * @brief Returns all paths matching the pattern, see forEachMatch().
+     */
+    std::vector<std::string> match(bool useListingCache = false) const {
+        std::vector<std::string> matches;
+        forEachMatch([&](const std::string& path) { matches.push_back(path); }, useListingCache);
+        return matches;
+    }
+
+private:
+    enum class SegmentType {
+        Literal,       // No wildcards
+        Any,           // "*"
+        PrefixSuffix,  // A single '*' between a literal prefix and suffix
+        Pattern,       // Anything else, matched by fnmatch with '[' escaped
+        Recursive      // "**"
+    };
     
-    return fileList;
+    struct Segment {
+        SegmentType type;
+        std::string text;
+        std::string prefix, suffix;
+        
+        bool matches(std::string_view name) const {
+            switch (type) {
+                case SegmentType::Literal:
+                    return name == text;
+                case SegmentType::Any:
+                    return true;
+                case SegmentType::PrefixSuffix:
+                    return name.size() >= prefix.size() + suffix.size() &&
+                        name.compare(0, prefix.size(), prefix) == 0 &&
+                        name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+                case SegmentType::Pattern:
+                    return fnmatch(text.c_str(), std::string(name).c_str(), FNM_NOESCAPE) == 0;
+                default:
+                    return false;
+            }
+        }
+    };
+    
+    void addSegment(std::string text) {
+        Segment segment{SegmentType::Pattern, std::move(text), "", ""};
+        const size_t starPos = segment.text.find('*');
+        
+        if (segment.text == "**") {
+            if (!segments.empty() && segments.back().type == SegmentType::Recursive)
+                return; // "**/**" is the same as "**"
+            segment.type = SegmentType::Recursive;
+            ++recursiveSegmentCount;
+        } else if (segment.text.find_first_of("*?") == std::string::npos) {
+            segment.type = SegmentType::Literal;
+        } else if (segment.text == "*") {
+            segment.type = SegmentType::Any;
+        } else if (segment.text.find('?') == std::string::npos && segment.text.find('*', starPos + 1) == std::string::npos) {
+            segment.type = SegmentType::PrefixSuffix;
+            segment.prefix = segment.text.substr(0, starPos);
+            segment.suffix = segment.text.substr(starPos + 1);
+        } else {
+            // "[[]" matches a literal '[' when escapes are off
+            for (size_t pos = segment.text.find('['); pos != std::string::npos; pos = segment.text.find('[', pos + 3))
+                segment.text.replace(pos, 1, "[[]");
+        }
+        segments.push_back(std::move(segment));
+    }
+    
+    std::string basePath; // Literal directories in front of the first wildcard, with a trailing slash
+    std::vector<Segment> segments;
+    size_t recursiveSegmentCount = 0;
+    bool matchDirectories = false;
+};
+
+/**
+ * @brief Gets a list of files and folders based on a wildcard pattern.
+ *
+ * @param pathPattern The wildcard pattern to match files and folders, see GlobPattern.
+ * @param useListingCache Reuses directory listings that did not change, see getCachedDirectoryListing().
+ * @return A vector of strings containing the paths of matching files and folders.
+ */
+std::vector<std::string> getFilesListByWildcard(const std::string& pathPattern, bool useListingCache = false) {
+    // Literal paths are not listed
+    if (pathPattern.find_first_of("*?") == std::string::npos)
+        return {};
+    return GlobPattern(pathPattern).match(useListingCache);
 }
 
 /**
  * @brief Gets a list of files and folders based on a wildcard pattern.
  *
- * This function searches for files and folders in a directory that match the
- * specified wildcard pattern.
+ * This function searches for files and folders that match the specified wildcard
+ * pattern. Wildcards may appear in any number of path segments, and "**" matches
+ * any number of directories. Every directory is listed at most once.
  *
- * @param pathPattern The wildcard pattern to match files and folders.
+ * @param pathPattern The wildcard pattern to match files and folders, see GlobPattern.
+ * @param useListingCache Reuses directory listings that did not change, see getCachedDirectoryListing().
  * @return A vector of strings containing the paths of matching files and folders.
  */
-std::vector<std::string> getFilesListByWildcards(const std::string& pathPattern) {
-    std::vector<std::string> fileList;
-    
-    // Check if the pattern contains multiple wildcards
-    size_t wildcardPos = pathPattern.find('*');
-    if (wildcardPos != std::string::npos && pathPattern.find('*', wildcardPos + 1) != std::string::npos) {
-        std::string dirPath = "";
-        std::string wildcard = "";
-        
-        // Extract the directory path and the first wildcard
-        size_t slashPos = pathPattern.rfind('/', wildcardPos);
-        if (slashPos != std::string::npos) {
-            dirPath = pathPattern.substr(0, slashPos + 1);
-            wildcard = pathPattern.substr(slashPos + 1, wildcardPos - slashPos - 1);
-        } else {
-            dirPath = "";
-            wildcard = pathPattern.substr(0, wildcardPos);
-        }
-        
-        // Get the list of directories matching the first wildcard
-        std::vector<std::string> subDirs = getFilesListByWildcard(dirPath + wildcard + "*/");
-        
-        std::string subPattern;
-        std::vector<std::string> subFileList;
-        
-        // Process each subdirectory recursively
-        for (const std::string& subDir : subDirs) {
-            subPattern = subDir + removeLeadingSlash(pathPattern.substr(wildcardPos + 1));
-            subFileList = getFilesListByWildcards(subPattern);
-            fileList.insert(fileList.end(), subFileList.begin(), subFileList.end());
-        }
-    } else {
-        // Only one wildcard present, use getFilesListByWildcard directly
-        fileList = getFilesListByWildcard(pathPattern);
-    }
-    
-    return fileList;
+std::vector<std::string> getFilesListByWildcards(const std::string& pathPattern, bool useListingCache = false) {
+    return getFilesListByWildcard(pathPattern, useListingCache);
 }
 
 
 
 const char* getStringFromJson(json_t* root, const char* key) {
     json_t* value = json_object_get(root, key);
-
+    
     if (value && json_is_string(value)) {
         return json_string_value(value);
     } else {
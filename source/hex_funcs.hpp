@@ -22,14 +22,29 @@
 #include <algorithm>
 #include <cstdio> // Added for FILE and fopen
 #include <cstring> // Added for std::memcmp
+#include <unordered_map>
+#include <mutex>
 #include <sys/stat.h> // Added for stat
+#include <charconv> // For std::from_chars
+#include <string_view>
+#include <binary_reader.hpp>
 
 
-const size_t hexBufferSize = 4096;
-
-
-// For improving the speed of hexing consecutively with the same file and asciiPattern.
-//static std::unordered_map<std::string, std::string> hexSumCache; // MOVED TO main.cpp
+/**
+ * @brief Parses a decimal offset, relative offset or count from a command argument.
+ *
+ * @param str The argument, a leading '+' is allowed.
+ * @param value Receives the number.
+ * @return True if the whole argument is a number that fits the type, false otherwise.
+ */
+template <typename T>
+bool parseOffsetNumber(std::string_view str, T& value) {
+    if (!str.empty() && str.front() == '+')
+        str.remove_prefix(1);
+    
+    const auto [end, error] = std::from_chars(str.data(), str.data() + str.size(), value);
+    return !str.empty() && error == std::errc() && end == str.data() + str.size();
+}
 
 /**
  * @brief Converts an ASCII string to a hexadecimal string.
@@ -66,11 +81,13 @@ std::string asciiToHex(const std::string& asciiStr) {
  * This function takes a decimal string as input and converts it into a hexadecimal string.
  *
  * @param decimalStr The decimal string to convert.
- * @return The corresponding hexadecimal string.
+ * @return The corresponding hexadecimal string, or an empty string if the input is not a number.
  */
 std::string decimalToHex(const std::string& decimalStr) {
     // Convert decimal string to integer
-    int decimalValue = std::stoi(decimalStr);
+    u64 decimalValue = 0;
+    if (!parseOffsetNumber(decimalStr, decimalValue))
+        return "";
     
     // Convert decimal to hexadecimal
     std::string hexadecimal;
@@ -78,12 +95,12 @@ std::string decimalToHex(const std::string& decimalStr) {
     int _remainder;
     char hexChar;
     
-    while (decimalValue > 0) {
-        _remainder = decimalValue % 16;
+    do {
+        _remainder = static_cast<int>(decimalValue % 16);
         hexChar = (_remainder < 10) ? ('0' + _remainder) : ('A' + _remainder - 10);
         hexadecimal += hexChar;
         decimalValue /= 16;
-    }
+    } while (decimalValue > 0);
     
     // Reverse the hexadecimal string
     std::reverse(hexadecimal.begin(), hexadecimal.end());
@@ -119,61 +136,518 @@ std::string decimalToReversedHex(const std::string& decimalStr, int order = 2) {
 }
 
 /**
- * @brief Finds the offsets of hexadecimal data in a file.
+ * @brief A compiled byte pattern with a wildcard mask.
  *
- * This function searches for occurrences of hexadecimal data in a binary file
- * and returns the file offsets where the data is found.
+ * Hexadecimal patterns are parsed once into bytes and a mask. A '?' digit matches any nibble, so
+ * "??" matches any byte and "4?" any byte from 0x40 to 0x4F. Bytes are stored already masked.
+ * A pattern that fails to parse is empty and never matches.
+ */
+struct HexPattern {
+    std::vector<unsigned char> bytes;
+    std::vector<unsigned char> mask; // 0xFF for exact bytes, 0x00 for "??"
+    bool hasWildcards = false;
+    
+    HexPattern() = default;
+    
+    /**
+     * @brief Parses a hexadecimal string such as "48 8B ?? 4?", spaces are ignored.
+     */
+    explicit HexPattern(const std::string& hexData) {
+        bytes.reserve(hexData.length() / 2);
+        mask.reserve(hexData.length() / 2);
+        
+        unsigned char nibbles[2], nibbleMasks[2];
+        size_t nibbleCount = 0;
+        char c;
+        
+        for (size_t i = 0; i < hexData.length(); ++i) {
+            c = hexData[i];
+            if (c == ' ')
+                continue;
+            
+            if (c == '?') {
+                nibbles[nibbleCount] = 0;
+                nibbleMasks[nibbleCount] = 0x0;
+                hasWildcards = true;
+            } else {
+                if (c >= '0' && c <= '9')
+                    nibbles[nibbleCount] = c - '0';
+                else if (c >= 'A' && c <= 'F')
+                    nibbles[nibbleCount] = c - 'A' + 10;
+                else if (c >= 'a' && c <= 'f')
+                    nibbles[nibbleCount] = c - 'a' + 10;
+                else {
+                    clear();
+                    return;
+                }
+                nibbleMasks[nibbleCount] = 0xF;
+            }
+            
+            if (++nibbleCount == 2) {
+                bytes.push_back(static_cast<unsigned char>(nibbles[0] << 4 | nibbles[1]));
+                mask.push_back(static_cast<unsigned char>(nibbleMasks[0] << 4 | nibbleMasks[1]));
+                nibbleCount = 0;
+            }
+        }
+        
+        // A trailing single digit is read as a whole byte
+        if (nibbleCount == 1) {
+            bytes.push_back(nibbles[0]);
+            mask.push_back(nibbleMasks[0] == 0xF ? 0xFF : 0x00);
+        }
+    }
+    
+    /**
+     * @brief Creates an exact pattern from raw bytes.
+     */
+    static HexPattern fromBytes(const unsigned char* data, size_t size) {
+        HexPattern pattern;
+        pattern.bytes.assign(data, data + size);
+        pattern.mask.assign(size, 0xFF);
+        return pattern;
+    }
+    
+    /**
+     * @brief Creates an exact pattern from the bytes of an ASCII string.
+     */
+    static HexPattern fromAscii(const std::string& asciiStr) {
+        HexPattern pattern;
+        pattern.bytes.assign(asciiStr.begin(), asciiStr.end());
+        pattern.mask.assign(asciiStr.size(), 0xFF);
+        return pattern;
+    }
+    
+    size_t size() const {
+        return bytes.size();
+    }
+    
+    bool empty() const {
+        return bytes.empty();
+    }
+    
+    void clear() {
+        bytes.clear();
+        mask.clear();
+        hasWildcards = false;
+    }
+    
+    /**
+     * @brief Checks whether a single byte matches the pattern byte at index.
+     */
+    bool matchesByte(size_t index, unsigned char byte) const {
+        return (byte & mask[index]) == bytes[index];
+    }
+    
+    /**
+     * @brief Checks whether the pattern matches at data, which must hold at least size() bytes.
+     *
+     * Masked patterns are compared eight bytes at a time.
+     */
+    bool matches(const unsigned char* data) const {
+        const size_t length = bytes.size();
+        if (!hasWildcards)
+            return std::memcmp(data, bytes.data(), length) == 0;
+        
+        size_t i = 0;
+        uint64_t dataWord, byteWord, maskWord;
+        for (; i + 8 <= length; i += 8) {
+            std::memcpy(&dataWord, data + i, 8);
+            std::memcpy(&byteWord, bytes.data() + i, 8);
+            std::memcpy(&maskWord, mask.data() + i, 8);
+            if ((dataWord & maskWord) != byteWord)
+                return false;
+        }
+        for (; i < length; ++i) {
+            if ((data[i] & mask[i]) != bytes[i])
+                return false;
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief Compiles the pattern of a hex-by-custom-offset command or {hex_file(...)} placeholder.
  *
- * @param filePath The path to the binary file.
- * @param hexData The hexadecimal data to search for.
- * @return A vector of strings containing the file offsets where the data is found.
+ * Patterns starting with '#' are hexadecimal and may contain wildcards, all others are ASCII.
  */
-std::vector<std::string> findHexDataOffsets(const std::string& filePath, const std::string& hexData) {
-    std::vector<std::string> offsets;
+HexPattern compileCustomPattern(const std::string& customPattern) {
+    if (!customPattern.empty() && customPattern[0] == '#')
+        return HexPattern(customPattern.substr(1));
+    return HexPattern::fromAscii(customPattern);
+}
+
+/**
+ * @brief Searches binary data for a byte pattern.
+ *
+ * The search looks for the key of the pattern, its longest run of exact bytes, and compares the
+ * whole pattern where the key is found. Keys of at least hexSkipMinLength bytes are matched with
+ * Boyer-Moore-Horspool, testing the last byte of each window first and skipping ahead by the shift
+ * table on a mismatch. Shorter keys gain little from skipping, so their candidates are found with
+ * memchr on the first byte, which libc implements with vector instructions on both the Switch and
+ * the host. Using the key keeps a "??" near the end of a pattern from cutting every skip short.
+ */
+class HexSearcher {
+public:
+    static constexpr size_t hexSkipMinLength = 4;
+    
+    explicit HexSearcher(HexPattern pattern) : pattern(std::move(pattern)) {
+        const HexPattern& compiled = this->pattern;
+        if (!compiled.hasWildcards) {
+            keyLength = compiled.size();
+        } else {
+            for (size_t i = 0, runLength = 0; i < compiled.size(); ++i) {
+                runLength = (compiled.mask[i] == 0xFF) ? runLength + 1 : 0;
+                if (runLength > keyLength) {
+                    keyLength = runLength;
+                    keyOffset = i + 1 - runLength;
+                }
+            }
+        }
+        
+        const unsigned char* key = compiled.bytes.data() + keyOffset;
+        std::fill(std::begin(skipTable), std::end(skipTable), keyLength);
+        for (size_t i = 0; i + 1 < keyLength; ++i)
+            skipTable[key[i]] = keyLength - 1 - i;
+    }
     
-    // Open the file for reading in binary mode
-    FILE* file = fopen(filePath.c_str(), "rb");
-    if (!file) {
-        //std::cerr << "Failed to open the file." << std::endl;
-        return offsets;
+    const HexPattern& getPattern() const {
+        return pattern;
     }
     
-    // Check the file size
-    struct stat fileStatus;
-    if (stat(filePath.c_str(), &fileStatus) != 0) {
-        //std::cerr << "Failed to retrieve file size." << std::endl;
-        fclose(file);
-        return offsets;
+    /**
+     * @brief Searches a buffer for the pattern.
+     *
+     * @param data The data to search.
+     * @param size The number of valid bytes in data.
+     * @param onMatch Called as onMatch(position) for each match, returns false to stop.
+     * @return True if onMatch stopped the search, false otherwise.
+     */
+    template <typename MatchHandler>
+    bool search(const unsigned char* data, size_t size, MatchHandler&& onMatch) const {
+        const size_t length = pattern.size();
+        if (length == 0 || size < length)
+            return false;
+        
+        const size_t lastPosition = size - length;
+        
+        // Only wildcards, every position matches
+        if (keyLength == 0) {
+            for (size_t position = 0; position <= lastPosition; ++position)
+                if (!onMatch(position))
+                    return true;
+            return false;
+        }
+        
+        // Positions are pattern starts, the key is at keyData + position
+        const unsigned char* keyData = data + keyOffset;
+        const unsigned char keyFirstByte = pattern.bytes[keyOffset];
+        
+        if (keyLength < hexSkipMinLength) {
+            const unsigned char* candidate;
+            size_t position = 0;
+            while (position <= lastPosition) {
+                candidate = static_cast<const unsigned char*>(std::memchr(keyData + position, keyFirstByte, lastPosition - position + 1));
+                if (!candidate)
+                    break;
+                position = candidate - keyData;
+                if (pattern.matches(data + position) && !onMatch(position))
+                    return true;
+                ++position;
+            }
+            return false;
+        }
+        
+        const unsigned char keyLastByte = pattern.bytes[keyOffset + keyLength - 1];
+        unsigned char windowLastByte;
+        size_t position = 0;
+        while (position <= lastPosition) {
+            windowLastByte = keyData[position + keyLength - 1];
+            if (windowLastByte == keyLastByte && pattern.matches(data + position) && !onMatch(position))
+                return true;
+            position += skipTable[windowLastByte];
+        }
+        return false;
     }
-    //size_t fileSize = fileStatus.st_size;
     
-    // Convert the hex data string to binary data
-    std::vector<unsigned char> binaryData; // Changed to use unsigned char
-    std::string byteString;
-    unsigned char byte;
+    /**
+     * @brief Searches an open file for the pattern, reading it once from its current position.
+     *
+     * The last pattern length - 1 bytes of each chunk are carried over to the next one, so matches
+     * crossing a chunk boundary are found as well.
+     *
+     * @param file The open file.
+     * @param onMatch Called as onMatch(offset) for each match, with offset counted from the position
+     *                the search started at. Returns false to stop.
+     * @return True if onMatch stopped the search, false otherwise.
+     */
+    template <typename MatchHandler>
+    bool searchFile(FILE* file, MatchHandler&& onMatch) const {
+        const size_t length = pattern.size();
+        if (!file || length == 0)
+            return false;
+        
+        // Chunks overlap by length - 1 bytes, so no match is reported twice
+        BinaryReader reader(file);
+        return reader.forEachChunk(length - 1, [&](const unsigned char* data, size_t size, u64 chunkOffset, bool) {
+            return !search(data, size, [&](size_t position) { return onMatch(chunkOffset + position); });
+        });
+    }
+
+private:
+    HexPattern pattern;
+    size_t keyOffset = 0;
+    size_t keyLength = 0;
+    size_t skipTable[256];
+};
+
+/**
+ * @brief Searches binary data for several byte patterns at once.
+ *
+ * When all patterns are at least two bytes long, the search slides a window as long as the
+ * shortest pattern over the data, Wu-Manber style. The byte pair at the end of the window looks up
+ * how far the window can move before any pattern could match, so like HexSearcher it skips most
+ * positions. Only where the pair ends the window of some pattern are those patterns compared in
+ * full. Wildcard bytes in a window count as every byte value.
+ *
+ * With a single byte pattern present, every position is tested against a bitmap of the first two
+ * bytes of all patterns (and a table of the single byte patterns) instead.
+ *
+ * Either way one pass over a file stays close to the cost of a single pattern search, however
+ * many anchors a package looks up in it.
+ */
+class HexMultiSearcher {
+public:
+    static constexpr size_t maxWindowLength = 64;
+    
+    HexMultiSearcher() : pairFilter(65536 / 64, 0) {}
+    
+    /**
+     * @brief Adds a pattern to search for.
+     *
+     * @param pattern The byte pattern. Empty patterns never match.
+     * @return The index reported for matches of this pattern.
+     */
+    size_t addPattern(HexPattern pattern) {
+        const size_t index = patterns.size();
+        
+        if (pattern.size() == 1 && pattern.mask[0] == 0xFF) {
+            singleByteBuckets[pattern.bytes[0]].push_back(index);
+            hasSingleBytePatterns = true;
+        } else if (pattern.size() > 1 && pattern.mask[0] == 0xFF && pattern.mask[1] == 0xFF) {
+            const uint16_t pair = static_cast<uint16_t>(pattern.bytes[0] << 8 | pattern.bytes[1]);
+            pairFilter[pair >> 6] |= uint64_t(1) << (pair & 63);
+            pairBuckets[pair].push_back(index);
+        } else if (!pattern.empty()) {
+            unfilteredPatterns.push_back(index);
+        }
+        
+        maxLength = std::max(maxLength, pattern.size());
+        patterns.push_back(std::move(pattern));
+        
+        // A shorter pattern shortens the window of all of them
+        if (!patterns.back().empty()) {
+            if (windowLength == 0 || patterns.back().size() < windowLength)
+                rebuildShiftTable();
+            else
+                addToShiftTable(index);
+        }
+        return index;
+    }
     
-    for (size_t i = 0; i < hexData.length(); i += 2) {
-        byteString = hexData.substr(i, 2);
-        byte = static_cast<unsigned char>(std::stoi(byteString, nullptr, 16)); // Changed to use unsigned char
-        binaryData.push_back(byte);
+    size_t getPatternCount() const {
+        return patterns.size();
     }
     
-    // Read the file in chunks to find the offsets where the hex data is located
-    std::vector<unsigned char> buffer(hexBufferSize); // Changed to use unsigned char
-    std::streampos offset = 0;
-    size_t bytesRead = 0; // Changed to size_t
-    std::streampos currentOffset;
+    /**
+     * @brief Searches a buffer for all patterns.
+     *
+     * @param data The data to search.
+     * @param size The number of valid bytes in data.
+     * @param limit Only matches starting before this position are reported.
+     * @param onMatch Called as onMatch(patternIndex, position) in order of position, returns false to stop.
+     * @return True if onMatch stopped the search, false otherwise.
+     */
+    template <typename MatchHandler>
+    bool search(const unsigned char* data, size_t size, size_t limit, MatchHandler&& onMatch) const {
+        limit = std::min(limit, size);
+        if (windowLength < 2)
+            return searchEachPosition(data, size, limit, onMatch);
+        
+        const size_t lastWindowByte = windowLength - 1;
+        uint16_t pair;
+        size_t shift, position = 0;
+        
+        while (position < limit && position + windowLength <= size) {
+            pair = static_cast<uint16_t>(data[position + lastWindowByte - 1] << 8 | data[position + lastWindowByte]);
+            shift = shiftTable[pair];
+            if (shift != 0) {
+                position += shift;
+                continue;
+            }
+            
+            auto bucket = windowEndBuckets.find(pair);
+            if (bucket != windowEndBuckets.end()) {
+                for (size_t index : bucket->second) {
+                    if (position + patterns[index].size() <= size && patterns[index].matches(data + position) && !onMatch(index, position))
+                        return true;
+                }
+            }
+            for (size_t index : maskedWindowEndPatterns) {
+                if (position + patterns[index].size() <= size && patterns[index].matches(data + position) && !onMatch(index, position))
+                    return true;
+            }
+            ++position;
+        }
+        return false;
+    }
     
-    while ((bytesRead = fread(buffer.data(), sizeof(unsigned char), hexBufferSize, file)) > 0) { // Changed to use unsigned char and size_t
-        for (size_t i = 0; i < bytesRead; i++) {
-            if (std::memcmp(buffer.data() + i, binaryData.data(), binaryData.size()) == 0) {
-                currentOffset = static_cast<std::streampos>(offset) + static_cast<std::streamoff>(i);
-                offsets.push_back(std::to_string(currentOffset));
+    /**
+     * @brief Searches an open file for all patterns, reading it once from its current position.
+     *
+     * @param file The open file.
+     * @param onMatch Called as onMatch(patternIndex, offset) in order of offset, with offset counted
+     *                from the position the search started at. Returns false to stop.
+     * @return True if onMatch stopped the search, false otherwise.
+     */
+    template <typename MatchHandler>
+    bool searchFile(FILE* file, MatchHandler&& onMatch) const {
+        if (!file || maxLength == 0)
+            return false;
+        
+        const size_t overlap = maxLength - 1;
+        BinaryReader reader(file);
+        return reader.forEachChunk(overlap, [&](const unsigned char* data, size_t size, u64 chunkOffset, bool isLast) {
+            // Positions in the overlap are searched with the next chunk, which completes them
+            return !search(data, size, isLast ? size : size - std::min(size, overlap), [&](size_t index, size_t position) {
+                return onMatch(index, chunkOffset + position);
+            });
+        });
+    }
+
+private:
+    /**
+     * @brief Tests every position against the first byte pair filter, for pattern sets with a single byte pattern.
+     */
+    template <typename MatchHandler>
+    bool searchEachPosition(const unsigned char* data, size_t size, size_t limit, MatchHandler& onMatch) const {
+        uint16_t pair;
+        
+        for (size_t position = 0; position < limit; ++position) {
+            for (size_t index : unfilteredPatterns) {
+                if (position + patterns[index].size() <= size && patterns[index].matches(data + position) && !onMatch(index, position))
+                    return true;
+            }
+            
+            if (hasSingleBytePatterns) {
+                for (size_t index : singleByteBuckets[data[position]])
+                    if (!onMatch(index, position))
+                        return true;
+            }
+            
+            if (position + 1 >= size)
+                break;
+            
+            pair = static_cast<uint16_t>(data[position] << 8 | data[position + 1]);
+            if ((pairFilter[pair >> 6] & (uint64_t(1) << (pair & 63))) == 0)
+                continue;
+            
+            for (size_t index : pairBuckets.at(pair)) {
+                if (position + patterns[index].size() <= size && patterns[index].matches(data + position) && !onMatch(index, position))
+                    return true;
             }
         }
-        offset += bytesRead;
+        return false;
+    }
+    
+    /**
+     * @brief Sets the window to the shortest pattern and fills the shift table with all patterns.
+     */
+    void rebuildShiftTable() {
+        windowLength = maxWindowLength;
+        for (const auto& pattern : patterns)
+            if (!pattern.empty())
+                windowLength = std::min(windowLength, pattern.size());
+        
+        shiftTable.clear();
+        windowEndBuckets.clear();
+        maskedWindowEndPatterns.clear();
+        if (windowLength < 2)
+            return;
+        
+        shiftTable.assign(65536, static_cast<uint8_t>(windowLength - 1));
+        for (size_t index = 0; index < patterns.size(); ++index)
+            if (!patterns[index].empty())
+                addToShiftTable(index);
+    }
+    
+    /**
+     * @brief Lowers the shifts of the byte pairs in the window of a pattern and files it by its last pair.
+     */
+    void addToShiftTable(size_t index) {
+        if (windowLength < 2)
+            return;
+        
+        const HexPattern& pattern = patterns[index];
+        uint8_t shift;
+        for (size_t j = 0; j + 1 < windowLength; ++j) {
+            shift = static_cast<uint8_t>(windowLength - 2 - j);
+            if (pattern.mask[j] == 0xFF && pattern.mask[j + 1] == 0xFF) {
+                uint8_t& entry = shiftTable[pattern.bytes[j] << 8 | pattern.bytes[j + 1]];
+                entry = std::min(entry, shift);
+                continue;
+            }
+            
+            for (size_t pair = 0; pair < 65536; ++pair) {
+                if (shiftTable[pair] > shift && pattern.matchesByte(j, static_cast<unsigned char>(pair >> 8)) &&
+                    pattern.matchesByte(j + 1, static_cast<unsigned char>(pair)))
+                    shiftTable[pair] = shift;
+            }
+        }
+        
+        const size_t last = windowLength - 1;
+        if (pattern.mask[last - 1] == 0xFF && pattern.mask[last] == 0xFF)
+            windowEndBuckets[static_cast<uint16_t>(pattern.bytes[last - 1] << 8 | pattern.bytes[last])].push_back(index);
+        else
+            maskedWindowEndPatterns.push_back(index);
+    }
+    
+    std::vector<HexPattern> patterns;
+    std::vector<size_t> unfilteredPatterns;
+    std::vector<uint64_t> pairFilter; // One bit for each possible first byte pair
+    std::unordered_map<uint16_t, std::vector<size_t>> pairBuckets;
+    std::vector<size_t> singleByteBuckets[256];
+    bool hasSingleBytePatterns = false;
+    size_t maxLength = 0;
+    
+    size_t windowLength = 0; // Length of the shortest pattern, at most maxWindowLength
+    std::vector<uint8_t> shiftTable; // How far the window may move for each pair ending it
+    std::unordered_map<uint16_t, std::vector<size_t>> windowEndBuckets;
+    std::vector<size_t> maskedWindowEndPatterns; // Patterns whose window ends in a wildcard
+};
+
+/**
+ * @brief Finds the offsets of a compiled pattern in a file.
+ *
+ * @param filePath The path to the binary file.
+ * @param pattern The pattern to search for.
+ * @param maxMatches Stops the scan after this many matches, 0 finds all of them.
+ * @return The file offsets where the pattern is found.
+ */
+std::vector<u64> findHexDataOffsets(const std::string& filePath, const HexPattern& pattern, size_t maxMatches = 0) {
+    std::vector<u64> offsets;
+    
+    // Open the file for reading in binary mode
+    FILE* file = fopen(filePath.c_str(), "rb");
+    if (!file) {
+        //std::cerr << "Failed to open the file." << std::endl;
+        return offsets;
     }
     
+    HexSearcher(pattern).searchFile(file, [&](u64 offset) {
+        offsets.push_back(offset);
+        return maxMatches == 0 || offsets.size() < maxMatches;
+    });
+    
     fclose(file);
     return offsets;
 }
@@ -185,306 +659,906 @@ std::vector<std::string> findHexDataOffsets(const std::string& filePath, const s
  * and returns the file offsets where the data is found.
  *
  * @param filePath The path to the binary file.
- * @param hexData The hexadecimal data to search for.
- * @return A vector of strings containing the file offsets where the data is found.
+ * @param hexData The hexadecimal data to search for, "??" matches any byte.
+ * @param maxMatches Stops the scan after this many matches, 0 finds all of them.
+ * @return The file offsets where the data is found.
  */
-std::vector<std::string> findHexDataOffsetsF(FILE* file, const std::string& hexData) {
-    std::vector<std::string> offsets;
-    
+std::vector<u64> findHexDataOffsets(const std::string& filePath, const std::string& hexData, size_t maxMatches = 0) {
+    return findHexDataOffsets(filePath, HexPattern(hexData), maxMatches);
+}
+
+/**
+ * @brief Finds the offsets of a compiled pattern in an open file.
+ *
+ * @param file The open binary file, searched from its current position.
+ * @param pattern The pattern to search for.
+ * @param maxMatches Stops the scan after this many matches, 0 finds all of them.
+ * @return The offsets where the pattern is found, counted from the start position.
+ */
+std::vector<u64> findHexDataOffsetsF(FILE* file, const HexPattern& pattern, size_t maxMatches = 0) {
+    std::vector<u64> offsets;
     
     if (!file) {
         //std::cerr << "Failed to open the file." << std::endl;
         return offsets;
     }
     
-    //size_t fileSize = fileStatus.st_size;
+    HexSearcher(pattern).searchFile(file, [&](u64 offset) {
+        offsets.push_back(offset);
+        return maxMatches == 0 || offsets.size() < maxMatches;
+    });
     
-    // Convert the hex data string to binary data
-    std::vector<unsigned char> binaryData; // Changed to use unsigned char
-    for (size_t i = 0; i < hexData.length(); i += 2) {
-        std::string byteString = hexData.substr(i, 2);
-        unsigned char byte = static_cast<unsigned char>(std::stoi(byteString, nullptr, 16)); // Changed to use unsigned char
-        binaryData.push_back(byte);
+    return offsets;
+}
+
+/**
+ * @brief Finds the offsets of hexadecimal data in an open file.
+ *
+ * This function searches for occurrences of hexadecimal data in a binary file
+ * and returns the file offsets where the data is found.
+ *
+ * @param file The open binary file, searched from its current position.
+ * @param hexData The hexadecimal data to search for, "??" matches any byte.
+ * @param maxMatches Stops the scan after this many matches, 0 finds all of them.
+ * @return The offsets where the data is found, counted from the start position.
+ */
+std::vector<u64> findHexDataOffsetsF(FILE* file, const std::string& hexData, size_t maxMatches = 0) {
+    return findHexDataOffsetsF(file, HexPattern(hexData), maxMatches);
+}
+
+static const std::string hexAnchorCachePath = "sdmc:/config/ultrahand/hex_anchors.cache";
+static constexpr u32 hexAnchorCacheMagic = 0x58484855; // "UHHX"
+static constexpr u32 hexAnchorCacheVersion = 1;
+static constexpr size_t hexFingerprintSize = 4096;
+
+/**
+ * @brief The cached anchor offsets of one binary file, with the identity they were found in.
+ */
+struct HexAnchorFile {
+    u64 fileSize = 0;
+    s64 modifiedTime = 0;
+    u64 fingerprint = 0;
+    bool validated = false; // Compared with the file on the SD card during this session
+    std::unordered_map<u64, u64> offsets; // hexAnchorKey(pattern, occurrence) -> offset
+};
+
+static std::unordered_map<std::string, HexAnchorFile> hexAnchorCache;
+static std::mutex hexAnchorCacheMutex;
+static bool hexAnchorCacheLoaded = false;
+static bool hexAnchorCacheDirty = false;
+
+/**
+ * @brief 64-bit FNV-1a hash, continued from hash.
+ */
+static u64 hashHexData(const void* data, size_t size, u64 hash = 0xCBF29CE484222325ULL) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ULL;
     }
+    return hash;
+}
+
+/**
+ * @brief The cache key of an anchor pattern, as written in the command, and its occurrence.
+ */
+static u64 hexAnchorKey(const std::string& pattern, size_t occurrence) {
+    const u64 occurrenceValue = occurrence;
+    return hashHexData(&occurrenceValue, sizeof(occurrenceValue), hashHexData(pattern.data(), pattern.size()));
+}
+
+/**
+ * @brief Reads the size, mtime and content fingerprint of a file.
+ *
+ * The fingerprint hashes the size with the first and last hexFingerprintSize bytes, so it
+ * costs at most two small reads however large the file is.
+ */
+static bool readHexFileIdentity(const std::string& filePath, HexAnchorFile& identity) {
+    struct stat fileStat;
+    if (stat(filePath.c_str(), &fileStat) != 0)
+        return false;
     
-    // Read the file in chunks to find the offsets where the hex data is located
-    //const size_t bufferSize = 131072;
-    std::vector<unsigned char> buffer(hexBufferSize); // Changed to use unsigned char
-    std::streampos offset = 0;
-    size_t bytesRead = 0; // Changed to size_t
-    std::streampos currentOffset;
-    while ((bytesRead = fread(buffer.data(), sizeof(unsigned char), hexBufferSize, file)) > 0) { // Changed to use unsigned char and size_t
-        for (size_t i = 0; i < bytesRead; i++) {
-            if (std::memcmp(buffer.data() + i, binaryData.data(), binaryData.size()) == 0) {
-                currentOffset = static_cast<std::streampos>(offset) + static_cast<std::streamoff>(i);
-                offsets.push_back(std::to_string(currentOffset));
-            }
+    FILE* file = fopen(filePath.c_str(), "rb");
+    if (!file)
+        return false;
+    
+    identity.fileSize = fileStat.st_size;
+    identity.modifiedTime = fileStat.st_mtime;
+    
+    std::vector<unsigned char> buffer(hexFingerprintSize);
+    u64 hash = hashHexData(&identity.fileSize, sizeof(identity.fileSize));
+    size_t bytesRead = fread(buffer.data(), 1, buffer.size(), file);
+    hash = hashHexData(buffer.data(), bytesRead, hash);
+    
+    if (identity.fileSize > hexFingerprintSize) {
+        if (identity.fileSize > 2 * hexFingerprintSize)
+            fseek(file, -static_cast<long>(hexFingerprintSize), SEEK_END);
+        bytesRead = fread(buffer.data(), 1, buffer.size(), file);
+        hash = hashHexData(buffer.data(), bytesRead, hash);
+    }
+    fclose(file);
+    
+    identity.fingerprint = hash;
+    return true;
+}
+
+/**
+ * @brief Reads the anchor cache from the SD card. Requires hexAnchorCacheMutex to be held.
+ */
+static void loadHexAnchorCache() {
+    hexAnchorCacheLoaded = true;
+    
+    FILE* cacheFile = fopen(hexAnchorCachePath.c_str(), "rb");
+    if (!cacheFile)
+        return;
+    
+    u32 magic = 0, version = 0, fileCount = 0, offsetCount, pathLength;
+    bool valid = fread(&magic, sizeof(magic), 1, cacheFile) == 1 && magic == hexAnchorCacheMagic &&
+                 fread(&version, sizeof(version), 1, cacheFile) == 1 && version == hexAnchorCacheVersion &&
+                 fread(&fileCount, sizeof(fileCount), 1, cacheFile) == 1;
+    
+    std::string filePath;
+    u64 key, offset;
+    for (u32 i = 0; i < fileCount && valid; ++i) {
+        valid = fread(&pathLength, sizeof(pathLength), 1, cacheFile) == 1 && pathLength > 0 && pathLength <= 1024;
+        if (!valid)
+            break;
+        filePath.resize(pathLength);
+        
+        HexAnchorFile entry;
+        valid = fread(&filePath[0], 1, pathLength, cacheFile) == pathLength &&
+                fread(&entry.fileSize, sizeof(entry.fileSize), 1, cacheFile) == 1 &&
+                fread(&entry.modifiedTime, sizeof(entry.modifiedTime), 1, cacheFile) == 1 &&
+                fread(&entry.fingerprint, sizeof(entry.fingerprint), 1, cacheFile) == 1 &&
+                fread(&offsetCount, sizeof(offsetCount), 1, cacheFile) == 1;
+        
+        for (u32 j = 0; j < offsetCount && valid; ++j) {
+            valid = fread(&key, sizeof(key), 1, cacheFile) == 1 && fread(&offset, sizeof(offset), 1, cacheFile) == 1;
+            if (valid)
+                entry.offsets[key] = offset;
         }
-        offset += bytesRead;
+        if (valid)
+            hexAnchorCache[filePath] = std::move(entry);
     }
+    fclose(cacheFile);
     
-    return offsets;
+    if (!valid) {
+        logMessage("Discarding invalid hex anchor cache " + hexAnchorCachePath + ".");
+        hexAnchorCache.clear();
+    }
 }
 
 /**
- * @brief Edits hexadecimal data in a file at a specified offset.
+ * @brief Returns the cache entry of a file after checking it against the file on the SD card.
  *
- * This function opens a binary file, seeks to a specified offset, and replaces
- * the data at that offset with the provided hexadecimal data.
+ * Entries whose file changed size, mtime or fingerprint lose their offsets. Requires
+ * hexAnchorCacheMutex to be held.
+ *
+ * @return The entry, or nullptr if the file cannot be read.
+ */
+static HexAnchorFile* getValidHexAnchorFile(const std::string& filePath) {
+    if (!hexAnchorCacheLoaded)
+        loadHexAnchorCache();
+    
+    struct stat fileStat;
+    if (stat(filePath.c_str(), &fileStat) != 0)
+        return nullptr;
+    
+    HexAnchorFile& entry = hexAnchorCache[filePath];
+    if (entry.validated && entry.fileSize == static_cast<u64>(fileStat.st_size) && entry.modifiedTime == static_cast<s64>(fileStat.st_mtime))
+        return &entry;
+    
+    HexAnchorFile identity;
+    if (!readHexFileIdentity(filePath, identity)) {
+        hexAnchorCache.erase(filePath);
+        return nullptr;
+    }
+    
+    if (identity.fileSize != entry.fileSize || identity.modifiedTime != entry.modifiedTime || identity.fingerprint != entry.fingerprint) {
+        entry.offsets.clear();
+        entry.fileSize = identity.fileSize;
+        entry.modifiedTime = identity.modifiedTime;
+        entry.fingerprint = identity.fingerprint;
+        hexAnchorCacheDirty = true;
+    }
+    entry.validated = true;
+    return &entry;
+}
+
+/**
+ * @brief Looks up the cached offset of an anchor in a file.
  *
  * @param filePath The path to the binary file.
- * @param offsetStr The offset in the file to performthe edit.
- * @param hexData The hexadecimal data to replace at the offset.
+ * @param pattern The anchor as written in the command.
+ * @param occurrence The 0-based occurrence of the anchor.
+ * @param offset Receives the offset of the anchor.
+ * @return True if the offset is cached and the file is unchanged, false otherwise.
+ */
+bool getHexAnchorOffset(const std::string& filePath, const std::string& pattern, size_t occurrence, u64& offset) {
+    std::lock_guard<std::mutex> lock(hexAnchorCacheMutex);
+    
+    HexAnchorFile* entry = getValidHexAnchorFile(filePath);
+    if (!entry)
+        return false;
+    
+    auto it = entry->offsets.find(hexAnchorKey(pattern, occurrence));
+    if (it == entry->offsets.end())
+        return false;
+    offset = it->second;
+    return true;
+}
+
+/**
+ * @brief Stores the offset of an anchor in a file. Call saveHexAnchorCache() to persist it.
  */
-void hexEditByOffset(const std::string& filePath, const std::string& offsetStr, const std::string& hexData) {
-    // Convert the offset string to std::streampos
-    std::streampos offset = std::stoll(offsetStr);
+void setHexAnchorOffset(const std::string& filePath, const std::string& pattern, size_t occurrence, u64 offset) {
+    std::lock_guard<std::mutex> lock(hexAnchorCacheMutex);
     
-    //logMessage(filePath);
-    // Open the file for reading and writing in binary mode
-    FILE* file = fopen(filePath.c_str(), "rb+");
-    if (!file) {
-        logMessage("Failed to open the file.");
+    HexAnchorFile* entry = getValidHexAnchorFile(filePath);
+    if (!entry)
         return;
+    
+    entry->offsets[hexAnchorKey(pattern, occurrence)] = offset;
+    hexAnchorCacheDirty = true;
+}
+
+/**
+ * @brief Forgets the cached anchors of a file after it was patched in place.
+ *
+ * An edit can overwrite an anchor, or create or destroy a match in front of the cached
+ * occurrence, so none of the file's offsets can be trusted afterwards. The entry is
+ * dropped rather than left to the identity check, which a same-size edit within the
+ * mtime resolution could pass.
+ */
+void invalidateHexAnchorFile(const std::string& filePath) {
+    std::lock_guard<std::mutex> lock(hexAnchorCacheMutex);
+    
+    if (!hexAnchorCacheLoaded)
+        loadHexAnchorCache();
+    if (hexAnchorCache.erase(filePath) > 0)
+        hexAnchorCacheDirty = true;
+}
+
+/**
+ * @brief Writes the anchor cache if it changed since it was loaded.
+ *
+ * Files without offsets, and files that were not used during this session and no longer exist,
+ * are dropped.
+ */
+void saveHexAnchorCache() {
+    std::lock_guard<std::mutex> lock(hexAnchorCacheMutex);
+    
+    struct stat fileStat;
+    for (auto it = hexAnchorCache.begin(); it != hexAnchorCache.end();) {
+        if (it->second.offsets.empty() || (!it->second.validated && stat(it->first.c_str(), &fileStat) != 0)) {
+            it = hexAnchorCache.erase(it);
+            hexAnchorCacheDirty = true;
+        } else
+            ++it;
     }
     
-    // Move the file pointer to the specified offset
-    if (fseek(file, offset, SEEK_SET) != 0) {
-        logMessage("Failed to move the file pointer.");
-        fclose(file);
+    if (!hexAnchorCacheDirty)
         return;
-    }
     
-    // Convert the hex data string to binary data
-    std::vector<unsigned char> binaryData; // Changed to use unsigned char
-    std::string byteString;
-    unsigned char byte;
-    for (size_t i = 0; i < hexData.length(); i += 2) {
-        byteString = hexData.substr(i, 2);
-        byte = static_cast<unsigned char>(std::stoi(byteString, nullptr, 16)); // Changed to use unsigned char
-        binaryData.push_back(byte);
+    const std::string tempPath = hexAnchorCachePath + ".tmp";
+    FILE* cacheFile = fopen(tempPath.c_str(), "wb");
+    if (!cacheFile) {
+        logMessage("Failed to open " + tempPath + " for writing.");
+        return;
     }
     
-    // Calculate the number of bytes to be replaced
-    size_t bytesToReplace = binaryData.size();
+    const u32 fileCount = hexAnchorCache.size();
+    bool success = fwrite(&hexAnchorCacheMagic, sizeof(hexAnchorCacheMagic), 1, cacheFile) == 1 &&
+                   fwrite(&hexAnchorCacheVersion, sizeof(hexAnchorCacheVersion), 1, cacheFile) == 1 &&
+                   fwrite(&fileCount, sizeof(fileCount), 1, cacheFile) == 1;
+    
+    u32 pathLength, offsetCount;
+    for (const auto& [filePath, entry] : hexAnchorCache) {
+        if (!success)
+            break;
+        pathLength = filePath.size();
+        offsetCount = entry.offsets.size();
+        success = fwrite(&pathLength, sizeof(pathLength), 1, cacheFile) == 1 &&
+                  fwrite(filePath.data(), 1, pathLength, cacheFile) == pathLength &&
+                  fwrite(&entry.fileSize, sizeof(entry.fileSize), 1, cacheFile) == 1 &&
+                  fwrite(&entry.modifiedTime, sizeof(entry.modifiedTime), 1, cacheFile) == 1 &&
+                  fwrite(&entry.fingerprint, sizeof(entry.fingerprint), 1, cacheFile) == 1 &&
+                  fwrite(&offsetCount, sizeof(offsetCount), 1, cacheFile) == 1;
+        
+        for (const auto& [key, offset] : entry.offsets) {
+            if (!success)
+                break;
+            success = fwrite(&key, sizeof(key), 1, cacheFile) == 1 && fwrite(&offset, sizeof(offset), 1, cacheFile) == 1;
+        }
+    }
     
-    // Read the existing data from the file
-    std::vector<unsigned char> existingData(bytesToReplace); // Changed to use unsigned char
-    if (fread(existingData.data(), sizeof(unsigned char), bytesToReplace, file) != bytesToReplace) { // Changed to use unsigned char
-        logMessage("Failed to read existing data from the file.");
-        fclose(file);
+    success = (fclose(cacheFile) == 0) && success;
+    if (!success) {
+        logMessage("Failed to write " + tempPath + ".");
+        remove(tempPath.c_str());
         return;
     }
     
-    // Move the file pointer back to the offset
-    if (fseek(file, offset, SEEK_SET) != 0) {
-        logMessage("Failed to move the file pointer.");
-        fclose(file);
+    remove(hexAnchorCachePath.c_str());
+    if (rename(tempPath.c_str(), hexAnchorCachePath.c_str()) != 0) {
+        logMessage("Failed to rename " + tempPath + " to " + hexAnchorCachePath + ".");
         return;
     }
+    hexAnchorCacheDirty = false;
+}
+
+/**
+ * @brief Saves the anchor cache and frees its memory, it is reloaded on the next lookup.
+ */
+void releaseHexAnchorCache() {
+    saveHexAnchorCache();
     
-    // Write the replacement binary data to the file
-    if (fwrite(binaryData.data(), sizeof(unsigned char), bytesToReplace, file) != bytesToReplace) { // Changed to use unsigned char
-        logMessage("Failed to write data to the file.");
-        fclose(file);
-        return;
+    std::lock_guard<std::mutex> lock(hexAnchorCacheMutex);
+    hexAnchorCache.clear();
+    hexAnchorCacheLoaded = false;
+}
+
+/**
+ * @brief Forgets all cached anchor offsets, in memory and on the SD card.
+ */
+void clearHexAnchorCache() {
+    std::lock_guard<std::mutex> lock(hexAnchorCacheMutex);
+    hexAnchorCache.clear();
+    hexAnchorCacheLoaded = true;
+    hexAnchorCacheDirty = false;
+    remove(hexAnchorCachePath.c_str());
+}
+
+/**
+ * @brief Adds the anchors that are not in the anchor cache yet to a multi-pattern searcher.
+ *
+ * @param patterns Receives the pattern strings of the added anchors, in searcher order.
+ */
+static void addUncachedHexAnchors(const std::string& filePath, const std::vector<std::pair<std::string, HexPattern>>& anchors, HexMultiSearcher& searcher, std::vector<std::string>& patterns) {
+    u64 cachedOffset;
+    for (const auto& anchor : anchors) {
+        if (anchor.second.empty() || getHexAnchorOffset(filePath, anchor.first, 0, cachedOffset) ||
+            std::find(patterns.begin(), patterns.end(), anchor.first) != patterns.end())
+            continue;
+        
+        searcher.addPattern(anchor.second);
+        patterns.push_back(anchor.first);
     }
+}
+
+/**
+ * @brief Stores the first offset of every searcher pattern in the anchor cache, in one pass through an open file.
+ */
+static void searchHexAnchorsF(FILE* file, const std::string& filePath, const HexMultiSearcher& searcher, const std::vector<std::string>& patterns) {
+    if (patterns.empty() || fseek(file, 0, SEEK_SET) != 0)
+        return;
     
-    fclose(file);
-    //logMessage("Hex editing completed.");
+    std::vector<bool> found(patterns.size(), false);
+    size_t remaining = patterns.size();
+    
+    searcher.searchFile(file, [&](size_t index, u64 offset) {
+        if (!found[index]) {
+            found[index] = true;
+            setHexAnchorOffset(filePath, patterns[index], 0, offset);
+            --remaining;
+        }
+        return remaining > 0;
+    });
 }
 
 /**
- * @brief Edits a specific offset in a file with custom hexadecimal data.
+ * @brief Resolves the first occurrence of several anchors in a file with a single read.
  *
- * This function searches for a custom pattern in the file and calculates a new offset
- * based on user-provided offsetStr and the found pattern. It then replaces the data
- * at the calculated offset with the provided hexadecimal data.
+ * Anchors that are already cached, or failed to compile, are skipped. The found offsets are
+ * stored in the anchor cache, so the lookups of hexEditByCustomOffset and
+ * parseHexDataAtCustomOffset no longer scan the file.
  *
  * @param filePath The path to the binary file.
- * @param offsetStr The user-provided offset for the edit.
- * @param customPattern The custom pattern to search for in the file.
- * @param hexDataReplacement The hexadecimal data to replace at the calculated offset.
- * @param occurrence The occurrence/index of the data to replace (default is "0" to replace all occurrences).
+ * @param anchors Pairs of the pattern as written in the command and its compiled pattern.
  */
-void hexEditByCustomOffset(const std::string& filePath, const std::string& customAsciiPattern, const std::string& offsetStr, const std::string& hexDataReplacement, size_t occurrence = 0) {
-    
-    // Create a cache key based on filePath and customAsciiPattern
-    std::string cacheKey = filePath + '?' + customAsciiPattern + '?' + std::to_string(occurrence);
-    
-    int hexSum = -1;
-    
-    // Check if the result is already cached
-    auto cachedResult = hexSumCache.find(cacheKey);
-    if (cachedResult != hexSumCache.end()) {
-        hexSum = std::stoi(cachedResult->second); // load sum from cache
-    }
+void prefetchHexSums(const std::string& filePath, const std::vector<std::pair<std::string, HexPattern>>& anchors) {
+    HexMultiSearcher searcher;
+    std::vector<std::string> patterns;
+    addUncachedHexAnchors(filePath, anchors, searcher, patterns);
     
-    if (hexSum == -1) {
-        std::string customHexPattern;
-        if (customAsciiPattern[0] == '#') {
-            // remove #
-            customHexPattern = customAsciiPattern.substr(1);
-        } else {
-            // Convert custom ASCII pattern to a custom hex pattern
-            customHexPattern = asciiToHex(customAsciiPattern);
-        }
-        
-        
-        // Find hex data offsets in the file
-        std::vector<std::string> offsets = findHexDataOffsets(filePath, customHexPattern);
-        
-        if (!offsets.empty()) {
-            hexSum = std::stoi(offsets[occurrence]);
-            
-            // Convert 'hexSum' to a string and add it to the cache
-            hexSumCache[cacheKey] = std::to_string(hexSum);
-        } else {
-            logMessage("Offset not found.");
-            return;
-        }
-    }
+    // A single anchor costs the same when resolved by its own lookup
+    if (patterns.size() < 2)
+        return;
     
+    FILE* file = fopen(filePath.c_str(), "rb");
+    if (!file)
+        return;
     
-    if (hexSum != -1) {
-        // Calculate the total offset to seek in the file
-        int sum = hexSum + std::stoi(offsetStr);
-        hexEditByOffset(filePath, std::to_string(sum), hexDataReplacement);
-    } else {
-        logMessage("Failed to find " + customAsciiPattern + ".");
-    }
+    searchHexAnchorsF(file, filePath, searcher, patterns);
+    fclose(file);
 }
 
+static const std::string hexJournalDirectory = "sdmc:/config/ultrahand/journals/";
+static constexpr u32 hexJournalMagic = 0x4A484855; // "UHHJ"
+static constexpr u32 hexJournalVersion = 1;
+
 /**
- * @brief Finds and replaces hexadecimal data in a file.
+ * @brief Returns the path of the undo journal of a binary file.
  *
- * This function searches for occurrences of hexadecimal data in a binary file
- * and replaces them with a specified hexadecimal replacement data.
+ * Journals live under hexJournalDirectory, named by a hash of the file path, so nothing is
+ * written next to the patched file.
+ */
+std::string getHexJournalPath(const std::string& filePath) {
+    char journalName[32];
+    snprintf(journalName, sizeof(journalName), "%016llX.journal", static_cast<unsigned long long>(hashHexData(filePath.data(), filePath.size())));
+    return hexJournalDirectory + journalName;
+}
+
+/**
+ * @brief Opens the undo journal of a binary file for appending, creating it if needed.
  *
- * @param filePath The path to the binary file.
- * @param hexDataToReplace The hexadecimal data to search for and replace.
- * @param hexDataReplacement The hexadecimal data to replace with.
- * @param occurrence The occurrence/index of the data to replace (default is "0" to replace all occurrences).
+ * New journals start with a header holding the file path and size, which revertHexJournal()
+ * checks before restoring anything.
+ *
+ * @return The open journal, or nullptr on failure.
  */
-void hexEditFindReplace(const std::string& filePath, const std::string& hexDataToReplace, const std::string& hexDataReplacement, size_t occurrence = 0) {
-    std::vector<std::string> offsetStrs = findHexDataOffsets(filePath, hexDataToReplace);
-    if (!offsetStrs.empty()) {
-        if (occurrence == 0) {
-            // Replace all occurrences
-            for (const std::string& offsetStr : offsetStrs) {
-                //logMessage("offsetStr: "+offsetStr);
-                //logMessage("hexDataReplacement: "+hexDataReplacement);
-                hexEditByOffset(filePath, offsetStr, hexDataReplacement);
-            }
-        } else {
-            // Convert the occurrence string to an integer
-            if (occurrence > 0 && occurrence <= offsetStrs.size()) {
-                // Replace the specified occurrence/index
-                std::string offsetStr = offsetStrs[occurrence - 1];
-                //logMessage("offsetStr: "+offsetStr);
-                //logMessage("hexDataReplacement: "+hexDataReplacement);
-                hexEditByOffset(filePath, offsetStr, hexDataReplacement);
-            } else {
-                // Invalid occurrence/index specified
-                //std::cout << "Invalid occurrence/index specified." << std::endl;
-            }
-        }
-        //std::cout << "Hex data replaced successfully." << std::endl;
+static FILE* openHexJournal(const std::string& filePath, u64 fileSize) {
+    mkdir(hexJournalDirectory.c_str(), 0777);
+    
+    const std::string journalPath = getHexJournalPath(filePath);
+    FILE* journalFile = fopen(journalPath.c_str(), "ab");
+    if (!journalFile) {
+        logMessage("Failed to open " + journalPath + " for writing.");
+        return nullptr;
     }
-    else {
-        //std::cout << "Hex data to replace not found." << std::endl;
+    
+    fseek(journalFile, 0, SEEK_END);
+    if (ftell(journalFile) == 0) {
+        const u32 pathLength = filePath.size();
+        if (fwrite(&hexJournalMagic, sizeof(hexJournalMagic), 1, journalFile) != 1 ||
+            fwrite(&hexJournalVersion, sizeof(hexJournalVersion), 1, journalFile) != 1 ||
+            fwrite(&pathLength, sizeof(pathLength), 1, journalFile) != 1 ||
+            fwrite(filePath.data(), 1, pathLength, journalFile) != pathLength ||
+            fwrite(&fileSize, sizeof(fileSize), 1, journalFile) != 1) {
+            logMessage("Failed to write " + journalPath + ".");
+            fclose(journalFile);
+            return nullptr;
+        }
     }
+    return journalFile;
 }
 
 /**
- * @brief Finds and replaces hexadecimal data in a file.
+ * @brief Collects edits to one binary file and writes them through a single handle.
  *
- * This function searches for occurrences of hexadecimal data in a binary file
- * and replaces them with a specified hexadecimal replacement data.
+ * Edits are queued and written when the session is flushed: they are sorted by offset, merged
+ * into contiguous runs and each run is read and written once. Later edits win where edits overlap,
+ * and "??" in the replacement data keeps the byte already in the file.
  *
- * @param filePath The path to the binary file.
- * @param hexDataToReplace The hexadecimal data to search for and replace.
- * @param hexDataReplacement The hexadecimal data to replace with.
- * @param occurrence The occurrence/index of the data to replace (default is "0" to replace all occurrences).
+ * Searches made through the session flush the pending edits first, so every command sees the
+ * file exactly as if the edits before it had been written one by one.
+ *
+ * With journaling enabled, the original bytes of every run are appended to the file's undo
+ * journal before the run is written, and revertHexJournal() can restore them later.
  */
-std::string parseHexDataAtCustomOffset(const std::string& filePath, const std::string& customAsciiPattern, const std::string& offsetStr, size_t length, size_t occurrence = 0) {
+class HexPatchSession {
+public:
+    /**
+     * @param filePath The file to patch.
+     * @param journaling Records the original bytes in the file's hex undo journal.
+     * @param verifyOnly Opens the file read-only, for sessions that only search or verify().
+     */
+    explicit HexPatchSession(const std::string& filePath, bool journaling = false, bool verifyOnly = false) :
+        filePath(filePath), journaling(journaling), verifyOnly(verifyOnly) {
+        file = fopen(filePath.c_str(), verifyOnly ? "rb" : "rb+");
+        if (!file)
+            logMessage("Failed to open the file.");
+    }
     
-    // Create a cache key based on filePath and customAsciiPattern
-    std::string cacheKey = filePath + '?' + customAsciiPattern + '?' + std::to_string(occurrence);
+    ~HexPatchSession() {
+        commit();
+    }
+    
+    HexPatchSession(const HexPatchSession&) = delete;
+    HexPatchSession& operator=(const HexPatchSession&) = delete;
+    
+    const std::string& getFilePath() const {
+        return filePath;
+    }
     
-    int hexSum = -1;
+    bool isOpen() const {
+        return file != nullptr;
+    }
     
-    // Check if the result is already cached
-    auto cachedResult = hexSumCache.find(cacheKey);
-    if (cachedResult != hexSumCache.end()) {
-        hexSum = std::stoi(cachedResult->second); // load sum from cache
+    /**
+     * @brief Queues data to be written at an offset.
+     */
+    void addEdit(u64 offset, HexPattern data) {
+        if (!file || data.empty())
+            return;
+        pendingEdits.push_back({offset, pendingEdits.size(), std::move(data)});
     }
     
-    if (hexSum == -1) {
-        // Convert custom ASCII pattern to a custom hex pattern
-        std::string customHexPattern = asciiToHex(customAsciiPattern);
+    /**
+     * @brief Queues a replacement for occurrences of a pattern.
+     *
+     * @param find The pattern to search for.
+     * @param replacement The data to write at each occurrence.
+     * @param occurrence The 1-based occurrence to replace, 0 replaces all occurrences.
+     * @return The number of queued replacements.
+     */
+    size_t addFindReplace(const HexPattern& find, const HexPattern& replacement, size_t occurrence = 0) {
+        if (!file || find.empty())
+            return 0;
         
-        // Find hex data offsets in the file
-        std::vector<std::string> offsets = findHexDataOffsets(filePath, customHexPattern);
+        std::vector<u64> offsets = search(find, occurrence);
+        if (occurrence == 0) {
+            for (u64 offset : offsets)
+                addEdit(offset, replacement);
+            return offsets.size();
+        }
         
-        if (!offsets.empty()) {
-            hexSum = std::stoi(offsets[occurrence]);
-            
-            // Convert 'hexSum' to a string and add it to the cache
-            hexSumCache[cacheKey] = std::to_string(hexSum);
-        } else {
+        if (offsets.size() < occurrence)
+            return 0;
+        addEdit(offsets[occurrence - 1], replacement);
+        return 1;
+    }
+    
+    /**
+     * @brief Queues data to be written relative to an anchor found in the file.
+     *
+     * Anchor offsets are looked up in and stored to the anchor cache.
+     *
+     * @param customPattern The anchor, '#' marks a hexadecimal pattern.
+     * @param relativeOffset The offset of the edit from the start of the anchor.
+     * @param data The data to write.
+     * @param occurrence The 0-based occurrence of the anchor.
+     * @return True if the anchor was found, false otherwise.
+     */
+    bool addCustomOffsetEdit(const std::string& customPattern, s64 relativeOffset, HexPattern data, size_t occurrence = 0) {
+        if (!file)
+            return false;
+        
+        u64 hexSum;
+        if (!getHexAnchorOffset(filePath, customPattern, occurrence, hexSum)) {
+            std::vector<u64> offsets = search(compileCustomPattern(customPattern), occurrence + 1);
+            if (offsets.size() <= occurrence) {
+                logMessage("Offset not found.");
+                return false;
+            }
+            hexSum = offsets[occurrence];
+            setHexAnchorOffset(filePath, customPattern, occurrence, hexSum);
+        }
+        
+        if (relativeOffset < 0 && static_cast<u64>(-relativeOffset) > hexSum) {
             logMessage("Offset not found.");
-            return "";
+            return false;
         }
+        addEdit(hexSum + static_cast<u64>(relativeOffset), std::move(data));
+        return true;
     }
     
-    // Calculate the total offset to seek in the file
-    int sum = hexSum + std::stoi(offsetStr);
+    /**
+     * @brief Writes all pending edits.
+     *
+     * @return True if every edit was written, false otherwise.
+     */
+    bool flush() {
+        if (!file || pendingEdits.empty())
+            return file != nullptr;
+        
+        if (verifyOnly) {
+            logMessage("Cannot write to " + filePath + ", it was opened for verification.");
+            pendingEdits.clear();
+            return false;
+        }
+        
+        bool changedData = false;
+        const bool success = processPendingEdits([this, &changedData](u64 runStart, const std::vector<unsigned char>& originalData, const std::vector<unsigned char>& patchedData) {
+            if (originalData == patchedData)
+                return true; // Already patched, nothing to write
+            changedData = true;
+            
+            // Journal the original bytes before they are overwritten
+            if (journaling && !appendJournalRecord(runStart, originalData)) {
+                logMessage("Failed to write the hex journal of " + filePath + ".");
+                return false;
+            }
+            
+            if (fseek(file, static_cast<long>(runStart), SEEK_SET) != 0 ||
+                fwrite(patchedData.data(), 1, patchedData.size(), file) != patchedData.size()) {
+                logMessage("Failed to write data to the file.");
+                return false;
+            }
+            return true;
+        });
+        fflush(file);
+        
+        // The written bytes may overwrite an anchor or change which match is occurrence N
+        if (changedData)
+            invalidateHexAnchorFile(filePath);
+        return success;
+    }
     
+    /**
+     * @brief Checks whether the pending edits are already in the file, then discards them.
+     *
+     * @return True if writing the pending edits would not change the file, false otherwise.
+     */
+    bool verify() {
+        if (!file)
+            return false;
+        
+        return processPendingEdits([](u64, const std::vector<unsigned char>& originalData, const std::vector<unsigned char>& patchedData) {
+            return originalData == patchedData;
+        });
+    }
     
-    // Open the file for reading in binary mode
-    FILE* file = fopen(filePath.c_str(), "rb");
-    if (!file) {
-        logMessage("Failed to open the file.");
-        return "";
+    /**
+     * @brief Drops all pending edits without writing them.
+     */
+    void discard() {
+        pendingEdits.clear();
+    }
+    
+    /**
+     * @brief Checks that every pending edit lies within the file, before anything is written.
+     *
+     * @return True if no pending edit reaches past the end of the file, false otherwise.
+     */
+    bool pendingEditsFit() {
+        if (!file)
+            return false;
+        
+        struct stat fileStat;
+        if (fstat(fileno(file), &fileStat) != 0)
+            return false;
+        
+        const u64 fileSize = static_cast<u64>(fileStat.st_size);
+        for (const HexEdit& edit : pendingEdits) {
+            if (edit.offset > fileSize || edit.data.size() > fileSize - edit.offset)
+                return false;
+        }
+        return true;
     }
     
-    // Seek to the specified offset
-    if (fseek(file, sum, SEEK_SET) != 0) {
-        logMessage("Error seeking to offset.");
+    /**
+     * @brief Writes all pending edits and closes the file.
+     *
+     * @return True if every edit was written, false otherwise.
+     */
+    bool commit() {
+        if (!file)
+            return false;
+        
+        const bool success = flush();
         fclose(file);
-        return "";
+        file = nullptr;
+        
+        if (journalFile) {
+            fclose(journalFile);
+            journalFile = nullptr;
+        }
+        return success;
+    }
+
+private:
+    struct HexEdit {
+        u64 offset;
+        size_t sequence;
+        HexPattern data;
+    };
+    
+    /**
+     * @brief Finds up to maxMatches offsets of a pattern (0 for all) after flushing pending edits.
+     */
+    std::vector<u64> search(const HexPattern& pattern, size_t maxMatches = 0) {
+        std::vector<u64> offsets;
+        flush();
+        if (fseek(file, 0, SEEK_SET) != 0)
+            return offsets;
+        
+        HexSearcher(pattern).searchFile(file, [&](u64 offset) {
+            offsets.push_back(offset);
+            return maxMatches == 0 || offsets.size() < maxMatches;
+        });
+        return offsets;
     }
     
-    char hexBuffer[length];
-    char hexDigits[] = "0123456789ABCDEF";
-    char* hexStream = new char[length * 2];  // Allocate memory for the result
+    /**
+     * @brief Sorts the pending edits, merges them into runs and hands each run to onRun.
+     *
+     * Edits that overlap or touch form one run, whose existing bytes are read once. The edits
+     * are applied to a copy in the order they were queued, and onRun is called as
+     * onRun(runStart, originalData, patchedData). Edits past the end of the file are refused.
+     * The pending edits are cleared afterwards.
+     *
+     * @return True if every edit was read and onRun succeeded for every run, false otherwise.
+     */
+    template <typename RunHandler>
+    bool processPendingEdits(RunHandler&& onRun) {
+        // Sort by offset, keeping the queue order of edits at the same offset
+        std::sort(pendingEdits.begin(), pendingEdits.end(), [](const HexEdit& a, const HexEdit& b) {
+            return a.offset != b.offset ? a.offset < b.offset : a.sequence < b.sequence;
+        });
+        
+        bool success = true;
+        std::vector<const HexEdit*> runEdits;
+        std::vector<unsigned char> originalData, patchedData;
+        u64 runStart, runEnd;
+        size_t i = 0;
+        
+        while (i < pendingEdits.size()) {
+            // Merge all edits that overlap or touch into one run
+            runStart = pendingEdits[i].offset;
+            runEnd = runStart + pendingEdits[i].data.size();
+            runEdits.clear();
+            while (i < pendingEdits.size() && pendingEdits[i].offset <= runEnd) {
+                runEnd = std::max(runEnd, pendingEdits[i].offset + pendingEdits[i].data.size());
+                runEdits.push_back(&pendingEdits[i]);
+                ++i;
+            }
+            
+            // Read the existing data of the run, edits never extend the file
+            originalData.resize(runEnd - runStart);
+            if (fseek(file, static_cast<long>(runStart), SEEK_SET) != 0) {
+                logMessage("Failed to move the file pointer.");
+                success = false;
+                continue;
+            }
+            originalData.resize(fread(originalData.data(), 1, originalData.size(), file));
+            patchedData = originalData;
+            
+            // Apply the edits in the order they were queued
+            std::sort(runEdits.begin(), runEdits.end(), [](const HexEdit* a, const HexEdit* b) {
+                return a->sequence < b->sequence;
+            });
+            for (const HexEdit* edit : runEdits) {
+                if (edit->offset + edit->data.size() > runStart + patchedData.size()) {
+                    logMessage("Failed to read existing data from the file.");
+                    success = false;
+                    continue;
+                }
+                unsigned char* target = patchedData.data() + (edit->offset - runStart);
+                for (size_t j = 0; j < edit->data.size(); ++j)
+                    target[j] = (target[j] & ~edit->data.mask[j]) | edit->data.bytes[j];
+            }
+            
+            if (!originalData.empty() && !onRun(runStart, originalData, patchedData))
+                success = false;
+        }
+        
+        pendingEdits.clear();
+        return success;
+    }
     
-    size_t bytesRead = fread(hexBuffer, 1, length, file);
-    if (bytesRead == length) {
-        for (size_t i = 0; i < length; ++i) {
-            hexStream[i * 2] = hexDigits[(hexBuffer[i] >> 4) & 0xF];
-            hexStream[i * 2 + 1] = hexDigits[hexBuffer[i] & 0xF];
+    /**
+     * @brief Appends the original bytes at an offset to the undo journal.
+     */
+    bool appendJournalRecord(u64 offset, const std::vector<unsigned char>& data) {
+        if (!journalFile) {
+            struct stat fileStat;
+            if (stat(filePath.c_str(), &fileStat) != 0)
+                return false;
+            journalFile = openHexJournal(filePath, fileStat.st_size);
+            if (!journalFile)
+                return false;
         }
-    } else if (feof(file)) {
-        logMessage("End of file reached.");
-    } else if (ferror(file)) {
-        logMessage("Error reading data from file: " + std::to_string(errno));
+        
+        const u32 length = data.size();
+        return fwrite(&offset, sizeof(offset), 1, journalFile) == 1 &&
+               fwrite(&length, sizeof(length), 1, journalFile) == 1 &&
+               fwrite(data.data(), 1, length, journalFile) == length &&
+               fflush(journalFile) == 0;
     }
     
+    std::string filePath;
+    FILE* file = nullptr;
+    std::vector<HexEdit> pendingEdits;
+    bool journaling = false;
+    bool verifyOnly = false;
+    FILE* journalFile = nullptr;
+};
+
+/**
+ * @brief Restores the bytes recorded in the undo journal of a file and deletes the journal.
+ *
+ * Records are restored through one patch session, so the oldest bytes of every range win and
+ * only the journaled ranges are read and written.
+ *
+ * @param filePath The path to the binary file.
+ * @return True if the file was restored, false otherwise.
+ */
+bool revertHexJournal(const std::string& filePath) {
+    const std::string journalPath = getHexJournalPath(filePath);
+    FILE* journalFile = fopen(journalPath.c_str(), "rb");
+    if (!journalFile) {
+        logMessage("No hex journal for " + filePath + ".");
+        return false;
+    }
     
-    // Close the file
-    fclose(file);
+    u32 magic = 0, version = 0, pathLength = 0, length;
+    u64 fileSize = 0, offset;
+    std::string journaledPath;
+    bool valid = fread(&magic, sizeof(magic), 1, journalFile) == 1 && magic == hexJournalMagic &&
+                 fread(&version, sizeof(version), 1, journalFile) == 1 && version == hexJournalVersion &&
+                 fread(&pathLength, sizeof(pathLength), 1, journalFile) == 1 && pathLength <= 1024;
+    if (valid) {
+        journaledPath.resize(pathLength);
+        valid = fread(&journaledPath[0], 1, pathLength, journalFile) == pathLength &&
+                fread(&fileSize, sizeof(fileSize), 1, journalFile) == 1;
+    }
+    
+    struct stat fileStat;
+    if (!valid || journaledPath != filePath || stat(filePath.c_str(), &fileStat) != 0 || static_cast<u64>(fileStat.st_size) != fileSize) {
+        logMessage("Hex journal " + journalPath + " does not match " + filePath + ".");
+        fclose(journalFile);
+        return false;
+    }
+    
+    // A record cut short by an interrupted append was never followed by its write, so it is dropped
+    std::vector<std::pair<u64, HexPattern>> records;
+    std::vector<unsigned char> data;
+    while (fread(&offset, sizeof(offset), 1, journalFile) == 1 && fread(&length, sizeof(length), 1, journalFile) == 1 &&
+           offset + length <= fileSize) {
+        data.resize(length);
+        if (fread(data.data(), 1, length, journalFile) != length)
+            break;
+        records.emplace_back(offset, HexPattern::fromBytes(data.data(), length));
+    }
+    fclose(journalFile);
     
-    // Convert lowercase hex to uppercase and return the result
-    std::string result(hexStream, length * 2);
-    std::transform(result.begin(), result.end(), result.begin(), ::toupper);
+    // Newer records are queued first so that the oldest original bytes are written last
+    HexPatchSession session(filePath);
+    for (auto it = records.rbegin(); it != records.rend(); ++it)
+        session.addEdit(it->first, std::move(it->second));
     
-    delete[] hexStream;
+    if (!session.commit())
+        return false;
     
-    return result;
+    remove(journalPath.c_str());
+    return true;
 }
 
+/**
+ * @brief Accepts the edits recorded in the undo journal of a file by deleting the journal.
+ *
+ * @param filePath The path to the binary file.
+ */
+void commitHexJournal(const std::string& filePath) {
+    remove(getHexJournalPath(filePath).c_str());
+}
+
+/**
+ * @brief Edits hexadecimal data in a file at a specified offset.
+ *
+ * This function opens a binary file, seeks to a specified offset, and replaces
+ * the data at that offset with the provided hexadecimal data.
+ *
+ * @param filePath The path to the binary file.
+ * @param offset The offset in the file to perform the edit.
+ * @param hexData The hexadecimal data to replace at the offset, "??" keeps the existing byte.
+ */
+void hexEditByOffset(const std::string& filePath, u64 offset, const std::string& hexData) {
+    HexPatchSession session(filePath);
+    session.addEdit(offset, HexPattern(hexData));
+    session.commit();
+}
+
+/**
+ * @brief Edits a specific offset in a file with custom hexadecimal data.
+ *
+ * This function searches for a custom pattern in the file and calculates a new offset
+ * based on the relative offset and the found pattern. It then replaces the data
+ * at the calculated offset with the provided hexadecimal data.
+ *
+ * @param filePath The path to the binary file.
+ * @param relativeOffset The offset of the edit from the start of the pattern.
+ * @param customPattern The custom pattern to search for in the file.
+ * @param hexDataReplacement The hexadecimal data to replace at the calculated offset.
+ * @param occurrence The occurrence/index of the data to replace (default is "0" to replace all occurrences).
+ */
+void hexEditByCustomOffset(const std::string& filePath, const std::string& customAsciiPattern, s64 relativeOffset, const std::string& hexDataReplacement, size_t occurrence = 0) {
+    HexPatchSession session(filePath);
+    if (session.isOpen() && !session.addCustomOffsetEdit(customAsciiPattern, relativeOffset, HexPattern(hexDataReplacement), occurrence))
+        logMessage("Failed to find " + customAsciiPattern + ".");
+    session.commit();
+}
 
 /**
  * @brief Finds and replaces hexadecimal data in a file.
@@ -497,132 +1571,333 @@ std::string parseHexDataAtCustomOffset(const std::string& filePath, const std::s
  * @param hexDataReplacement The hexadecimal data to replace with.
  * @param occurrence The occurrence/index of the data to replace (default is "0" to replace all occurrences).
  */
-std::string parseHexDataAtCustomOffsetF(FILE*& file, const std::string& filePath, const std::string& customAsciiPattern, const std::string& offsetStr, size_t length, size_t occurrence = 0) {
-    
-    // Create a cache key based on filePath and customAsciiPattern
-    std::string cacheKey = filePath + '?' + customAsciiPattern + '?' + std::to_string(occurrence);
-    
-    int hexSum = -1;
-    
-    // Check if the result is already cached
-    auto cachedResult = hexSumCache.find(cacheKey);
-    if (cachedResult != hexSumCache.end()) {
-        hexSum = std::stoi(cachedResult->second); // load sum from cache
-    }
-    
-    if (hexSum == -1) {
-        // Convert custom ASCII pattern to a custom hex pattern
-        std::string customHexPattern = asciiToHex(customAsciiPattern);
-        
-        // Find hex data offsets in the file
-        std::vector<std::string> offsets = findHexDataOffsetsF(file, customHexPattern);
-        
-        if (!offsets.empty()) {
-            hexSum = std::stoi(offsets[occurrence]);
-            
-            // Convert 'hexSum' to a string and add it to the cache
-            hexSumCache[cacheKey] = std::to_string(hexSum);
-        } else {
-            logMessage("Offset not found.");
-            return "";
+void hexEditFindReplace(const std::string& filePath, const std::string& hexDataToReplace, const std::string& hexDataReplacement, size_t occurrence = 0) {
+    HexPatchSession session(filePath);
+    session.addFindReplace(HexPattern(hexDataToReplace), HexPattern(hexDataReplacement), occurrence);
+    session.commit();
+}
+
+/**
+ * @brief Uppercase hexadecimal digit pairs of all byte values.
+ */
+struct HexDigitTable {
+    char pairs[512];
+    
+    constexpr HexDigitTable() : pairs() {
+        constexpr char hexDigits[] = "0123456789ABCDEF";
+        for (size_t i = 0; i < 256; ++i) {
+            pairs[i * 2] = hexDigits[i >> 4];
+            pairs[i * 2 + 1] = hexDigits[i & 0xF];
         }
     }
-    
-    // Calculate the total offset to seek in the file
-    int sum = hexSum + std::stoi(offsetStr);
-    
-    
-    // Open the file for reading in binary mode
-    //FILE* file = fopen(filePath.c_str(), "rb");
+};
+
+static constexpr HexDigitTable hexDigitTable;
+
+/**
+ * @brief Appends the uppercase hexadecimal encoding of binary data to a string.
+ */
+inline void appendHexString(std::string& output, const unsigned char* data, size_t size) {
+    const size_t start = output.size();
+    output.resize(start + size * 2);
+    char* hexStream = &output[start];
+    for (size_t i = 0; i < size; ++i)
+        std::memcpy(hexStream + i * 2, hexDigitTable.pairs + data[i] * 2, 2);
+}
+
+/**
+ * @brief A read of data relative to an anchor, as in a {hex_file(...)} placeholder.
+ */
+struct HexPlaceholderRead {
+    std::string customPattern;  // The anchor, '#' marks a hexadecimal pattern
+    s64 relativeOffset = 0;
+    size_t length = 0;
+    size_t occurrence = 0;      // 0-based occurrence of the anchor
+    std::string result;         // Uppercase hexadecimal data, empty if the read failed
+};
+
+// Reads closer together than this share one fread
+static constexpr size_t hexReadMergeGap = 4096;
+
+/**
+ * @brief Performs several anchored reads on an open file.
+ *
+ * Anchors come from the anchor cache, and all uncached first occurrences are found in one
+ * pass. The reads are then sorted by offset, and reads that are close together are served
+ * from one fread into a shared buffer.
+ *
+ * @param file The binary file, opened for reading.
+ * @param filePath The path of the file, used for the anchor cache.
+ * @param reads The reads to perform, their results are filled in.
+ * @return True if every read succeeded, false otherwise.
+ */
+bool readHexPlaceholdersF(FILE* file, const std::string& filePath, std::vector<HexPlaceholderRead>& reads) {
     if (!file) {
         logMessage("Failed to open the file.");
-        return "";
+        return false;
     }
     
-    // Seek to the specified offset
-    if (fseek(file, sum, SEEK_SET) != 0) {
-        logMessage("Error seeking to offset.");
-        //fclose(file);
-        return "";
+    // Resolve all uncached first occurrences in a single pass
+    std::vector<std::pair<std::string, HexPattern>> anchors;
+    for (const auto& read : reads) {
+        if (read.occurrence == 0)
+            anchors.emplace_back(read.customPattern, compileCustomPattern(read.customPattern));
     }
-    
-    char hexBuffer[length];
-    char hexDigits[] = "0123456789ABCDEF";
-    char* hexStream = new char[length * 2];  // Allocate memory for the result
-    
-    size_t bytesRead = fread(hexBuffer, 1, length, file);
-    if (bytesRead == length) {
-        for (size_t i = 0; i < length; ++i) {
-            hexStream[i * 2] = hexDigits[(hexBuffer[i] >> 4) & 0xF];
-            hexStream[i * 2 + 1] = hexDigits[hexBuffer[i] & 0xF];
+    HexMultiSearcher searcher;
+    std::vector<std::string> patterns;
+    addUncachedHexAnchors(filePath, anchors, searcher, patterns);
+    searchHexAnchorsF(file, filePath, searcher, patterns);
+    
+    std::vector<u64> offsets(reads.size(), 0);
+    std::vector<size_t> order;
+    order.reserve(reads.size());
+    u64 hexSum;
+    
+    for (size_t i = 0; i < reads.size(); ++i) {
+        HexPlaceholderRead& read = reads[i];
+        read.result.clear();
+        
+        if (!getHexAnchorOffset(filePath, read.customPattern, read.occurrence, hexSum)) {
+            if (read.occurrence == 0) {
+                logMessage("Offset not found.");
+                continue;
+            }
+            
+            // Later occurrences are searched for individually, up to the one needed
+            std::vector<u64> found;
+            if (fseek(file, 0, SEEK_SET) == 0)
+                found = findHexDataOffsetsF(file, compileCustomPattern(read.customPattern), read.occurrence + 1);
+            if (found.size() <= read.occurrence) {
+                logMessage("Offset not found.");
+                continue;
+            }
+            hexSum = found[read.occurrence];
+            setHexAnchorOffset(filePath, read.customPattern, read.occurrence, hexSum);
         }
-    } else if (feof(file)) {
-        logMessage("End of file reached.");
-    } else if (ferror(file)) {
-        logMessage("Error reading data from file: " + std::to_string(errno));
+        
+        if (read.relativeOffset < 0 && static_cast<u64>(-read.relativeOffset) > hexSum) {
+            logMessage("Error seeking to offset.");
+            continue;
+        }
+        offsets[i] = hexSum + static_cast<u64>(read.relativeOffset);
+        if (read.length > 0)
+            order.push_back(i);
     }
     
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return offsets[a] < offsets[b]; });
     
+    std::vector<unsigned char> buffer;
+    size_t first = 0, last, bytesRead;
+    u64 spanStart, spanEnd;
     
-    // Convert lowercase hex to uppercase and return the result
-    std::string result(hexStream, length * 2);
-    std::transform(result.begin(), result.end(), result.begin(), ::toupper);
+    while (first < order.size()) {
+        // Extend the span over all reads that start close to its end
+        spanStart = offsets[order[first]];
+        spanEnd = spanStart + reads[order[first]].length;
+        last = first + 1;
+        while (last < order.size() && offsets[order[last]] <= spanEnd + hexReadMergeGap) {
+            spanEnd = std::max<u64>(spanEnd, offsets[order[last]] + reads[order[last]].length);
+            ++last;
+        }
+        
+        buffer.resize(static_cast<size_t>(spanEnd - spanStart));
+        bytesRead = 0;
+        if (fseek(file, static_cast<long>(spanStart), SEEK_SET) == 0)
+            bytesRead = fread(buffer.data(), 1, buffer.size(), file);
+        else
+            logMessage("Error seeking to offset.");
+        
+        for (size_t j = first; j < last; ++j) {
+            HexPlaceholderRead& read = reads[order[j]];
+            const size_t bufferOffset = static_cast<size_t>(offsets[order[j]] - spanStart);
+            if (bufferOffset + read.length > bytesRead) {
+                logMessage(ferror(file) ? "Error reading data from file: " + std::to_string(errno) : "End of file reached.");
+                continue;
+            }
+            read.result.reserve(read.length * 2);
+            appendHexString(read.result, buffer.data() + bufferOffset, read.length);
+        }
+        first = last;
+    }
     
-    delete[] hexStream;
+    return std::all_of(reads.begin(), reads.end(), [](const HexPlaceholderRead& read) {
+        return read.length == 0 || !read.result.empty();
+    });
+}
+
+/**
+ * @brief Performs several anchored reads on a file with a single open.
+ *
+ * @param filePath The path to the binary file.
+ * @param reads The reads to perform, their results are filled in.
+ * @return True if every read succeeded, false otherwise.
+ */
+bool readHexPlaceholders(const std::string& filePath, std::vector<HexPlaceholderRead>& reads) {
+    if (reads.empty())
+        return true;
     
-    return result;
+    FILE* file = fopen(filePath.c_str(), "rb");
+    if (!file) {
+        logMessage("Failed to open the file.");
+        for (auto& read : reads)
+            read.result.clear();
+        return false;
+    }
+    
+    const bool success = readHexPlaceholdersF(file, filePath, reads);
+    fclose(file);
+    return success;
 }
 
+/**
+ * @brief Reads data at an offset relative to an anchor in a file.
+ *
+ * @param filePath The path to the binary file.
+ * @param customAsciiPattern The anchor, '#' marks a hexadecimal pattern.
+ * @param relativeOffset The offset of the data from the start of the anchor.
+ * @param length The number of bytes to read.
+ * @param occurrence The 0-based occurrence of the anchor.
+ * @return The data as uppercase hexadecimal, or an empty string on failure.
+ */
+std::string parseHexDataAtCustomOffset(const std::string& filePath, const std::string& customAsciiPattern, s64 relativeOffset, size_t length, size_t occurrence = 0) {
+    std::vector<HexPlaceholderRead> reads(1);
+    reads[0].customPattern = customAsciiPattern;
+    reads[0].relativeOffset = relativeOffset;
+    reads[0].length = length;
+    reads[0].occurrence = occurrence;
+    
+    readHexPlaceholders(filePath, reads);
+    return std::move(reads[0].result);
+}
 
 /**
- * @brief Finds and replaces hexadecimal data in a file.
+ * @brief Reads data at an offset relative to an anchor in an open file.
  *
- * This function searches for occurrences of hexadecimal data in a binary file
- * and replaces them with a specified hexadecimal replacement data.
+ * @param file The binary file, opened for reading.
+ * @param filePath The path of the file, used for the anchor cache.
+ * @param customAsciiPattern The anchor, '#' marks a hexadecimal pattern.
+ * @param relativeOffset The offset of the data from the start of the anchor.
+ * @param length The number of bytes to read.
+ * @param occurrence The 0-based occurrence of the anchor.
+ * @return The data as uppercase hexadecimal, or an empty string on failure.
+ */
+std::string parseHexDataAtCustomOffsetF(FILE*& file, const std::string& filePath, const std::string& customAsciiPattern, s64 relativeOffset, size_t length, size_t occurrence = 0) {
+    std::vector<HexPlaceholderRead> reads(1);
+    reads[0].customPattern = customAsciiPattern;
+    reads[0].relativeOffset = relativeOffset;
+    reads[0].length = length;
+    reads[0].occurrence = occurrence;
+    
+    readHexPlaceholdersF(file, filePath, reads);
+    return std::move(reads[0].result);
+}
+
+/**
+ * @brief Parses the content of a {hex_file(customAsciiPattern, offsetStr, length)} placeholder.
  *
- * @param filePath The path to the binary file.
- * @param hexDataToReplace The hexadecimal data to search for and replace.
- * @param hexDataReplacement The hexadecimal data to replace with.
- * @param occurrence The occurrence/index of the data to replace (default is "0" to replace all occurrences).
+ * @param placeholderContent The text between "{hex_file(" and ")}".
+ * @param read Receives the anchor, offset and length.
+ * @return True if the content has three valid components, false otherwise.
  */
+static bool parseHexPlaceholder(const std::string& placeholderContent, HexPlaceholderRead& read) {
+    const size_t firstComma = placeholderContent.find(',');
+    const size_t secondComma = (firstComma == std::string::npos) ? std::string::npos : placeholderContent.find(',', firstComma + 1);
+    if (secondComma == std::string::npos || placeholderContent.find(',', secondComma + 1) != std::string::npos)
+        return false;
+    
+    read.customPattern = trim(placeholderContent.substr(0, firstComma));
+    return parseOffsetNumber(trim(placeholderContent.substr(firstComma + 1, secondComma - firstComma - 1)), read.relativeOffset) &&
+        parseOffsetNumber(trim(placeholderContent.substr(secondComma + 1)), read.length);
+}
 
+/**
+ * @brief Replaces every {hex_file(customAsciiPattern, offsetStr, length)} placeholder in a command.
+ *
+ * The placeholders of all arguments are read together, with one open of the file. Placeholders
+ * that cannot be read are replaced by "null".
+ *
+ * @param args The command arguments, modified in place.
+ * @param hexPath The path to the binary file.
+ * @return True if every placeholder was replaced by data, false otherwise.
+ */
+bool replaceHexPlaceholders(std::vector<std::string>& args, const std::string& hexPath) {
+    static const std::string searchString = "{hex_file(";
+    
+    // Gather the placeholders of all arguments first
+    std::vector<HexPlaceholderRead> reads;
+    std::vector<bool> parsed;
+    HexPlaceholderRead read;
+    size_t startPos, endPos;
+    
+    for (const auto& arg : args) {
+        startPos = arg.find(searchString);
+        while (startPos != std::string::npos) {
+            endPos = arg.find(")}", startPos);
+            if (endPos == std::string::npos)
+                break;
+            
+            parsed.push_back(parseHexPlaceholder(arg.substr(startPos + searchString.length(), endPos - startPos - searchString.length()), read));
+            reads.push_back(parsed.back() ? read : HexPlaceholderRead());
+            startPos = arg.find(searchString, endPos + 2);
+        }
+    }
+    if (reads.empty())
+        return true;
+    
+    // Only well-formed placeholders are read
+    std::vector<HexPlaceholderRead> validReads;
+    for (size_t i = 0; i < reads.size(); ++i) {
+        if (parsed[i])
+            validReads.push_back(std::move(reads[i]));
+    }
+    readHexPlaceholders(hexPath, validReads);
+    
+    // Substitute in the same order the placeholders were gathered
+    bool success = true;
+    size_t readIndex = 0, validIndex = 0;
+    std::string result;
+    
+    for (auto& arg : args) {
+        startPos = arg.find(searchString);
+        while (startPos != std::string::npos) {
+            endPos = arg.find(")}", startPos);
+            if (endPos == std::string::npos)
+                break;
+            
+            result = parsed[readIndex++] ? std::move(validReads[validIndex++].result) : std::string();
+            if (result.empty()) {
+                result = "null"; // fall back replacement value of null
+                success = false;
+            }
+            arg.replace(startPos, endPos - startPos + 2, result);
+            startPos = arg.find(searchString, startPos + result.length());
+        }
+    }
+    return success;
+}
+
+/**
+ * @brief Replaces the first {hex_file(customAsciiPattern, offsetStr, length)} placeholder in an argument.
+ *
+ * @param arg The argument containing the placeholder.
+ * @param hexPath The path to the binary file.
+ * @return The argument with the placeholder replaced, or unchanged if it could not be read.
+ */
 std::string replaceHexPlaceholder(const std::string& arg, const std::string& hexPath) {
     std::string replacement = arg;
     std::string searchString = "{hex_file(";
     
     size_t startPos = replacement.find(searchString);
-    size_t endPos = replacement.find(")}");
+    size_t endPos = replacement.find(")}", startPos);
     
-    if (startPos != std::string::npos && endPos != std::string::npos && endPos > startPos) {
-        std::string placeholderContent = replacement.substr(startPos + searchString.length(), endPos - startPos - searchString.length());
+    HexPlaceholderRead read;
+    if (startPos != std::string::npos && endPos != std::string::npos &&
+        parseHexPlaceholder(replacement.substr(startPos + searchString.length(), endPos - startPos - searchString.length()), read)) {
+        std::vector<HexPlaceholderRead> reads(1, std::move(read));
         
-        // Split the placeholder content into its components (customAsciiPattern, offsetStr, length)
-        std::vector<std::string> components;
-        std::istringstream componentStream(placeholderContent);
-        std::string component;
-        
-        while (std::getline(componentStream, component, ',')) {
-            components.push_back(trim(component));
-        }
-        
-        if (components.size() == 3) {
-            // Extract individual components
-            std::string customAsciiPattern = components[0];
-            std::string offsetStr = components[1];
-            size_t length = std::stoul(components[2]);
-            
-            // Call the parsing function and replace the placeholder
-            std::string parsedResult = parseHexDataAtCustomOffset(hexPath, customAsciiPattern, offsetStr, length);
-            
-            
-            //std::string parsedResult = customAsciiPattern+offsetStr;
-            
-            // Only replace if parsedResult returns a non-empty string
-            if (!parsedResult.empty()) {
-                // Replace the entire placeholder with the parsed result
-                replacement.replace(startPos, endPos - startPos + searchString.length() + 2, parsedResult);
-            }
-        }
+        // Only replace if the read returns a non-empty string
+        if (readHexPlaceholders(hexPath, reads) && !reads[0].result.empty())
+            replacement.replace(startPos, endPos - startPos + 2, reads[0].result);
     }
     
     return replacement;
@@ -20,14 +20,21 @@
 #include <sys/stat.h>
 #include <cstdio>   // For FILE*, fopen(), fclose(), fprintf(), etc.
 #include <cstring>  // For std::string, strlen(), etc.
+#include <cstdint>  // For uint32_t, uint64_t
 #include <string>   // For std::string
+#include <string_view> // For std::string_view
 #include <vector>   // For std::vector
 #include <map>      // For std::map
+#include <unordered_map> // For std::unordered_map
+#include <memory>   // For std::shared_ptr
+#include <mutex>    // For std::mutex
+#include <chrono>   // For std::chrono::steady_clock
 #include <sstream>  // For std::istringstream
 #include <algorithm> // For std::remove_if
 #include <cctype>   // For ::isspace
 #include <get_funcs.hpp>
 #include <path_funcs.hpp>
+#include <ini_stream.hpp>
 
 
 constexpr size_t BufferSize = 4096;//131072;
@@ -59,7 +66,8 @@ struct PackageHeader {
 /**
  * @brief Retrieves the package header information from an INI file.
  *
- * This function parses an INI file and extracts the package header information.
+ * The header is read in a single pass over the comment lines at the top of the file.
+ * Reading stops at the first section header or once every field has been found.
  *
  * @param filePath The path to the INI file.
  * @return The package header structure.
@@ -68,204 +76,478 @@ PackageHeader getPackageHeaderFromIni(const std::string& filePath) {
     PackageHeader packageHeader;
     
     FILE* file = fopen(filePath.c_str(), "r");
-    if (file == nullptr) {
-        packageHeader.title = "";
-        packageHeader.version = "";
-        packageHeader.creator = "";
-        packageHeader.about = "";
-        packageHeader.credits = "";
-        packageHeader.color = "";
+    if (file == nullptr)
         return packageHeader;
-    }
+    
+    static const std::pair<std::string_view, std::string PackageHeader::*> headerFields[] = {
+        {"title=", &PackageHeader::title},
+        {"version=", &PackageHeader::version},
+        {"creator=", &PackageHeader::creator},
+        {"about=", &PackageHeader::about},
+        {"credits=", &PackageHeader::credits},
+        {"color=", &PackageHeader::color}
+    };
+    constexpr size_t headerFieldCount = sizeof(headerFields) / sizeof(headerFields[0]);
+    constexpr uint32_t allHeaderFields = (1u << headerFieldCount) - 1;
     
     //constexpr size_t BufferSize = 131072; // Choose a larger buffer size for reading lines
     char line[BufferSize];
     
-    const std::string titlePrefix = ";title=";
-    const std::string versionPrefix = ";version=";
-    const std::string creatorPrefix = ";creator=";
-    const std::string aboutPrefix = ";about=";
-    const std::string creditsPrefix = ";credits=";
-    const std::string colorPrefix = ";color=";
-    
-    size_t titlePos, versionPos, creatorPos, aboutPos, creditsPos, colorPos, startPos, endPos;
-    std::string strLine;
+    std::string_view lineView, value;
+    uint32_t foundFields, lineFields;
+    size_t markerPos, fieldPos, startPos, endPos;
     while (fgets(line, sizeof(line), file)) {
-        strLine = line;
+        lineView = line;
         
-        titlePos = strLine.find(titlePrefix);
-        if (titlePos != std::string::npos) {
-            titlePos += titlePrefix.length();
-            startPos = strLine.find("'", titlePos);
-            endPos = strLine.find("'", startPos + 1);
-            
-            if (startPos != std::string::npos && endPos != std::string::npos) {
-                // Value enclosed in single quotes
-                packageHeader.title = strLine.substr(startPos + 1, endPos - startPos - 1);
-            } else {
-                // Value not enclosed in quotes
-                packageHeader.title = strLine.substr(titlePos, endPos - titlePos);
-            }
-            
-            // Remove trailing whitespace or newline characters
-            packageHeader.title.erase(packageHeader.title.find_last_not_of(" \t\r\n") + 1);
-        }
+        value = trimView(lineView);
+        if (!value.empty() && value.front() == '[')
+            break; // The header ends where the first section starts
         
-        versionPos = strLine.find(versionPrefix);
-        if (versionPos != std::string::npos) {
-            versionPos += versionPrefix.length();
-            startPos = strLine.find("'", versionPos);
-            endPos = strLine.find("'", startPos + 1);
-            
-            if (startPos != std::string::npos && endPos != std::string::npos) {
-                // Value enclosed in single quotes
-                packageHeader.version = strLine.substr(startPos + 1, endPos - startPos - 1);
-            } else {
-                // Value not enclosed in quotes
-                packageHeader.version = strLine.substr(versionPos, endPos - versionPos);
+        // Each field is introduced by ";<name>=", the first occurrence in a line wins
+        lineFields = 0;
+        for (markerPos = lineView.find(';'); markerPos != std::string_view::npos; markerPos = lineView.find(';', markerPos + 1)) {
+            for (size_t i = 0; i < headerFieldCount; ++i) {
+                const auto& [prefix, field] = headerFields[i];
+                if ((lineFields & (1u << i)) || lineView.compare(markerPos + 1, prefix.size(), prefix) != 0)
+                    continue;
+                
+                fieldPos = markerPos + 1 + prefix.size();
+                startPos = lineView.find('\'', fieldPos);
+                endPos = (startPos != std::string_view::npos) ? lineView.find('\'', startPos + 1) : std::string_view::npos;
+                
+                if (startPos != std::string_view::npos && endPos != std::string_view::npos)
+                    value = lineView.substr(startPos + 1, endPos - startPos - 1); // Value enclosed in single quotes
+                else
+                    value = lineView.substr(fieldPos); // Value not enclosed in quotes
+                
+                // Remove trailing whitespace or newline characters
+                endPos = value.find_last_not_of(" \t\r\n");
+                value = (endPos == std::string_view::npos) ? std::string_view() : value.substr(0, endPos + 1);
+                
+                packageHeader.*field = value;
+                lineFields |= (1u << i);
+                break;
             }
-            
-            // Remove trailing whitespace or newline characters
-            packageHeader.version.erase(packageHeader.version.find_last_not_of(" \t\r\n") + 1);
         }
         
-        creatorPos = strLine.find(creatorPrefix);
-        if (creatorPos != std::string::npos) {
-            creatorPos += creatorPrefix.length();
-            startPos = strLine.find("'", creatorPos);
-            endPos = strLine.find("'", startPos + 1);
-            
-            if (startPos != std::string::npos && endPos != std::string::npos) {
-                // Value enclosed in single quotes
-                packageHeader.creator = strLine.substr(startPos + 1, endPos - startPos - 1);
-            } else {
-                // Value not enclosed in quotes
-                packageHeader.creator = strLine.substr(creatorPos, endPos - creatorPos);
-            }
-            
-            // Remove trailing whitespace or newline characters
-            packageHeader.creator.erase(packageHeader.creator.find_last_not_of(" \t\r\n") + 1);
+        // A field only counts as found once it has a value
+        foundFields = 0;
+        for (size_t i = 0; i < headerFieldCount; ++i) {
+            if (!(packageHeader.*headerFields[i].second).empty())
+                foundFields |= (1u << i);
         }
+        if (foundFields == allHeaderFields)
+            break; // All fields found, exit the loop
+    }
+    
+    fclose(file);
+    
+    return packageHeader;
+}
+
+
+/**
+ * @brief Catalog entry of a package header, validated against the package.ini's size and mtime.
+ */
+struct PackageCatalogEntry {
+    uint64_t fileSize;
+    int64_t modifiedTime;
+    PackageHeader header;
+    bool used;
+};
+
+static const std::string packageCatalogPath = "sdmc:/config/ultrahand/packages.cache";
+static constexpr uint32_t packageCatalogMagic = 0x43504855; // "UHPC"
+static constexpr uint32_t packageCatalogVersion = 1;
+
+static std::unordered_map<std::string, PackageCatalogEntry> packageCatalog;
+static std::mutex packageCatalogMutex;
+static bool packageCatalogLoaded = false;
+static bool packageCatalogDirty = false;
+
+/**
+ * @brief Reads the package catalog from the SD card. Requires packageCatalogMutex to be held.
+ */
+static void loadPackageCatalog() {
+    packageCatalogLoaded = true;
+    
+    FILE* catalogFile = fopen(packageCatalogPath.c_str(), "rb");
+    if (!catalogFile)
+        return;
+    
+    auto readString = [catalogFile](std::string& str) {
+        uint32_t length;
+        if (fread(&length, sizeof(length), 1, catalogFile) != 1 || length > BufferSize)
+            return false;
+        str.resize(length);
+        return length == 0 || fread(&str[0], 1, length, catalogFile) == length;
+    };
+    
+    uint32_t magic = 0, version = 0, count = 0;
+    bool valid = fread(&magic, sizeof(magic), 1, catalogFile) == 1 && magic == packageCatalogMagic &&
+                 fread(&version, sizeof(version), 1, catalogFile) == 1 && version == packageCatalogVersion &&
+                 fread(&count, sizeof(count), 1, catalogFile) == 1;
+    
+    std::string filePath;
+    PackageCatalogEntry entry;
+    entry.used = false;
+    for (uint32_t i = 0; i < count && valid; ++i) {
+        valid = readString(filePath) &&
+                fread(&entry.fileSize, sizeof(entry.fileSize), 1, catalogFile) == 1 &&
+                fread(&entry.modifiedTime, sizeof(entry.modifiedTime), 1, catalogFile) == 1 &&
+                readString(entry.header.title) && readString(entry.header.version) &&
+                readString(entry.header.creator) && readString(entry.header.about) &&
+                readString(entry.header.credits) && readString(entry.header.color);
+        if (valid)
+            packageCatalog[filePath] = entry;
+    }
+    fclose(catalogFile);
+    
+    if (!valid) {
+        logMessage("Discarding invalid package catalog " + packageCatalogPath + ".");
+        packageCatalog.clear();
+    }
+}
+
+/**
+ * @brief Retrieves a package header from the persistent catalog.
+ *
+ * Only the package.ini is stat'ed; it is parsed with getPackageHeaderFromIni() only when
+ * it is not in the catalog or its size or mtime changed. Call savePackageCatalog() to
+ * persist new entries.
+ *
+ * @param filePath The path to the package.ini.
+ * @return The package header structure.
+ */
+PackageHeader getCachedPackageHeader(const std::string& filePath) {
+    struct stat fileStat;
+    if (stat(filePath.c_str(), &fileStat) != 0)
+        return PackageHeader();
+    
+    std::lock_guard<std::mutex> lock(packageCatalogMutex);
+    if (!packageCatalogLoaded)
+        loadPackageCatalog();
+    
+    auto it = packageCatalog.find(filePath);
+    if (it != packageCatalog.end() && it->second.fileSize == static_cast<uint64_t>(fileStat.st_size) && it->second.modifiedTime == static_cast<int64_t>(fileStat.st_mtime)) {
+        it->second.used = true;
+        return it->second.header;
+    }
+    
+    PackageCatalogEntry& entry = packageCatalog[filePath];
+    entry.fileSize = fileStat.st_size;
+    entry.modifiedTime = fileStat.st_mtime;
+    entry.header = getPackageHeaderFromIni(filePath);
+    entry.used = true;
+    packageCatalogDirty = true;
+    return entry.header;
+}
+
+/**
+ * @brief Writes the package catalog if it changed since it was loaded.
+ *
+ * Entries that were not used during this session and whose package.ini no longer exists are dropped.
+ */
+void savePackageCatalog() {
+    std::lock_guard<std::mutex> lock(packageCatalogMutex);
+    
+    struct stat fileStat;
+    for (auto it = packageCatalog.begin(); it != packageCatalog.end();) {
+        if (!it->second.used && stat(it->first.c_str(), &fileStat) != 0) {
+            it = packageCatalog.erase(it);
+            packageCatalogDirty = true;
+        } else
+            ++it;
+    }
+    
+    if (!packageCatalogDirty)
+        return;
+    
+    const std::string tempPath = packageCatalogPath + ".tmp";
+    FILE* catalogFile = fopen(tempPath.c_str(), "wb");
+    if (!catalogFile) {
+        logMessage("Failed to open " + tempPath + " for writing.");
+        return;
+    }
+    
+    auto writeString = [catalogFile](const std::string& str) {
+        const uint32_t length = str.size();
+        return fwrite(&length, sizeof(length), 1, catalogFile) == 1 && fwrite(str.data(), 1, length, catalogFile) == length;
+    };
+    
+    const uint32_t count = packageCatalog.size();
+    bool success = fwrite(&packageCatalogMagic, sizeof(packageCatalogMagic), 1, catalogFile) == 1 &&
+                   fwrite(&packageCatalogVersion, sizeof(packageCatalogVersion), 1, catalogFile) == 1 &&
+                   fwrite(&count, sizeof(count), 1, catalogFile) == 1;
+    
+    for (const auto& [filePath, entry] : packageCatalog) {
+        if (!success)
+            break;
+        success = writeString(filePath) &&
+                  fwrite(&entry.fileSize, sizeof(entry.fileSize), 1, catalogFile) == 1 &&
+                  fwrite(&entry.modifiedTime, sizeof(entry.modifiedTime), 1, catalogFile) == 1 &&
+                  writeString(entry.header.title) && writeString(entry.header.version) &&
+                  writeString(entry.header.creator) && writeString(entry.header.about) &&
+                  writeString(entry.header.credits) && writeString(entry.header.color);
+    }
+    
+    success = (fclose(catalogFile) == 0) && success;
+    if (!success) {
+        logMessage("Failed to write " + tempPath + ".");
+        remove(tempPath.c_str());
+        return;
+    }
+    
+    remove(packageCatalogPath.c_str());
+    if (rename(tempPath.c_str(), packageCatalogPath.c_str()) != 0) {
+        logMessage("Failed to rename " + tempPath + " to " + packageCatalogPath + ".");
+        return;
+    }
+    packageCatalogDirty = false;
+}
+
+/**
+ * @brief Walks INI content and reports section headers and key-value pairs as string views.
+ *
+ * No copies are made; every view points into the given content. Lines are trimmed,
+ * sections must look like "[name]" and key-value pairs are split on the first '='.
+ * Either handler may return false to stop the walk early.
+ *
+ * @param content The INI-formatted content.
+ * @param onSection Called as onSection(sectionName) for each section header.
+ * @param onKeyValue Called as onKeyValue(sectionName, key, value) for each pair.
+ */
+template <typename SectionHandler, typename KeyValueHandler>
+void tokenizeIni(std::string_view content, SectionHandler&& onSection, KeyValueHandler&& onKeyValue) {
+    content = skipIniByteOrderMark(content);
+    std::string_view currentSection;
+    size_t lineStart = 0, lineEnd;
+    IniLine iniLine;
+    
+    while (lineStart < content.size()) {
+        lineEnd = content.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos)
+            lineEnd = content.size();
+        iniLine = parseIniLine(content.substr(lineStart, lineEnd - lineStart));
+        lineStart = lineEnd + 1;
         
-        aboutPos = strLine.find(aboutPrefix);
-        if (aboutPos != std::string::npos) {
-            aboutPos += aboutPrefix.length();
-            startPos = strLine.find("'", aboutPos);
-            endPos = strLine.find("'", startPos + 1);
-            
-            if (startPos != std::string::npos && endPos != std::string::npos) {
-                // Value enclosed in single quotes
-                packageHeader.about = strLine.substr(startPos + 1, endPos - startPos - 1);
-            } else {
-                // Value not enclosed in quotes
-                packageHeader.about = strLine.substr(aboutPos, endPos - aboutPos);
-            }
-            
-            // Remove trailing whitespace or newline characters
-            packageHeader.about.erase(packageHeader.about.find_last_not_of(" \t\r\n") + 1);
+        if (iniLine.type == IniLineType::Section) {
+            currentSection = iniLine.name;
+            if (!onSection(currentSection))
+                return;
+        } else if (iniLine.type == IniLineType::KeyValue) {
+            if (!onKeyValue(currentSection, iniLine.name, iniLine.value))
+                return;
         }
+    }
+}
+
+
+/**
+ * @brief Values queued for one INI file by the write-behind store, keyed by (section, key).
+ */
+using PendingIniValues = std::map<std::pair<std::string, std::string>, std::string>;
+
+// Defined with the write-behind store below
+bool getPendingIniValues(const std::string& filePath, PendingIniValues& values);
+void dropWrittenIniValues(const std::string& filePath, const PendingIniValues& writtenValues);
+static bool applyPendingIniValues(const std::string& filePath, std::string& content);
+
+/**
+ * @brief Restores an INI file whose atomic replace was interrupted.
+ *
+ * Saves remove the original only after the temp file was fully written, so a missing
+ * file with a leftover temp file means the temp file holds the complete new content.
+ *
+ * @param filePath The path to the INI file.
+ */
+static void recoverInterruptedIniSave(const std::string& filePath) {
+    struct stat fileStat;
+    if (stat(filePath.c_str(), &fileStat) == 0)
+        return;
+    
+    const std::string tempPath = filePath + ".tmp";
+    if (stat(tempPath.c_str(), &fileStat) == 0)
+        rename(tempPath.c_str(), filePath.c_str());
+}
+
+
+/**
+ * @brief Flat, read-only table of parsed INI data.
+ *
+ * The file content is kept in a single arena and all names and values are string views
+ * into it, stored in sorted flat vectors. Parsing therefore costs a constant number of
+ * allocations regardless of the number of keys, and lookups are binary searches.
+ * A key that appears more than once in a section keeps its first value, like IniDocument.
+ */
+class IniTable {
+public:
+    struct Entry {
+        std::string_view section;
+        std::string_view key;
+        std::string_view value;
+    };
+    
+    IniTable() = default;
+    IniTable(const IniTable&) = delete; // Views point into the arena
+    IniTable& operator=(const IniTable&) = delete;
+    
+    /**
+     * @brief Reads and parses the INI file at the specified path.
+     *
+     * Values still queued by the write-behind store read as if they were already written.
+     *
+     * @param filePath The path to the INI file.
+     * @return True if the file could be read or has queued values, false otherwise.
+     */
+    bool load(const std::string& filePath) {
+        recoverInterruptedIniSave(filePath);
         
-        creditsPos = strLine.find(creditsPrefix);
-        if (creditsPos != std::string::npos) {
-            creditsPos += creditsPrefix.length();
-            startPos = strLine.find("'", creditsPos);
-            endPos = strLine.find("'", startPos + 1);
+        std::string content;
+        bool fileRead = false;
+        FILE* file = fopen(filePath.c_str(), "rb");
+        if (file) {
+            fseek(file, 0, SEEK_END);
+            long fileSize = ftell(file);
+            rewind(file);
             
-            if (startPos != std::string::npos && endPos != std::string::npos) {
-                // Value enclosed in single quotes
-                packageHeader.credits = strLine.substr(startPos + 1, endPos - startPos - 1);
-            } else {
-                // Value not enclosed in quotes
-                packageHeader.credits = strLine.substr(creditsPos, endPos - creditsPos);
+            if (fileSize > 0) {
+                content.resize(fileSize);
+                content.resize(fread(&content[0], 1, fileSize, file));
             }
-            
-            // Remove trailing whitespace or newline characters
-            packageHeader.credits.erase(packageHeader.credits.find_last_not_of(" \t\r\n") + 1);
+            fclose(file);
+            fileRead = true;
         }
         
-        colorPos = strLine.find(colorPrefix);
-        if (colorPos != std::string::npos) {
-            colorPos += colorPrefix.length();
-            startPos = strLine.find("'", colorPos);
-            endPos = strLine.find("'", startPos + 1);
-            
-            if (startPos != std::string::npos && endPos != std::string::npos) {
-                // Value enclosed in single quotes
-                packageHeader.color = strLine.substr(startPos + 1, endPos - startPos - 1);
-            } else {
-                // Value not enclosed in quotes
-                packageHeader.color = strLine.substr(colorPos, endPos - colorPos);
-            }
-            
-            // Remove trailing whitespace or newline characters
-            packageHeader.color.erase(packageHeader.color.find_last_not_of(" \t\r\n") + 1);
-        }
+        const bool pending = applyPendingIniValues(filePath, content);
+        parse(std::move(content));
+        return fileRead || pending;
+    }
+    
+    /**
+     * @brief Parses INI content, taking ownership of it as the arena.
+     *
+     * @param content The INI-formatted content.
+     */
+    void parse(std::string content) {
+        arena = std::move(content);
+        sectionNames.clear();
+        entries.clear();
+        entries.reserve(std::count(arena.begin(), arena.end(), '\n') + 1);
         
+        tokenizeIni(arena,
+            [this](std::string_view sectionName) {
+                sectionNames.push_back(sectionName);
+                return true;
+            },
+            [this](std::string_view sectionName, std::string_view key, std::string_view value) {
+                entries.push_back({sectionName, key, value});
+                return true;
+            });
         
-        if (!packageHeader.version.empty() && !packageHeader.creator.empty() && !packageHeader.about.empty() && !packageHeader.credits.empty() && !packageHeader.color.empty()) {
-            break; // Both version and creator found, exit the loop
-        }
+        std::sort(sectionNames.begin(), sectionNames.end());
+        sectionNames.erase(std::unique(sectionNames.begin(), sectionNames.end()), sectionNames.end());
+        
+        // Sort by section and key, then keep only the first occurrence of each key
+        std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return a.section != b.section ? a.section < b.section : a.key < b.key;
+        });
+        entries.erase(std::unique(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return a.section == b.section && a.key == b.key;
+        }), entries.end());
     }
     
+    bool hasSection(std::string_view sectionName) const {
+        return std::binary_search(sectionNames.begin(), sectionNames.end(), sectionName);
+    }
     
+    bool hasKey(std::string_view sectionName, std::string_view keyName) const {
+        std::string_view value;
+        return getValue(sectionName, keyName, value);
+    }
     
-    fclose(file);
+    /**
+     * @brief Looks up the value of a key within a section.
+     *
+     * @param sectionName The name of the section.
+     * @param keyName The name of the key.
+     * @param value Receives a view of the value if the key exists.
+     * @return True if the key was found, false otherwise.
+     */
+    bool getValue(std::string_view sectionName, std::string_view keyName, std::string_view& value) const {
+        auto it = std::lower_bound(entries.begin(), entries.end(), Entry{sectionName, keyName, {}}, [](const Entry& a, const Entry& b) {
+            return a.section != b.section ? a.section < b.section : a.key < b.key;
+        });
+        if (it == entries.end() || it->section != sectionName || it->key != keyName)
+            return false;
+        value = it->value;
+        return true;
+    }
     
-    return packageHeader;
-}
-
-/**
- * @brief Splits a string into a vector of substrings using a specified delimiter.
- *
- * This function splits a given string into multiple substrings based on the specified delimiter.
- *
- * @param str The input string to be split.
- * @param delim The delimiter character used for splitting (default is space ' ').
- * @return A vector of substrings obtained by splitting the input string.
- */
-static std::vector<std::string> split(const std::string& str, char delim = ' ') {
-    std::vector<std::string> out;
+    std::string getValue(std::string_view sectionName, std::string_view keyName) const {
+        std::string_view value;
+        if (!getValue(sectionName, keyName, value))
+            return "";
+        return std::string(value);
+    }
     
-    size_t current, previous = 0;
-    current = str.find(delim);
-    while (current != std::string::npos) {
-        out.push_back(str.substr(previous, current - previous));
-        previous = current + 1;
-        current = str.find(delim, previous);
+    const std::vector<std::string_view>& getSectionNames() const { return sectionNames; }
+    const std::vector<Entry>& getEntries() const { return entries; }
+    
+    /**
+     * @brief Converts the table into the nested map layout used by IniData.
+     *
+     * @param includeEmptySections Whether sections without keys get an (empty) entry.
+     * @return A map representing the parsed INI data.
+     */
+    std::map<std::string, std::map<std::string, std::string>> toIniData(bool includeEmptySections = false) const {
+        std::map<std::string, std::map<std::string, std::string>> iniData;
+        if (includeEmptySections) {
+            for (const auto& sectionName : sectionNames)
+                iniData.emplace_hint(iniData.end(), std::string(sectionName), std::map<std::string, std::string>{});
+        }
+        
+        std::map<std::string, std::string>* currentSection = nullptr;
+        std::string_view currentSectionName;
+        for (const auto& entry : entries) {
+            if (!currentSection || entry.section != currentSectionName) {
+                currentSection = &iniData[std::string(entry.section)];
+                currentSectionName = entry.section;
+            }
+            currentSection->emplace_hint(currentSection->end(), std::string(entry.key), std::string(entry.value));
+        }
+        return iniData;
     }
-    out.push_back(str.substr(previous, current - previous));
     
-    return out;
-}
+private:
+    std::string arena;
+    std::vector<std::string_view> sectionNames; // Sorted and unique
+    std::vector<Entry> entries;                 // Sorted by section, then key
+};
+
 
 /**
  * @brief Parses an INI-formatted string into a map of sections and key-value pairs.
  *
  * This function parses an INI-formatted string and organizes the data into a map,
  * where sections are keys and key-value pairs are stored within each section.
+ * All whitespace is removed from section names, keys and values, so a key combo
+ * written as "ZL + ZR" reads as "ZL+ZR". The first value of a repeated key is kept.
  *
  * @param str The INI-formatted string to parse.
  * @return A map representing the parsed INI data.
  */
 static std::map<std::string, std::map<std::string, std::string>> parseIni(const std::string &str) {
-    std::map<std::string, std::map<std::string, std::string>> iniData;
-    
-    auto lines = split(str, '\n');
-    
-    std::string lastHeader = "";
-    for (auto& line : lines) {
-        line.erase(std::remove_if(line.begin(), line.end(), ::isspace), line.end());
-        
-        if (line[0] == '[' && line[line.size() - 1] == ']') {
-            lastHeader = line.substr(1, line.size() - 2);
-            iniData.emplace(lastHeader, std::map<std::string, std::string>{});
-        }
-        else if (auto keyValuePair = split(line, '='); keyValuePair.size() == 2) {
-            iniData[lastHeader].emplace(keyValuePair[0], keyValuePair[1]);
-        }
+    std::string content;
+    content.reserve(str.size());
+    for (char c : str) {
+        if (c == '\n' || !std::isspace(static_cast<unsigned char>(c)))
+            content.push_back(c);
     }
-
-    return iniData;
+    
+    IniTable iniTable;
+    iniTable.parse(std::move(content));
+    return iniTable.toIniData(true);
 }
 
 /**
@@ -279,62 +561,713 @@ static std::map<std::string, std::map<std::string, std::string>> parseIni(const
  * @return A map representing the parsed INI data.
  */
 std::map<std::string, std::map<std::string, std::string>> getParsedDataFromIniFile(const std::string& configIniPath) {
-    std::map<std::string, std::map<std::string, std::string>> parsedData;
-    std::string currentSection = ""; // Initialize the current section as empty
-    
-    FILE* configFileIn = fopen(configIniPath.c_str(), "rb");
-    if (!configFileIn) {
-        return parsedData;
-    }
-    
-    // Determine the size of the INI file
-    fseek(configFileIn, 0, SEEK_END);
-    long fileSize = ftell(configFileIn);
-    rewind(configFileIn);
-    
-    // Read the contents of the INI file
-    char* fileData = new char[fileSize + 1];
-    fread(fileData, sizeof(char), fileSize, configFileIn);
-    fileData[fileSize] = '\0';  // Add null-terminator to create a C-string
-    fclose(configFileIn);
-    
-    // Parse the INI data
-    std::string fileDataString(fileData, fileSize);
-    
-    // Normalize line endings to \n
-    fileDataString.erase(std::remove(fileDataString.begin(), fileDataString.end(), '\r'), fileDataString.end());
-    
-    // Split lines and parse
-    std::istringstream fileStream(fileDataString);
-    std::string line;
-    size_t delimiterPos;
-    std::string key, value;
-    while (std::getline(fileStream, line)) {
-        // Remove leading and trailing whitespace
-        line = trim(line);
-        
-        // Check if this line is a section
-        if (line.size() > 2 && line.front() == '[' && line.back() == ']') {
-            // Remove the brackets to get the section name
-            currentSection = line.substr(1, line.size() - 2);
-        } else {
-            // If not a section, parse as key-value pair
-            delimiterPos = line.find('=');
-            if (delimiterPos != std::string::npos) {
-                key = trim(line.substr(0, delimiterPos));
-                value = trim(line.substr(delimiterPos + 1));
+    IniTable iniTable;
+    if (!iniTable.load(configIniPath)) {
+        return {};
+    }
+    
+    return iniTable.toIniData();
+}
+
+
+/**
+ * @brief In-memory model of an INI file.
+ *
+ * The document is loaded with a single read and kept as its raw lines (including
+ * comments, blank lines and original line endings), so writing it back reproduces
+ * every untouched byte. Sections and keys are indexed on load, making lookups O(1)
+ * instead of rescanning the file for every query. Lines are not limited in length.
+ */
+class IniDocument {
+public:
+    IniDocument() = default;
+    explicit IniDocument(const std::string& filePath) { load(filePath); }
+    
+    /**
+     * @brief Loads and indexes the INI file at the specified path.
+     *
+     * Values still queued by the write-behind store are applied on top of the file, and
+     * are dropped from the store once save() has written them to the same path.
+     *
+     * @param filePath The path to the INI file.
+     * @return True if the file could be read, false otherwise.
+     */
+    bool load(const std::string& filePath) {
+        const bool fileRead = loadFromFile(filePath);
+        
+        PendingIniValues pendingValues;
+        if (getPendingIniValues(filePath, pendingValues))
+            applyPendingValues(filePath, std::move(pendingValues));
+        return fileRead;
+    }
+    
+    /**
+     * @brief Loads and indexes the INI file as stored, without the values queued for it.
+     *
+     * @param filePath The path to the INI file.
+     * @return True if the file could be read, false otherwise.
+     */
+    bool loadFromFile(const std::string& filePath) {
+        lines.clear();
+        byteOrderMark = 0;
+        loaded = false;
+        appliedPendingPath.clear();
+        appliedPendingValues.clear();
+        
+        recoverInterruptedIniSave(filePath);
+        
+        FILE* file = fopen(filePath.c_str(), "rb");
+        if (!file) {
+            reindex();
+            return false;
+        }
+        
+        fseek(file, 0, SEEK_END);
+        long fileSize = ftell(file);
+        rewind(file);
+        
+        std::string content;
+        if (fileSize > 0) {
+            content.resize(fileSize);
+            content.resize(fread(&content[0], 1, fileSize, file));
+        }
+        fclose(file);
+        
+        loadFromString(content);
+        return true;
+    }
+    
+    /**
+     * @brief Loads and indexes INI content from a string.
+     *
+     * @param content The INI-formatted content.
+     */
+    void loadFromString(const std::string& content) {
+        lines.clear();
+        appliedPendingPath.clear();
+        appliedPendingValues.clear();
+        
+        // The byte order mark is kept aside, so it neither hides the first line nor gets lost on save
+        byteOrderMark = content.size() - skipIniByteOrderMark(content).size();
+        size_t start = byteOrderMark, end;
+        while (start < content.size()) {
+            end = content.find('\n', start);
+            if (end == std::string::npos) {
+                lines.push_back(content.substr(start));
+                break;
+            }
+            lines.push_back(content.substr(start, end - start + 1));
+            start = end + 1;
+        }
+        
+        loaded = true;
+        reindex();
+    }
+    
+    /**
+     * @brief Serializes the document back into its INI text.
+     *
+     * @return The INI content, byte-identical to the loaded content for untouched lines.
+     */
+    std::string toString() const {
+        size_t totalSize = 0;
+        for (const auto& line : lines)
+            totalSize += line.size();
+        
+        std::string content;
+        content.reserve(byteOrderMark + totalSize);
+        content.append("\xEF\xBB\xBF", byteOrderMark);
+        for (const auto& line : lines)
+            content += line;
+        return content;
+    }
+    
+    /**
+     * @brief Writes the document to the specified path.
+     *
+     * The content is written to a temporary file first which then replaces the original.
+     *
+     * @param filePath The path to the INI file.
+     * @return True if the file was written successfully, false otherwise.
+     */
+    bool save(const std::string& filePath) const {
+        std::string tempPath = filePath + ".tmp";
+        FILE* file = fopen(tempPath.c_str(), "wb");
+        if (!file) {
+            logMessage("Failed to open " + tempPath + " for writing.");
+            return false;
+        }
+        
+        std::string content = toString();
+        bool success = (fwrite(content.data(), 1, content.size(), file) == content.size());
+        success = (fclose(file) == 0) && success;
+        if (!success) {
+            logMessage("Failed to write " + tempPath + ".");
+            remove(tempPath.c_str());
+            return false;
+        }
+        
+        // Replace the original file with the temp file
+        remove(filePath.c_str());
+        invalidateDirectoryListing(filePath);
+        if (rename(tempPath.c_str(), filePath.c_str()) != 0) {
+            logMessage("Failed to rename " + tempPath + " to " + filePath + ".");
+            return false;
+        }
+        
+        if (!appliedPendingValues.empty() && filePath == appliedPendingPath)
+            dropWrittenIniValues(filePath, appliedPendingValues);
+        return true;
+    }
+    
+    /**
+     * @brief Sets queued values that differ from the document and remembers them for save().
+     *
+     * @param filePath The path the values were queued for.
+     * @param pendingValues The queued values.
+     */
+    void applyPendingValues(const std::string& filePath, PendingIniValues pendingValues) {
+        std::string currentValue;
+        for (const auto& [sectionKey, value] : pendingValues) {
+            if (!getValue(sectionKey.first, sectionKey.second, currentValue) || currentValue != value)
+                setValue(sectionKey.first, sectionKey.second, value);
+        }
+        appliedPendingPath = filePath;
+        appliedPendingValues = std::move(pendingValues);
+    }
+    
+    bool isLoaded() const { return loaded; }
+    bool empty() const { return lines.empty(); }
+    
+    /**
+     * @brief Checks whether a section with the exact name exists.
+     */
+    bool hasSection(const std::string& sectionName) const {
+        return sectionIndex.find(sectionName) != sectionIndex.end();
+    }
+    
+    /**
+     * @brief Returns the section names in file order (duplicates included).
+     */
+    std::vector<std::string> getSectionNames() const {
+        std::vector<std::string> sectionNames;
+        for (const auto& section : sections) {
+            if (section.headerLine != std::string::npos)
+                sectionNames.push_back(section.name);
+        }
+        return sectionNames;
+    }
+    
+    /**
+     * @brief Looks up the value of a key within a section.
+     *
+     * @param sectionName The name of the section.
+     * @param keyName The name of the key.
+     * @param value Receives the trimmed value if the key exists.
+     * @return True if the key was found, false otherwise.
+     */
+    bool getValue(const std::string& sectionName, const std::string& keyName, std::string& value) const {
+        auto sectionIt = keyIndex.find(sectionName);
+        if (sectionIt == keyIndex.end())
+            return false;
+        
+        auto keyIt = sectionIt->second.find(keyName);
+        if (keyIt == sectionIt->second.end())
+            return false;
+        
+        value = getValueFromLine(trim(lines[keyIt->second]));
+        return true;
+    }
+    
+    std::string getValue(const std::string& sectionName, const std::string& keyName) const {
+        std::string value = "";
+        getValue(sectionName, keyName, value);
+        return value;
+    }
+    
+    /**
+     * @brief Sets the value of a key, creating the key or section if needed.
+     *
+     * Existing keys are rewritten in place. New keys are placed after the last
+     * non-blank line of the section, and new sections are appended to the end.
+     *
+     * @param sectionName The name of the section.
+     * @param keyName The name of the key.
+     * @param value The new value.
+     */
+    void setValue(const std::string& sectionName, const std::string& keyName, const std::string& value) {
+        const std::string formattedValue = trim(value);
+        std::vector<size_t> matches = findSectionsByName(sectionName);
+        
+        if (matches.empty()) {
+            if (!lines.empty()) {
+                if (lines.back().back() == '\n')
+                    lines.push_back("\n");
+                else
+                    lines.back() += "\n";
+            }
+            lines.push_back("[" + sectionName + "]\n");
+            lines.push_back(keyName + " = " + formattedValue + "\n");
+            reindex();
+            return;
+        }
+        
+        if (replaceKeyLines(matches, keyName, keyName, &formattedValue)) {
+            reindex();
+            return;
+        }
+        
+        // Insert the key after the last non-blank line of the first matching section
+        const Section& section = sections[matches.front()];
+        size_t insertPos = section.endLine;
+        size_t firstLine = (section.headerLine == std::string::npos) ? 0 : section.headerLine + 1;
+        while (insertPos > firstLine && trim(lines[insertPos - 1]).empty())
+            --insertPos;
+        if (insertPos > 0 && lines[insertPos - 1].back() != '\n')
+            lines[insertPos - 1] += "\n";
+        lines.insert(lines.begin() + insertPos, keyName + " = " + formattedValue + "\n");
+        reindex();
+    }
+    
+    /**
+     * @brief Renames a key within a section while preserving its value.
+     *
+     * @return True if the key was found and renamed, false otherwise.
+     */
+    bool renameKey(const std::string& sectionName, const std::string& keyName, const std::string& newKeyName) {
+        if (!replaceKeyLines(findSectionsByName(sectionName), keyName, newKeyName, nullptr))
+            return false;
+        reindex();
+        return true;
+    }
+    
+    /**
+     * @brief Removes every occurrence of a key within a section.
+     *
+     * @return True if at least one line was removed, false otherwise.
+     */
+    bool removeKey(const std::string& sectionName, const std::string& keyName) {
+        bool removed = false;
+        std::string trimmedLine;
+        size_t delimiterPos;
+        
+        const std::vector<size_t> matches = findSectionsByName(sectionName);
+        for (auto rit = matches.rbegin(); rit != matches.rend(); ++rit) {
+            const Section& section = sections[*rit];
+            size_t firstLine = (section.headerLine == std::string::npos) ? 0 : section.headerLine + 1;
+            for (size_t i = section.endLine; i-- > firstLine; ) {
+                trimmedLine = trim(lines[i]);
+                delimiterPos = trimmedLine.find('=');
+                if (delimiterPos != std::string::npos && trim(trimmedLine.substr(0, delimiterPos)) == keyName) {
+                    lines.erase(lines.begin() + i);
+                    removed = true;
+                }
+            }
+        }
+        if (removed)
+            reindex();
+        return removed;
+    }
+    
+    /**
+     * @brief Appends an empty section if it does not already exist.
+     *
+     * @return True if the section was added, false if it already existed.
+     */
+    bool addSection(const std::string& sectionName) {
+        if (hasSection(sectionName))
+            return false;
+        if (!lines.empty() && lines.back().back() != '\n')
+            lines.back() += "\n";
+        lines.push_back("[" + sectionName + "]\n");
+        reindex();
+        return true;
+    }
+    
+    /**
+     * @brief Renames a section, leaving its contents untouched.
+     *
+     * @return True if the section was renamed, false if it is missing or the new name is taken.
+     */
+    bool renameSection(const std::string& currentSectionName, const std::string& newSectionName) {
+        auto it = sectionIndex.find(currentSectionName);
+        if (it == sectionIndex.end() || hasSection(newSectionName))
+            return false;
+        
+        // Only the name is replaced, a comment after the header is kept
+        size_t openPos, closePos;
+        for (size_t sectionId : it->second) {
+            std::string& headerLine = lines[sections[sectionId].headerLine];
+            openPos = headerLine.find('[');
+            closePos = openPos + findIniSectionEnd(trim(headerLine));
+            headerLine.replace(openPos + 1, closePos - openPos - 1, newSectionName);
+        }
+        reindex();
+        return true;
+    }
+    
+    /**
+     * @brief Removes a section together with all of its lines.
+     *
+     * @return True if the section was removed, false if it did not exist.
+     */
+    bool removeSection(const std::string& sectionName) {
+        auto it = sectionIndex.find(sectionName);
+        if (it == sectionIndex.end())
+            return false;
+        
+        // Erase from the back so earlier line ranges stay valid
+        const std::vector<size_t> sectionIds = it->second;
+        for (auto rit = sectionIds.rbegin(); rit != sectionIds.rend(); ++rit) {
+            const Section& section = sections[*rit];
+            lines.erase(lines.begin() + section.headerLine, lines.begin() + section.endLine);
+        }
+        reindex();
+        return true;
+    }
+    
+    /**
+     * @brief Trims every line, drops empty lines and separates sections by one blank line.
+     */
+    void cleanFormatting() {
+        std::vector<std::string> cleanedLines;
+        cleanedLines.reserve(lines.size());
+        
+        bool isNewSection = false;
+        std::string trimmedLine;
+        for (const auto& line : lines) {
+            trimmedLine = trim(line);
+            if (trimmedLine.empty())
+                continue;
+            
+            if (isSectionHeader(trimmedLine)) {
+                if (isNewSection)
+                    cleanedLines.push_back("\n");
+                isNewSection = true;
+            }
+            cleanedLines.push_back(trimmedLine + "\n");
+        }
+        
+        lines.swap(cleanedLines);
+        reindex();
+    }
+    
+private:
+    struct Section {
+        std::string name;  // Raw text between the brackets
+        size_t headerLine; // std::string::npos for the lines before the first header
+        size_t endLine;    // One past the last line of the section
+    };
+    
+    std::vector<std::string> lines; // Raw lines including their line endings
+    size_t byteOrderMark = 0;       // Size of the UTF-8 byte order mark before the first line
+    std::vector<Section> sections;
+    std::unordered_map<std::string, std::vector<size_t>> sectionIndex;
+    std::unordered_map<std::string, std::unordered_map<std::string, size_t>> keyIndex;
+    std::string appliedPendingPath;      // Path whose queued values were applied by load()
+    PendingIniValues appliedPendingValues;
+    bool loaded = false;
+    
+    static bool isSectionHeader(const std::string& trimmedLine) {
+        return findIniSectionEnd(trimmedLine) != std::string_view::npos;
+    }
+    
+    static std::string lineEnding(const std::string& line) {
+        if (line.size() >= 2 && line.compare(line.size() - 2, 2, "\r\n") == 0)
+            return "\r\n";
+        if (!line.empty() && line.back() == '\n')
+            return "\n";
+        return "";
+    }
+    
+    void reindex() {
+        sections.clear();
+        sectionIndex.clear();
+        keyIndex.clear();
+        
+        sections.push_back({"", std::string::npos, 0});
+        
+        IniLine iniLine;
+        for (size_t i = 0; i < lines.size(); ++i) {
+            iniLine = parseIniLine(lines[i]);
+            if (iniLine.type == IniLineType::Section) {
+                sections.back().endLine = i;
+                sections.push_back({std::string(iniLine.name), i, i + 1});
+                sectionIndex[sections.back().name].push_back(sections.size() - 1);
+                keyIndex[sections.back().name];
+            } else if (iniLine.type == IniLineType::KeyValue)
+                keyIndex[sections.back().name].emplace(std::string(iniLine.name), i); // First occurrence wins
+        }
+        sections.back().endLine = lines.size();
+    }
+    
+    /**
+     * @brief Finds sections whose unquoted, trimmed name matches (as setIniFile always did).
+     */
+    std::vector<size_t> findSectionsByName(const std::string& sectionName) const {
+        std::vector<size_t> matches;
+        const std::string desiredSection = trim(sectionName);
+        for (size_t i = 0; i < sections.size(); ++i) {
+            if (trim(removeQuotes(sections[i].name)) == desiredSection)
+                matches.push_back(i);
+        }
+        return matches;
+    }
+    
+    /**
+     * @brief Rewrites every line of the given sections whose key matches.
+     *
+     * @param newValue The value to write, or nullptr to keep each line's existing value.
+     * @return True if at least one line was rewritten.
+     */
+    bool replaceKeyLines(const std::vector<size_t>& sectionIds, const std::string& keyName, const std::string& newKeyName, const std::string* newValue) {
+        bool replaced = false;
+        std::string trimmedLine;
+        size_t delimiterPos;
+        for (size_t sectionId : sectionIds) {
+            const Section& section = sections[sectionId];
+            size_t firstLine = (section.headerLine == std::string::npos) ? 0 : section.headerLine + 1;
+            for (size_t i = firstLine; i < section.endLine; ++i) {
+                trimmedLine = trim(lines[i]);
+                delimiterPos = trimmedLine.find('=');
+                if (delimiterPos == std::string::npos || trim(trimmedLine.substr(0, delimiterPos)) != keyName)
+                    continue;
                 
-                // Store in the current section
-                parsedData[currentSection][key] = value;
+                std::string ending = lineEnding(lines[i]);
+                if (ending.empty())
+                    ending = "\n";
+                lines[i] = newKeyName + " = " + (newValue ? *newValue : getValueFromLine(trimmedLine)) + ending;
+                replaced = true;
             }
         }
+        return replaced;
+    }
+};
+
+
+/**
+ * @brief Applies the values queued for an INI file to its content.
+ *
+ * @param filePath The path to the INI file.
+ * @param content The file content, rewritten only if values are queued.
+ * @return True if any value is queued for the file, false otherwise.
+ */
+static bool applyPendingIniValues(const std::string& filePath, std::string& content) {
+    PendingIniValues pendingValues;
+    if (!getPendingIniValues(filePath, pendingValues))
+        return false;
+    
+    IniDocument iniDocument;
+    iniDocument.loadFromString(content);
+    iniDocument.applyPendingValues(filePath, std::move(pendingValues));
+    content = iniDocument.toString();
+    return true;
+}
+
+
+/**
+ * @brief Entry of the process-wide INI cache, validated against the file's size and mtime.
+ */
+struct IniCacheEntry {
+    off_t fileSize;
+    time_t modifiedTime;
+    std::shared_ptr<const IniDocument> document;
+};
+
+static std::unordered_map<std::string, IniCacheEntry> iniCache;
+static std::mutex iniCacheMutex;
+static size_t iniCacheHits = 0;
+static size_t iniCacheMisses = 0;
+
+/**
+ * @brief Normalizes a path into an INI cache key so "sdmc:/x.ini" and "/x.ini" share one entry.
+ */
+static std::string getIniCacheKey(const std::string& filePath) {
+    if (filePath.compare(0, 5, "sdmc:") == 0)
+        return filePath.substr(5);
+    return filePath;
+}
+
+/**
+ * @brief Returns the parsed document for an INI file, re-reading it only when it changed.
+ *
+ * The cached document is reused as long as the file's size and modification time are
+ * unchanged. Ultrahand's own INI writes invalidate the entry explicitly. The document holds
+ * the file as stored, so callers look up queued values with getPendingIniValue() first.
+ *
+ * @param filePath The path to the INI file.
+ * @return The parsed document, or nullptr if the file cannot be read.
+ */
+std::shared_ptr<const IniDocument> getCachedIniDocument(const std::string& filePath) {
+    struct stat fileStat;
+    if (stat(filePath.c_str(), &fileStat) != 0) {
+        recoverInterruptedIniSave(filePath);
+        if (stat(filePath.c_str(), &fileStat) != 0)
+            return nullptr;
+    }
+    
+    const std::string cacheKey = getIniCacheKey(filePath);
+    {
+        std::lock_guard<std::mutex> lock(iniCacheMutex);
+        auto it = iniCache.find(cacheKey);
+        if (it != iniCache.end() && it->second.fileSize == fileStat.st_size && it->second.modifiedTime == fileStat.st_mtime) {
+            ++iniCacheHits;
+            return it->second.document;
+        }
+        ++iniCacheMisses;
     }
     
-    delete[] fileData;
+    auto document = std::make_shared<IniDocument>();
+    if (!document->loadFromFile(filePath))
+        return nullptr;
+    
+    std::lock_guard<std::mutex> lock(iniCacheMutex);
+    iniCache[cacheKey] = {fileStat.st_size, fileStat.st_mtime, document};
+    return document;
+}
+
+/**
+ * @brief Drops the cached document of an INI file so the next read re-parses it.
+ *
+ * @param filePath The path to the INI file.
+ */
+void invalidateIniCache(const std::string& filePath) {
+    std::lock_guard<std::mutex> lock(iniCacheMutex);
+    iniCache.erase(getIniCacheKey(filePath));
+}
+
+/**
+ * @brief Drops all cached INI documents.
+ */
+void clearIniCache() {
+    std::lock_guard<std::mutex> lock(iniCacheMutex);
+    iniCache.clear();
+}
+
+/**
+ * @brief Retrieves the INI cache hit and miss counters.
+ *
+ * @param hits Receives the number of reads served from the cache.
+ * @param misses Receives the number of reads that had to parse the file.
+ */
+void getIniCacheStats(size_t& hits, size_t& misses) {
+    std::lock_guard<std::mutex> lock(iniCacheMutex);
+    hits = iniCacheHits;
+    misses = iniCacheMisses;
+}
+
+
+/**
+ * @brief The values queued for one INI file, together with the path they were queued for.
+ */
+struct PendingIniFile {
+    std::string filePath;
+    PendingIniValues values;
+};
+
+static std::unordered_map<std::string, PendingIniFile> pendingIniWrites;
+static std::mutex pendingIniWritesMutex;
+static std::chrono::steady_clock::time_point lastQueuedIniWrite;
+static std::chrono::milliseconds iniWriteBehindDelay(2000);
+
+/**
+ * @brief Queues a value for an INI file instead of rewriting the file immediately.
+ *
+ * Repeated writes to the same key are coalesced and only the latest value is written.
+ * Pending values are flushed by flushPendingIniWrites(), or by flushDueIniWrites() once the
+ * write-behind delay has elapsed. Until then, INI helpers that load the file read them as if
+ * they were already written.
+ *
+ * @param filePath The path to the INI file.
+ * @param sectionName The section of the key.
+ * @param keyName The key to set.
+ * @param value The new value.
+ */
+void queueIniFileValue(const std::string& filePath, const std::string& sectionName, const std::string& keyName, const std::string& value) {
+    std::lock_guard<std::mutex> lock(pendingIniWritesMutex);
+    PendingIniFile& pendingFile = pendingIniWrites[getIniCacheKey(filePath)];
+    if (pendingFile.filePath.empty())
+        pendingFile.filePath = filePath;
+    pendingFile.values[{sectionName, keyName}] = trim(value);
+    lastQueuedIniWrite = std::chrono::steady_clock::now();
+}
+
+/**
+ * @brief Looks up a value that is queued but not yet written.
+ *
+ * @param filePath The path to the INI file.
+ * @param sectionName The section of the key.
+ * @param keyName The key to look up.
+ * @param value Receives the pending value.
+ * @return True if a pending value exists, false otherwise.
+ */
+bool getPendingIniValue(const std::string& filePath, const std::string& sectionName, const std::string& keyName, std::string& value) {
+    std::lock_guard<std::mutex> lock(pendingIniWritesMutex);
+    auto fileIt = pendingIniWrites.find(getIniCacheKey(filePath));
+    if (fileIt == pendingIniWrites.end())
+        return false;
+    
+    auto valueIt = fileIt->second.values.find({sectionName, keyName});
+    if (valueIt == fileIt->second.values.end())
+        return false;
+    
+    value = valueIt->second;
+    return true;
+}
+
+/**
+ * @brief Copies all values that are queued but not yet written for an INI file.
+ *
+ * @param filePath The path to the INI file.
+ * @param values Receives the pending values.
+ * @return True if any value is pending, false otherwise.
+ */
+bool getPendingIniValues(const std::string& filePath, PendingIniValues& values) {
+    std::lock_guard<std::mutex> lock(pendingIniWritesMutex);
+    if (pendingIniWrites.empty())
+        return false;
+    
+    auto fileIt = pendingIniWrites.find(getIniCacheKey(filePath));
+    if (fileIt == pendingIniWrites.end())
+        return false;
+    
+    values = fileIt->second.values;
+    return true;
+}
+
+/**
+ * @brief Removes written values from the write-behind store.
+ *
+ * A value that was queued again with a different value since it was read stays queued.
+ *
+ * @param filePath The path to the INI file.
+ * @param writtenValues The values now stored in the file.
+ */
+void dropWrittenIniValues(const std::string& filePath, const PendingIniValues& writtenValues) {
+    std::lock_guard<std::mutex> lock(pendingIniWritesMutex);
+    auto fileIt = pendingIniWrites.find(getIniCacheKey(filePath));
+    if (fileIt == pendingIniWrites.end())
+        return;
     
-    return parsedData;
+    PendingIniValues& pendingValues = fileIt->second.values;
+    for (const auto& [sectionKey, value] : writtenValues) {
+        auto valueIt = pendingValues.find(sectionKey);
+        if (valueIt != pendingValues.end() && valueIt->second == value)
+            pendingValues.erase(valueIt);
+    }
+    if (pendingValues.empty())
+        pendingIniWrites.erase(fileIt);
 }
 
+/**
+ * @brief Sets how long queued values may stay unwritten after the last queued write.
+ *
+ * @param delay The write-behind delay.
+ */
+void setIniWriteBehindDelay(std::chrono::milliseconds delay) {
+    std::lock_guard<std::mutex> lock(pendingIniWritesMutex);
+    iniWriteBehindDelay = delay;
+}
 
 
 /**
@@ -348,71 +1281,36 @@ std::map<std::string, std::map<std::string, std::string>> getParsedDataFromIniFi
 std::vector<std::string> parseSectionsFromIni(const std::string& filePath) {
     std::vector<std::string> sections;
     
-    FILE* file = fopen(filePath.c_str(), "r");
-    if (file == nullptr) {
-        return sections; // Return an empty list if the file cannot be opened
+    // Queued values can add sections, so the file is then read with them applied
+    PendingIniValues pendingValues;
+    if (getPendingIniValues(filePath, pendingValues)) {
+        IniDocument iniDocument;
+        iniDocument.loadFromFile(filePath);
+        iniDocument.applyPendingValues(filePath, std::move(pendingValues));
+        return iniDocument.getSectionNames();
     }
     
-    //constexpr size_t BufferSize = 131072;
-    char line[BufferSize];
-    
-    std::string trimmedLine;
-    while (fgets(line, sizeof(line), file)) {
-        trimmedLine = trim(std::string(line));
-        
-        if (!trimmedLine.empty() && trimmedLine[0] == '[' && trimmedLine.back() == ']') {
-            // Extract section name and add it to the list
-            std::string sectionName = trimmedLine.substr(1, trimmedLine.size() - 2);
-            sections.push_back(sectionName);
-        }
-    }
+    readIniSections(filePath.c_str(), [&sections](std::string_view sectionName) {
+        sections.emplace_back(sectionName);
+        return true;
+    });
     
-    fclose(file);
-    return sections;
+    return sections; // Empty if the file cannot be opened
 }
 
 
 
 std::string parseValueFromIniSection(const std::string& filePath, const std::string& sectionName, const std::string& keyName) {
-    std::string value = "";
+    std::string pendingValue;
+    if (getPendingIniValue(filePath, sectionName, keyName, pendingValue))
+        return pendingValue;
     
-    FILE* file = fopen(filePath.c_str(), "r");
-    if (file == nullptr) {
-        return value; // Return an empty string if the file cannot be opened
-    }
-    
-    std::string currentSection = "";
-    char line[BufferSize];
-    
-    size_t delimiterPos;
-    
-    std::string trimmedLine;
-    std::string currentKey;
-    
-    while (fgets(line, sizeof(line), file)) {
-        trimmedLine = trim(std::string(line));
-        
-        if (!trimmedLine.empty()) {
-            if (trimmedLine[0] == '[' && trimmedLine.back() == ']') {
-                // This line is a section header
-                currentSection = trimmedLine.substr(1, trimmedLine.size() - 2);
-            } else if (currentSection == sectionName) {
-                // Check if the line is within the desired section and contains the desired key
-                delimiterPos = trimmedLine.find('=');
-                if (delimiterPos != std::string::npos) {
-                    currentKey = trim(trimmedLine.substr(0, delimiterPos));
-                    if (currentKey == keyName) {
-                        value = trim(trimmedLine.substr(delimiterPos + 1));
-                        break; // Found the key, exit the loop
-                    }
-                }
-            }
-        }
+    std::shared_ptr<const IniDocument> iniDocument = getCachedIniDocument(filePath);
+    if (!iniDocument) {
+        return ""; // Return an empty string if the file cannot be opened
     }
     
-    fclose(file);
-    
-    return value;
+    return iniDocument->getValue(sectionName, keyName);
 }
 
 
@@ -424,33 +1322,14 @@ std::string parseValueFromIniSectionF(FILE*& file, const std::string& filePath,
         return value; // Return an empty string if the file cannot be opened
     }
     
-    std::string currentSection = "";
-    //constexpr size_t BufferSize = 131072;
-    char line[BufferSize];
-    
-    std::string trimmedLine;
-    size_t delimiterPos;
-    
-    while (fgets(line, sizeof(line), file)) {
-        trimmedLine = trim(std::string(line));
-        
-        if (!trimmedLine.empty()) {
-            if (trimmedLine[0] == '[' && trimmedLine.back() == ']') {
-                // This line is a section header
-                currentSection = trimmedLine.substr(1, trimmedLine.size() - 2);
-            } else if (currentSection == sectionName) {
-                // Check if the line is within the desired section and contains the desired key
-                delimiterPos = trimmedLine.find('=');
-                if (delimiterPos != std::string::npos) {
-                    std::string currentKey = trim(trimmedLine.substr(0, delimiterPos));
-                    if (currentKey == keyName) {
-                        value = trim(trimmedLine.substr(delimiterPos + 1));
-                        break; // Found the key, exit the loop
-                    }
-                }
-            }
-        }
-    }
+    readIniStream(file,
+        [](std::string_view) { return true; },
+        [&](std::string_view currentSection, std::string_view currentKey, std::string_view currentValue) {
+            if (currentSection != sectionName || currentKey != keyName)
+                return true;
+            value = currentValue;
+            return false; // Found the key, stop reading
+        });
     
     //fclose(file);
     
@@ -471,48 +1350,16 @@ std::string parseValueFromIniSectionF(FILE*& file, const std::string& filePath,
  * @param filePath The path to the INI file to be cleaned.
  */
 void cleanIniFormatting(const std::string& filePath) {
-    FILE* inputFile = fopen(filePath.c_str(), "r");
-    if (!inputFile) {
+    IniDocument iniDocument;
+    if (!iniDocument.load(filePath)) {
         // Failed to open the input file
         // Handle the error accordingly
         return;
     }
     
-    std::string tempPath = filePath + ".tmp";
-    FILE* outputFile = fopen(tempPath.c_str(), "w");
-    if (!outputFile) {
-        // Failed to create the output file
-        // Handle the error accordingly
-        fclose(inputFile);
-        return;
-    }
-    
-    bool isNewSection = false;
-    
-    char line[BufferSize];
-    
-    std::string trimmedLine;
-    while (fgets(line, sizeof(line), inputFile)) {
-        trimmedLine = trim(std::string(line));
-        
-        if (!trimmedLine.empty()) {
-            if (trimmedLine[0] == '[' && trimmedLine[trimmedLine.length() - 1] == ']') {
-                if (isNewSection) {
-                    fprintf(outputFile, "\n");
-                }
-                isNewSection = true;
-            }
-            
-            fprintf(outputFile, "%s\n", trimmedLine.c_str());
-        }
-    }
-    
-    fclose(inputFile);
-    fclose(outputFile);
-    
-    // Remove the original file and rename the temp file
-    remove(filePath.c_str());
-    rename(tempPath.c_str(), filePath.c_str());
+    iniDocument.cleanFormatting();
+    iniDocument.save(filePath);
+    invalidateIniCache(filePath);
 }
 
 
@@ -531,128 +1378,29 @@ void cleanIniFormatting(const std::string& filePath) {
  * @param desiredNewKey   (Optional) If provided, the function will rename the key while preserving the original value.
  */
 void setIniFile(const std::string& fileToEdit, const std::string& desiredSection, const std::string& desiredKey, const std::string& desiredValue, const std::string& desiredNewKey, const std::string& comment) {
-    FILE* configFile = fopen(fileToEdit.c_str(), "r");
-    if (!configFile) {
+    IniDocument iniDocument;
+    if (!iniDocument.load(fileToEdit)) {
         createDirectory(removeFilename(fileToEdit));
-        configFile = fopen(fileToEdit.c_str(), "w");
+        FILE* configFile = fopen(fileToEdit.c_str(), "w");
         if (!configFile) {
             // Handle the error accordingly
             return;
         }
         fprintf(configFile, (comment+std::string("[%s]\n%s = %s\n")).c_str(), desiredSection.c_str(), desiredKey.c_str(), desiredValue.c_str());
         fclose(configFile);
+        invalidateIniCache(fileToEdit);
+        invalidateDirectoryListing(fileToEdit);
         return;
     }
     
-    // Create a buffer to store the updated content
-    std::string updatedContent;
-    std::string currentSection;
-    std::string formattedDesiredValue = trim(desiredValue);
-    char line[BufferSize];
-    
-    bool sectionFound = false;
-    bool keyFound = false;
-    bool addNewLine = false;
+    if (!desiredNewKey.empty()) {
+        if (!iniDocument.renameKey(desiredSection, desiredKey, desiredNewKey))
+            return; // Nothing to rename
+    } else
+        iniDocument.setValue(desiredSection, desiredKey, desiredValue);
     
-    std::string trimmedLine;
-    size_t delimiterPos;
-    std::string lineKey, originalValue;
-    
-    while (fgets(line, sizeof(line), configFile)) {
-        trimmedLine = trim(line);
-        
-        if (trimmedLine[0] == '[' && trimmedLine.back() == ']') {
-            currentSection = removeQuotes(trimmedLine.substr(1, trimmedLine.length() - 2));
-            if (sectionFound && !keyFound && desiredNewKey.empty()) {
-                if (!updatedContent.empty() && updatedContent.substr(updatedContent.length() - 2) == "\n\n") {
-                    updatedContent = updatedContent.substr(0, updatedContent.length() - 1);
-                    addNewLine = true;
-                }
-                updatedContent += desiredKey + " = " + formattedDesiredValue + "\n";
-                
-                if (addNewLine) { // if it ended with \n\n, add one more newline
-                    updatedContent += "\n";
-                    addNewLine = false;
-                }
-                keyFound = true;
-            }
-        }
-        
-        if (sectionFound && !keyFound && desiredNewKey.empty() && trim(currentSection) != trim(desiredSection)) {
-            if (!updatedContent.empty() && updatedContent.substr(updatedContent.length() - 2) == "\n\n") {
-                updatedContent = updatedContent.substr(0, updatedContent.length() - 1);
-                addNewLine = true;
-            }
-            updatedContent += desiredKey + " = " + formattedDesiredValue + "\n";
-            // Add a newline character if the last part of updatedContent initially had "\n"
-            if (addNewLine) {
-                updatedContent += "\n";
-                addNewLine = false;
-            }
-            keyFound = true;
-        }
-        
-        if (trim(currentSection) == trim(desiredSection)) {
-            sectionFound = true;
-            delimiterPos = trimmedLine.find('=');
-            
-            if (delimiterPos != std::string::npos) {
-                lineKey = trim(trimmedLine.substr(0, delimiterPos));
-                
-                if (lineKey == desiredKey) {
-                    keyFound = true;
-                    originalValue = getValueFromLine(trimmedLine);
-                    if (!updatedContent.empty() && updatedContent.substr(updatedContent.length() - 2) == "\n\n") {
-                        updatedContent = updatedContent.substr(0, updatedContent.length() - 1);
-                        addNewLine = true;
-                    }
-                    
-                    if (!desiredNewKey.empty()) {
-                        updatedContent += desiredNewKey + " = " + originalValue + "\n";
-                    } else {
-                        updatedContent += desiredKey + " = " + formattedDesiredValue + "\n";
-                    }
-                    
-                    // Add a newline character if the last part of updatedContent initially had "\n"
-                    if (addNewLine) {
-                        updatedContent += "\n";
-                        addNewLine = false;
-                    }
-                    continue;
-                }
-            }
-        }
-        
-        updatedContent += line;
-    }
-    
-    if (sectionFound && !keyFound && desiredNewKey.empty()) {
-        if (!updatedContent.empty() && updatedContent.substr(updatedContent.length() - 2) == "\n\n") {
-            updatedContent = updatedContent.substr(0, updatedContent.length() - 1);
-            addNewLine = true;
-        }
-        updatedContent += desiredKey + " = " + formattedDesiredValue + "\n";
-        // Add a newline character if the last part of updatedContent initially had "\n"
-        if (addNewLine) {
-            updatedContent += "\n";
-            addNewLine = false;
-        }
-    }
-
-    if (!sectionFound && !keyFound && desiredNewKey.empty()) {
-        updatedContent += "\n[" + desiredSection + "]\n" + desiredKey + " = " + formattedDesiredValue + "\n";
-    }
-
-    fclose(configFile);
-
-    // Reopen the original file for writing and overwrite its content
-    configFile = fopen(fileToEdit.c_str(), "w");
-    if (!configFile) {
-        // Handle the error accordingly
-        return;
-    }
-    fprintf(configFile, "%s", updatedContent.c_str());
-    fclose(configFile);
+    iniDocument.save(fileToEdit);
+    invalidateIniCache(fileToEdit);
 }
 
 
@@ -705,56 +1453,16 @@ void setIniFileKey(const std::string& fileToEdit, const std::string& desiredSect
  * @param sectionName The name of the section to add.
  */
 void addIniSection(const char* filePath, const char* sectionName) {
-    if (!isFileOrDirectory(filePath)) {
+    IniDocument iniDocument;
+    if (!iniDocument.load(filePath)) {
         // INI file doesn't exist, handle the error accordingly
-        //std::cerr << "Error: INI file not found." << std::endl;
         return;
     }
     
-    // Read the existing contents of the INI file
-    FILE* inputFile = fopen(filePath, "r");
-    if (!inputFile) {
-        //std::cerr << "Error: Failed to open INI file for reading." << std::endl;
-        return;
-    }
-    
-    FILE* tempFile = fopen("temp.ini", "w");
-    if (!tempFile) {
-        //std::cerr << "Error: Failed to create a temporary file." << std::endl;
-        fclose(inputFile);
-        return;
+    if (iniDocument.addSection(sectionName)) {
+        iniDocument.save(filePath);
+        invalidateIniCache(filePath);
     }
-    
-    //constexpr size_t BufferSize = 131072;
-    char line[BufferSize];
-    bool sectionExists = false;
-    while (fgets(line, sizeof(line), inputFile)) {
-        // Check if the line contains the section
-        if (line[0] == '[' && strncmp(&line[1], sectionName, strlen(sectionName)) == 0) {
-            sectionExists = true;
-            break;  // Section already exists, no need to continue
-        }
-        fputs(line, tempFile);
-    }
-    
-    if (!sectionExists) {
-        // Section doesn't exist, add it
-        fprintf(tempFile, "[%s]\n", sectionName);
-    }
-    
-    // Copy the rest of the input file to the temp file
-    while (fgets(line, sizeof(line), inputFile)) {
-        fputs(line, tempFile);
-    }
-    
-    fclose(inputFile);
-    fclose(tempFile);
-    
-    // Replace the original file with the temp file
-    remove(filePath);  // Delete the old configuration file
-    rename("temp.ini", filePath);  // Rename the temp file to the original name
-    
-    //std::cout << "Section '" << sectionName << "' added to the INI file." << std::endl;
 }
 
 
@@ -773,63 +1481,15 @@ void addIniSection(const char* filePath, const char* sectionName) {
  * @param newSectionName The new name for the section.
  */
 void renameIniSection(const std::string& filePath, const std::string& currentSectionName, const std::string& newSectionName) {
-    FILE* configFile = fopen(filePath.c_str(), "r");
-    if (!configFile) {
+    IniDocument iniDocument;
+    if (!iniDocument.load(filePath)) {
         // The INI file doesn't exist, handle the error accordingly
         return;
     }
     
-    std::string tempPath = filePath + ".tmp";
-    FILE* tempFile = fopen(tempPath.c_str(), "w");
-    if (!tempFile) {
-        // Failed to create a temporary file, handle the error accordingly
-        fclose(configFile);
-        return;
-    }
-    
-    std::string currentSection;
-    bool renaming = false;
-    //constexpr size_t BufferSize = 131072;
-    char line[BufferSize];
-    
-    std::string currentLine, sectionName;
-    while (fgets(line, sizeof(line), configFile)) {
-        currentLine = trim(std::string(line));
-        
-        // Check if the line represents a section
-        if (currentLine.length() > 2 && currentLine.front() == '[' && currentLine.back() == ']') {
-            sectionName = currentLine.substr(1, currentLine.size() - 2);
-            
-            if (sectionName == currentSectionName) {
-                // We found the section to rename
-                fprintf(tempFile, "[%s]\n", newSectionName.c_str());
-                renaming = true;
-            } else {
-                // Copy the line as is
-                fprintf(tempFile, "%s", currentLine.c_str());
-                renaming = false;
-            }
-        } else if (renaming) {
-            // Rename the section in the following lines
-            fprintf(tempFile, "[%s]\n", newSectionName.c_str());
-            renaming = false;
-        } else {
-            // Copy the line as is
-            fprintf(tempFile, "%s", currentLine.c_str());
-        }
-    }
-    
-    fclose(configFile);
-    fclose(tempFile);
-    
-    // Replace the original file with the temp file
-    if (remove(filePath.c_str()) != 0) {
-        // Failed to delete the original file, handle the error accordingly
-        return;
-    }
-    
-    if (rename(tempPath.c_str(), filePath.c_str()) != 0) {
-        // Failed to rename the temp file, handle the error accordingly
+    if (iniDocument.renameSection(currentSectionName, newSectionName)) {
+        iniDocument.save(filePath);
+        invalidateIniCache(filePath);
     }
 }
 
@@ -847,62 +1507,219 @@ void renameIniSection(const std::string& filePath, const std::string& currentSec
  * @param sectionName The name of the section to remove.
  */
 void removeIniSection(const std::string& filePath, const std::string& sectionName) {
-    FILE* configFile = fopen(filePath.c_str(), "r");
-    if (!configFile) {
+    IniDocument iniDocument;
+    if (!iniDocument.load(filePath)) {
         // The INI file doesn't exist, or there was an error opening it.
         // Handle the error accordingly or return.
         return;
     }
     
-    std::string tempPath = filePath + ".tmp";
-    FILE* tempFile = fopen(tempPath.c_str(), "w");
-    if (!tempFile) {
-        // Failed to create a temporary file, handle the error accordingly
-        fclose(configFile);
-        // Handle the error or return.
-        return;
+    if (iniDocument.removeSection(sectionName)) {
+        iniDocument.save(filePath);
+        invalidateIniCache(filePath);
+    }
+}
+
+
+
+/**
+ * @brief Batches many edits to one INI file into a single write.
+ *
+ * The file is loaded once by begin(), every edit is applied to the in-memory document
+ * (reads through getValue() see pending edits), and commit() writes the result once
+ * through a temporary file that then replaces the original. Nothing is written unless
+ * an edit actually happened.
+ */
+class IniTransaction {
+public:
+    IniTransaction() = default;
+    explicit IniTransaction(const std::string& filePath) { begin(filePath); }
+    
+    /**
+     * @brief Starts a transaction on the specified INI file, discarding any pending edits.
+     *
+     * @param filePath The path to the INI file. It does not need to exist yet.
+     */
+    void begin(const std::string& filePath) {
+        this->filePath = filePath;
+        fileExists = iniDocument.load(filePath);
+        dirty = false;
     }
     
-    std::string currentSection;
-    bool removing = false;
-    //constexpr size_t BufferSize = 131072;
-    char line[BufferSize];
+    std::string getValue(const std::string& sectionName, const std::string& keyName) const {
+        return iniDocument.getValue(sectionName, keyName);
+    }
     
-    std::string currentLine, _section;
+    bool getValue(const std::string& sectionName, const std::string& keyName, std::string& value) const {
+        return iniDocument.getValue(sectionName, keyName, value);
+    }
+    
+    bool hasSection(const std::string& sectionName) const {
+        return iniDocument.hasSection(sectionName);
+    }
+    
+    bool hasKey(const std::string& sectionName, const std::string& keyName) const {
+        std::string value;
+        return iniDocument.getValue(sectionName, keyName, value);
+    }
+    
+    bool exists() const { return fileExists; }
+    
+    void setValue(const std::string& sectionName, const std::string& keyName, const std::string& value) {
+        std::string currentValue;
+        if (iniDocument.getValue(sectionName, keyName, currentValue) && currentValue == trim(value))
+            return; // Unchanged
+        iniDocument.setValue(sectionName, keyName, value);
+        dirty = true;
+    }
     
-    while (fgets(line, sizeof(line), configFile)) {
-        currentLine = trim(std::string(line));
+    void setKey(const std::string& sectionName, const std::string& keyName, const std::string& newKeyName) {
+        dirty = iniDocument.renameKey(sectionName, keyName, newKeyName) || dirty;
+    }
+    
+    void removeKey(const std::string& sectionName, const std::string& keyName) {
+        dirty = iniDocument.removeKey(sectionName, keyName) || dirty;
+    }
+    
+    void addSection(const std::string& sectionName) {
+        dirty = iniDocument.addSection(sectionName) || dirty;
+    }
+    
+    void renameSection(const std::string& currentSectionName, const std::string& newSectionName) {
+        dirty = iniDocument.renameSection(currentSectionName, newSectionName) || dirty;
+    }
+    
+    void removeSection(const std::string& sectionName) {
+        dirty = iniDocument.removeSection(sectionName) || dirty;
+    }
+    
+    bool isDirty() const { return dirty; }
+    
+    /**
+     * @brief Writes all pending edits with a single atomic replace of the file.
+     *
+     * @return True if the file is up to date, false if writing failed.
+     */
+    bool commit() {
+        if (!dirty)
+            return true;
         
-        // Check if the line represents a section
-        if (currentLine.length() > 2 && currentLine.front() == '[' && currentLine.back() == ']') {
-            _section = currentLine.substr(1, currentLine.size() - 2);
-            
-            if (_section == sectionName) {
-                // We found the section to remove, so skip it and associated key-value pairs
-                removing = true;
-            } else {
-                // Keep other sections
-                fprintf(tempFile, "%s\n", currentLine.c_str());
-                removing = false;
-            }
-        } else if (!removing) {
-            // Keep lines outside of the section
-            fprintf(tempFile, "%s\n", currentLine.c_str());
+        if (!fileExists)
+            createDirectory(removeFilename(filePath));
+        
+        bool success = iniDocument.save(filePath);
+        invalidateIniCache(filePath);
+        if (success) {
+            fileExists = true;
+            dirty = false;
         }
+        return success;
+    }
+    
+    /**
+     * @brief Discards all pending edits by reloading the file.
+     */
+    void rollback() {
+        begin(filePath);
     }
     
-    fclose(configFile);
-    fclose(tempFile);
+private:
+    std::string filePath;
+    IniDocument iniDocument;
+    bool fileExists = false;
+    bool dirty = false;
+};
+
+
+/**
+ * @brief Writes the queued values of one file with a single atomic replace.
+ *
+ * The file is loaded as stored, so the write never re-enters the store. The values stay
+ * queued until they are written, so reads see them throughout, and a value queued again
+ * meanwhile is kept for the next flush instead of being overwritten by the older one.
+ * If the write fails, flushDueIniWrites() waits another write-behind delay before retrying.
+ *
+ * @param filePath The path to the INI file.
+ * @return True if nothing was pending or the file was written, false otherwise.
+ */
+static bool writePendingIniFile(const std::string& filePath) {
+    PendingIniValues pendingValues;
+    if (!getPendingIniValues(filePath, pendingValues))
+        return true;
+    
+    IniDocument iniDocument;
+    const bool fileExists = iniDocument.loadFromFile(filePath);
+    
+    bool dirty = false;
+    std::string currentValue;
+    for (const auto& [sectionKey, value] : pendingValues) {
+        if (iniDocument.getValue(sectionKey.first, sectionKey.second, currentValue) && currentValue == value)
+            continue; // Unchanged
+        iniDocument.setValue(sectionKey.first, sectionKey.second, value);
+        dirty = true;
+    }
     
-    // Replace the original file with the temp file
-    if (remove(filePath.c_str()) != 0) {
-        // Failed to delete the original file, handle the error accordingly
-        return;
+    bool success = true;
+    if (dirty) {
+        if (!fileExists)
+            createDirectory(removeFilename(filePath));
+        success = iniDocument.save(filePath);
+        invalidateIniCache(filePath);
     }
     
-    if (rename(tempPath.c_str(), filePath.c_str()) != 0) {
-        // Failed to rename the temp file, handle the error accordingly
+    if (success) {
+        dropWrittenIniValues(filePath, pendingValues);
+        return true;
     }
+    
+    logMessage("Failed to flush pending writes to " + filePath + ".");
+    
+    std::lock_guard<std::mutex> lock(pendingIniWritesMutex);
+    lastQueuedIniWrite = std::chrono::steady_clock::now(); // Retry after the write-behind delay, not every frame
+    return false;
 }
 
+/**
+ * @brief Writes the queued values of an INI file, if any.
+ *
+ * @param filePath The path to the INI file.
+ * @return True if nothing was pending or the file was written, false otherwise.
+ */
+bool flushPendingIniWrites(const std::string& filePath) {
+    return writePendingIniFile(filePath);
+}
 
+/**
+ * @brief Writes the queued values of all INI files.
+ *
+ * Called when the overlay is hidden, closed or hands over to another overlay.
+ *
+ * @return True if every file was written, false otherwise.
+ */
+bool flushPendingIniWrites() {
+    std::vector<std::string> filePaths;
+    {
+        std::lock_guard<std::mutex> lock(pendingIniWritesMutex);
+        if (pendingIniWrites.empty())
+            return true;
+        for (const auto& [cacheKey, pendingFile] : pendingIniWrites)
+            filePaths.push_back(pendingFile.filePath);
+    }
+    
+    bool success = true;
+    for (const auto& filePath : filePaths)
+        success = writePendingIniFile(filePath) && success;
+    return success;
+}
+
+/**
+ * @brief Flushes the queued values once the write-behind delay has passed since the last queued write.
+ */
+void flushDueIniWrites() {
+    {
+        std::lock_guard<std::mutex> lock(pendingIniWritesMutex);
+        if (pendingIniWrites.empty() || std::chrono::steady_clock::now() - lastQueuedIniWrite < iniWriteBehindDelay)
+            return;
+    }
+    flushPendingIniWrites();
+}
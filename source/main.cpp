@@ -542,6 +542,8 @@ public:
                         copyFileOrDirectory(defaultTheme, themeConfigIniPath);
                     else
                         initializeTheme(); // write default theme
+                    invalidateIniCache(themeConfigIniPath);
+                    tsl::reloadThemeTable();
                     
                     reloadMenu = true;
                     reloadMenu2 = true;
@@ -587,8 +589,10 @@ public:
                         setIniFileValue(settingsConfigIniPath, "ultrahand", "current_theme", themeName);
                         deleteFileOrDirectory(themeConfigIniPath);
                         copyFileOrDirectory(themeFile, themeConfigIniPath);
+                        invalidateIniCache(themeConfigIniPath);
                         
                         initializeTheme();
+                        tsl::reloadThemeTable();
                         
                         reloadMenu = true;
                         reloadMenu2 = true;
@@ -1341,7 +1345,7 @@ public:
      */
     virtual tsl::elm::Element* createUI() override {
         inSelectionMenu = true;
-        PackageHeader packageHeader = getPackageHeaderFromIni(filePath+packageFileName);
+        PackageHeader packageHeader = getCachedPackageHeader(filePath+packageFileName);
         std::vector<std::string> filesList, filesListOn, filesListOff, filterList, filterListOn, filterListOff;
         
         tsl::elm::List *list = new tsl::elm::List();
@@ -1434,14 +1438,14 @@ public:
                         sourceType = "file";
                         if (currentSection == "global") {
                             pathPattern = cmd[1];
-                            filesList = getFilesListByWildcards(pathPattern);
+                            filesList = getFilesListByWildcards(pathPattern, true);
                         } else if (currentSection == "on") {
                             pathPatternOn = cmd[1];
-                            filesListOn = getFilesListByWildcards(pathPatternOn);
+                            filesListOn = getFilesListByWildcards(pathPatternOn, true);
                             sourceTypeOn = "file";
                         } else if (currentSection == "off") {
                             pathPatternOff = cmd[1];
-                            filesListOff = getFilesListByWildcards(pathPatternOff);
+                            filesListOff = getFilesListByWildcards(pathPatternOff, true);
                             sourceTypeOff = "file";
                         }
                     } else if (commandName == "json_file_source") {
@@ -1902,7 +1906,7 @@ public:
         // Load options from INI file in the subdirectory
         std::string packageIniPath = packagePath + packageFileName;
         std::string packageConfigIniPath = packagePath + configFileName;
-        PackageHeader packageHeader = getPackageHeaderFromIni(packageIniPath);
+        PackageHeader packageHeader = getCachedPackageHeader(packageIniPath);
         
         //rootFrame = new tsl::elm::OverlayFrame(getNameFromPath(packagePath), "Ultrahand Package", "", packageHeader.color);
         tsl::elm::List *list = new tsl::elm::List();
@@ -1910,7 +1914,8 @@ public:
         auto toggleListItem = static_cast<tsl::elm::ToggleListItem*>(nullptr);
         bool toggleStateOn;
         
-        std::vector<std::pair<std::string, std::vector<std::vector<std::string>>>> options = loadOptionsFromIni(packageIniPath);
+        std::vector<OptionSection> options = indexOptionsFromIni(packageIniPath); // commands are loaded per section below
+        FILE* packageIniFile = openOptionsIni(packageIniPath); // one handle for all drawn sections
         
         
         bool skipSection = false;
@@ -1948,10 +1953,9 @@ public:
         
         
         for (size_t i = 0; i < options.size(); ++i) {
-            auto& option = options[i];
+            const auto& option = options[i];
             
-            optionName = option.first;
-            commands = std::move(option.second);
+            optionName = option.name;
             
             footer = "";
             useSelection = false;
@@ -1974,6 +1978,7 @@ public:
             //std::vector<std::string> selectedItemsList, selectedItemsListOn, selectedItemsListOff;
             
             if (drawLocation.empty() || currentPage == drawLocation || (optionName[0] == '@')) {
+                commands = loadOptionCommandsFromIni(packageIniFile, option, packageIniPath); // only sections on the current page are parsed
                 
                 // Custom header implementation
                 if (!dropdownSection.empty()) {
@@ -2212,7 +2217,7 @@ public:
                             listItem->setValue(UNAVAILABLE_SELECTION, true);
                         
                         //std::vector<std::vector<std::string>> modifiedCommands = getModifyCommands(option.second, pathReplace);
-                        listItem->setClickListener([commands, keyName = option.first, this, packagePath = this->packagePath, footer, lastSection, listItem](uint64_t keys) {
+                        listItem->setClickListener([commands, keyName = option.name, this, packagePath = this->packagePath, footer, lastSection, listItem](uint64_t keys) {
                             if (simulatedSelect && !simulatedSelectComplete) {
                                 keys |= KEY_A;
                                 simulatedSelect = false;
@@ -2274,7 +2279,7 @@ public:
                                 listItem->setValue(footer);
                             
                             
-                            listItem->setClickListener([this, i, commands, keyName = option.first, selectedItem, listItem](uint64_t keys) { // Add 'command' to the capture list
+                            listItem->setClickListener([this, i, commands, keyName = option.name, selectedItem, listItem](uint64_t keys) { // Add 'command' to the capture list
                                 if (simulatedSelect && !simulatedSelectComplete) {
                                     keys |= KEY_A;
                                     simulatedSelect = false;
@@ -2326,13 +2331,13 @@ public:
                             
                             toggleListItem->setState(toggleStateOn);
                             
-                            toggleListItem->setStateChangedListener([this, i, commandsOn, commandsOff, toggleStateOn, keyName = option.first](bool state) {
+                            toggleListItem->setStateChangedListener([this, i, commandsOn, commandsOff, toggleStateOn, keyName = option.name](bool state) {
                                 if (state) {
                                     interpretAndExecuteCommand(getSourceReplacement(commandsOn, preprocessPath(pathPatternOn), i), packagePath, keyName); // Execute modified
-                                    setIniFileValue((packagePath+configFileName).c_str(), keyName.c_str(), "footer", "On");
+                                    queueIniFileValue(packagePath+configFileName, keyName, "footer", "On");
                                 } else {
                                     interpretAndExecuteCommand(getSourceReplacement(commandsOff, preprocessPath(pathPatternOff), i), packagePath, keyName); // Execute modified
-                                    setIniFileValue((packagePath+configFileName).c_str(), keyName.c_str(), "footer", "Off");
+                                    queueIniFileValue(packagePath+configFileName, keyName, "footer", "Off");
                                 }
                             });
                             list->addItem(toggleListItem);
@@ -2342,6 +2347,8 @@ public:
             }
         }
         
+        if (packageIniFile)
+            fclose(packageIniFile);
         options.clear();
         
         tsl::elm::OverlayFrame *rootFrame = nullptr;
@@ -2439,8 +2446,8 @@ public:
                 inPackageMenu = false;
                 returningToMain = true;
                 
-                // Free-up memory
-                hexSumCache.clear();
+                // Free-up memory, anchor offsets stay cached on the SD card
+                releaseHexAnchorCache();
                 selectedFooterDict.clear(); // Clears all data from the map, making it empty again
                 selectedListItem = new tsl::elm::ListItem("");
                 lastSelectedListItem = new tsl::elm::ListItem("");
@@ -2541,7 +2548,7 @@ public:
         if (!inHiddenMode)
             inMainMenu = true;
         
-        tsl::hlp::ini::IniData settingsData, packageConfigData;
+        tsl::hlp::ini::IniData packageConfigData;
         std::string packagePath, pathReplace, pathReplaceOn, pathReplaceOff;
         std::string filePath, specificKey, pathPattern, pathPatternOn, pathPatternOff, itemName, parentDirName, lastParentDirName;
         std::vector<std::string> filesList, filesListOn, filesListOff, filterList, filterListOn, filterListOff;
@@ -2556,74 +2563,74 @@ public:
         createDirectory(packageDirectory);
         createDirectory(settingsPath);
         
+        IniTransaction settingsTransaction(settingsConfigIniPath);
         bool settingsLoaded = false;
-        if (isFileOrDirectory(settingsConfigIniPath)) {
-            settingsData = getParsedDataFromIniFile(settingsConfigIniPath);
-            if (settingsData.count("ultrahand") > 0) {
-                auto& ultrahandSection = settingsData["ultrahand"];
+        std::string settingsValue;
+        if (settingsTransaction.exists()) {
+            if (settingsTransaction.hasSection("ultrahand")) {
                 
-                if (ultrahandSection.count("hide_user_guide") > 0)
-                    hideUserGuide = ultrahandSection["hide_user_guide"];
+                if (settingsTransaction.getValue("ultrahand", "hide_user_guide", settingsValue))
+                    hideUserGuide = settingsValue;
                 else {
-                    setIniFileValue(settingsConfigIniPath, "ultrahand", "hide_user_guide", "false");
+                    settingsTransaction.setValue("ultrahand", "hide_user_guide", "false");
                 }
                 
-                if (ultrahandSection.count("clean_version_labels") > 0)
-                    cleanVersionLabels = ultrahandSection["clean_version_labels"];
+                if (settingsTransaction.getValue("ultrahand", "clean_version_labels", settingsValue))
+                    cleanVersionLabels = settingsValue;
                 else {
-                    setIniFileValue(settingsConfigIniPath, "ultrahand", "clean_version_labels", "true");
+                    settingsTransaction.setValue("ultrahand", "clean_version_labels", "true");
                     cleanVersionLabels = "false";
                 }
                 
                 // For hiding the versions of overlays/packages
-                if (ultrahandSection.count("hide_overlay_versions") > 0)
-                    hideOverlayVersions = ultrahandSection["hide_overlay_versions"];
+                if (settingsTransaction.getValue("ultrahand", "hide_overlay_versions", settingsValue))
+                    hideOverlayVersions = settingsValue;
                 else {
-                    setIniFileValue(settingsConfigIniPath, "ultrahand", "hide_overlay_versions", "false");
+                    settingsTransaction.setValue("ultrahand", "hide_overlay_versions", "false");
                     hideOverlayVersions = "false";
                 }
-                if (ultrahandSection.count("hide_package_versions") > 0)
-                    hidePackageVersions = ultrahandSection["hide_package_versions"];
+                if (settingsTransaction.getValue("ultrahand", "hide_package_versions", settingsValue))
+                    hidePackageVersions = settingsValue;
                 else {
-                    setIniFileValue(settingsConfigIniPath, "ultrahand", "hide_package_versions", "false");
+                    settingsTransaction.setValue("ultrahand", "hide_package_versions", "false");
                     hidePackageVersions = "false";
                 }
                 
-                if (ultrahandSection.count("last_menu") > 0) {
-                    menuMode = ultrahandSection["last_menu"];
-                    if (ultrahandSection.count("default_menu") > 0) {
-                        defaultMenuMode = ultrahandSection["default_menu"];
-                        if (ultrahandSection.count("in_overlay") > 0)
+                if (settingsTransaction.getValue("ultrahand", "last_menu", settingsValue)) {
+                    menuMode = settingsValue;
+                    if (settingsTransaction.getValue("ultrahand", "default_menu", settingsValue)) {
+                        defaultMenuMode = settingsValue;
+                        if (settingsTransaction.hasKey("ultrahand", "in_overlay"))
                             settingsLoaded = true;
                     }
                 }
                 
-                if (ultrahandSection.count("default_lang") > 0)
-                    defaultLang = ultrahandSection["default_lang"];
+                if (settingsTransaction.getValue("ultrahand", "default_lang", settingsValue))
+                    defaultLang = settingsValue;
                 else
-                    setIniFileValue(settingsConfigIniPath, "ultrahand", "default_lang", defaultLang);
+                    settingsTransaction.setValue("ultrahand", "default_lang", defaultLang);
                 
-                if (ultrahandSection.count("datetime_format") == 0)
-                    setIniFileValue(settingsConfigIniPath, "ultrahand", "datetime_format", DEFAULT_DT_FORMAT);
+                if (!settingsTransaction.hasKey("ultrahand", "datetime_format"))
+                    settingsTransaction.setValue("ultrahand", "datetime_format", DEFAULT_DT_FORMAT);
                 
-                if (ultrahandSection.count("hide_clock") == 0)
-                    setIniFileValue(settingsConfigIniPath, "ultrahand", "hide_clock", "false");
-                if (ultrahandSection.count("hide_battery") == 0)
-                    setIniFileValue(settingsConfigIniPath, "ultrahand", "hide_battery", "true");
-                if (ultrahandSection.count("hide_pcb_temp") == 0)
-                    setIniFileValue(settingsConfigIniPath, "ultrahand", "hide_pcb_temp", "true");
-                if (ultrahandSection.count("hide_soc_temp") == 0)
-                    setIniFileValue(settingsConfigIniPath, "ultrahand", "hide_soc_temp", "true");
+                if (!settingsTransaction.hasKey("ultrahand", "hide_clock"))
+                    settingsTransaction.setValue("ultrahand", "hide_clock", "false");
+                if (!settingsTransaction.hasKey("ultrahand", "hide_battery"))
+                    settingsTransaction.setValue("ultrahand", "hide_battery", "true");
+                if (!settingsTransaction.hasKey("ultrahand", "hide_pcb_temp"))
+                    settingsTransaction.setValue("ultrahand", "hide_pcb_temp", "true");
+                if (!settingsTransaction.hasKey("ultrahand", "hide_soc_temp"))
+                    settingsTransaction.setValue("ultrahand", "hide_soc_temp", "true");
                 
             }
-            settingsData.clear();
         }
         if (!settingsLoaded) { // write data if settings are not loaded
-            setIniFileValue(settingsConfigIniPath, "ultrahand", "default_lang", defaultLang);
-            setIniFileValue(settingsConfigIniPath, "ultrahand", "default_menu", defaultMenuMode);
-            setIniFileValue(settingsConfigIniPath, "ultrahand", "last_menu", menuMode);
-            setIniFileValue(settingsConfigIniPath, "ultrahand", "in_overlay", "false");
+            settingsTransaction.setValue("ultrahand", "default_lang", defaultLang);
+            settingsTransaction.setValue("ultrahand", "default_menu", defaultMenuMode);
+            settingsTransaction.setValue("ultrahand", "last_menu", menuMode);
+            settingsTransaction.setValue("ultrahand", "in_overlay", "false");
         }
+        settingsTransaction.commit();
         
         
         std::string langFile = "/config/ultrahand/lang/"+defaultLang+".json";
@@ -2686,7 +2693,8 @@ public:
             // Load subdirectories
             if (!overlayFiles.empty()) {
                 // Load the INI file and parse its content.
-                std::map<std::string, std::map<std::string, std::string>> overlaysIniData = getParsedDataFromIniFile(overlaysIniFilePath);
+                IniTransaction overlaysTransaction(overlaysIniFilePath);
+                std::string overlaysValue;
                 Result result;
                 std::string overlayName, overlayVersion;
                 
@@ -2699,14 +2707,14 @@ public:
                     
                     
                     // Check if the overlay name exists in the INI data.
-                    if (overlaysIniData.find(overlayFileName) == overlaysIniData.end()) {
+                    if (!overlaysTransaction.hasSection(overlayFileName)) {
                         // The entry doesn't exist; initialize it.
                         overlayList.push_back("0020:"+overlayFileName);
-                        setIniFileValue(overlaysIniFilePath, overlayFileName, "priority", "20");
-                        setIniFileValue(overlaysIniFilePath, overlayFileName, "star", "false");
-                        setIniFileValue(overlaysIniFilePath, overlayFileName, "hide", "false");
-                        setIniFileValue(overlaysIniFilePath, overlayFileName, "use_launch_args", "false");
-                        setIniFileValue(overlaysIniFilePath, overlayFileName, "launch_args", "");
+                        overlaysTransaction.setValue(overlayFileName, "priority", "20");
+                        overlaysTransaction.setValue(overlayFileName, "star", "false");
+                        overlaysTransaction.setValue(overlayFileName, "hide", "false");
+                        overlaysTransaction.setValue(overlayFileName, "use_launch_args", "false");
+                        overlaysTransaction.setValue(overlayFileName, "launch_args", "");
                         
                     } else {
                         // Read priority and starred status from ini
@@ -2714,40 +2722,35 @@ public:
                         starred = "false";
                         hide = "false";
                         
-                        // Check if the "priority" key exists in overlaysIniData for overlayFileName
-                        if (overlaysIniData.find(overlayFileName) != overlaysIniData.end() &&
-                            overlaysIniData[overlayFileName].find("priority") != overlaysIniData[overlayFileName].end()) {
-                            priority = formatPriorityString(overlaysIniData[overlayFileName]["priority"]);
+                        // Check if the "priority" key exists in overlaysTransaction for overlayFileName
+                        if (overlaysTransaction.getValue(overlayFileName, "priority", overlaysValue)) {
+                            priority = formatPriorityString(overlaysValue);
                         } else
-                            setIniFileValue(overlaysIniFilePath, overlayFileName, "priority", "20");
+                            overlaysTransaction.setValue(overlayFileName, "priority", "20");
                         
-                        // Check if the "star" key exists in overlaysIniData for overlayFileName
-                        if (overlaysIniData.find(overlayFileName) != overlaysIniData.end() &&
-                            overlaysIniData[overlayFileName].find("star") != overlaysIniData[overlayFileName].end()) {
-                            starred = overlaysIniData[overlayFileName]["star"];
+                        // Check if the "star" key exists in overlaysTransaction for overlayFileName
+                        if (overlaysTransaction.getValue(overlayFileName, "star", overlaysValue)) {
+                            starred = overlaysValue;
                         } else
-                            setIniFileValue(overlaysIniFilePath, overlayFileName, "star", "false");
+                            overlaysTransaction.setValue(overlayFileName, "star", "false");
                         
-                        // Check if the "hide" key exists in overlaysIniData for overlayFileName
-                        if (overlaysIniData.find(overlayFileName) != overlaysIniData.end() &&
-                            overlaysIniData[overlayFileName].find("hide") != overlaysIniData[overlayFileName].end()) {
-                            hide = overlaysIniData[overlayFileName]["hide"];
+                        // Check if the "hide" key exists in overlaysTransaction for overlayFileName
+                        if (overlaysTransaction.getValue(overlayFileName, "hide", overlaysValue)) {
+                            hide = overlaysValue;
                         } else
-                            setIniFileValue(overlaysIniFilePath, overlayFileName, "hide", "false");
+                            overlaysTransaction.setValue(overlayFileName, "hide", "false");
                         
-                        // Check if the "hide" key exists in overlaysIniData for overlayFileName
-                        if (overlaysIniData.find(overlayFileName) != overlaysIniData.end() &&
-                            overlaysIniData[overlayFileName].find("use_launch_args") != overlaysIniData[overlayFileName].end()) {
-                            //useOverlayLaunchArgs = (overlaysIniData[overlayFileName]["use_launch_args"] == "true");
+                        // Check if the "hide" key exists in overlaysTransaction for overlayFileName
+                        if (overlaysTransaction.getValue(overlayFileName, "use_launch_args", overlaysValue)) {
+                            //useOverlayLaunchArgs = (overlaysValue == "true");
                         } else
-                            setIniFileValue(overlaysIniFilePath, overlayFileName, "use_launch_args", "false");
+                            overlaysTransaction.setValue(overlayFileName, "use_launch_args", "false");
                         
-                        // Check if the "hide" key exists in overlaysIniData for overlayFileName
-                        if (overlaysIniData.find(overlayFileName) != overlaysIniData.end() &&
-                            overlaysIniData[overlayFileName].find("launch_args") != overlaysIniData[overlayFileName].end()) {
-                            //overlayLaunchArgs = overlaysIniData[overlayFileName]["launch_args"];
+                        // Check if the "hide" key exists in overlaysTransaction for overlayFileName
+                        if (overlaysTransaction.getValue(overlayFileName, "launch_args", overlaysValue)) {
+                            //overlayLaunchArgs = overlaysValue;
                         } else
-                            setIniFileValue(overlaysIniFilePath, overlayFileName, "launch_args", "");
+                            overlaysTransaction.setValue(overlayFileName, "launch_args", "");
                         
                         
                         // Get the name and version of the overlay file
@@ -2771,7 +2774,7 @@ public:
                     }
                 }
                 
-                overlaysIniData.clear();
+                overlaysTransaction.commit();
                 
                 std::sort(overlayList.begin(), overlayList.end());
                 std::sort(hiddenOverlayList.begin(), hiddenOverlayList.end());
@@ -2849,7 +2852,8 @@ public:
 
                             if (keys & KEY_A) {
                                 
-                                setIniFileValue(settingsConfigIniPath, "ultrahand", "in_overlay", "true"); // this is handled within tesla.hpp
+                                queueIniFileValue(settingsConfigIniPath, "ultrahand", "in_overlay", "true"); // this is handled within tesla.hpp
+                                flushPendingIniWrites(); // write everything before handing over to the next overlay
                                 std::string useOverlayLaunchArgs = parseValueFromIniSection(overlaysIniFilePath, overlayFileName, "use_launch_args");
                                 std::string overlayLaunchArgs = parseValueFromIniSection(overlaysIniFilePath, overlayFileName, "launch_args");
                                 
@@ -2867,7 +2871,7 @@ public:
                                 //std::string tmpMode(hiddenMenuMode);
                                 if (!overlayFile.empty()) {
                                     // Update the INI file with the new value
-                                    setIniFileValue(overlaysIniFilePath, overlayFileName, "star", newStarred);
+                                    queueIniFileValue(overlaysIniFilePath, overlayFileName, "star", newStarred);
                                     // Now, you can use the newStarred value for further processing if needed
                                 }
                                 if (inHiddenMode) {
@@ -2943,7 +2947,8 @@ public:
             std::vector<std::string> hiddenPackageList;
             
             // Load the INI file and parse its content.
-            std::map<std::string, std::map<std::string, std::string>> packagesIniData = getParsedDataFromIniFile(packagesIniFilePath);
+            IniTransaction packagesTransaction(packagesIniFilePath);
+            std::string packagesValue;
             // Load subdirectories
             std::vector<std::string> subdirectories = getSubdirectories(packageDirectory);
             //for (size_t i = 0; i < subdirectories.size(); ++i) {
@@ -2951,38 +2956,35 @@ public:
                 if (packageName.substr(0, 1) == ".")
                     continue;
                 // Check if the overlay name exists in the INI data.
-                if (packagesIniData.find(packageName) == packagesIniData.end()) {
+                if (!packagesTransaction.hasSection(packageName)) {
                     // The entry doesn't exist; initialize it.
                     packageList.push_back("0020:"+packageName);
-                    setIniFileValue(packagesIniFilePath, packageName, "priority", "20");
-                    setIniFileValue(packagesIniFilePath, packageName, "star", "false");
-                    setIniFileValue(packagesIniFilePath, packageName, "hide", "false");
+                    packagesTransaction.setValue(packageName, "priority", "20");
+                    packagesTransaction.setValue(packageName, "star", "false");
+                    packagesTransaction.setValue(packageName, "hide", "false");
                 } else {
                     // Read priority and starred status from ini
                     priority = "0020";
                     starred = "false";
                     hide = "false";
                     
-                    // Check if the "priority" key exists in overlaysIniData for overlayFileName
-                    if (packagesIniData.find(packageName) != packagesIniData.end() &&
-                        packagesIniData[packageName].find("priority") != packagesIniData[packageName].end()) {
-                        priority = formatPriorityString(packagesIniData[packageName]["priority"]);
+                    // Check if the "priority" key exists in packagesTransaction for packageName
+                    if (packagesTransaction.getValue(packageName, "priority", packagesValue)) {
+                        priority = formatPriorityString(packagesValue);
                     } else
-                        setIniFileValue(packagesIniFilePath, packageName, "priority", "20");
+                        packagesTransaction.setValue(packageName, "priority", "20");
                     
-                    // Check if the "star" key exists in overlaysIniData for overlayFileName
-                    if (packagesIniData.find(packageName) != packagesIniData.end() &&
-                        packagesIniData[packageName].find("star") != packagesIniData[packageName].end()) {
-                        starred = packagesIniData[packageName]["star"];
+                    // Check if the "star" key exists in packagesTransaction for packageName
+                    if (packagesTransaction.getValue(packageName, "star", packagesValue)) {
+                        starred = packagesValue;
                     } else
-                        setIniFileValue(packagesIniFilePath, packageName, "star", "false");
+                        packagesTransaction.setValue(packageName, "star", "false");
                     
-                    // Check if the "star" key exists in overlaysIniData for overlayFileName
-                    if (packagesIniData.find(packageName) != packagesIniData.end() &&
-                        packagesIniData[packageName].find("hide") != packagesIniData[packageName].end()) {
-                        hide = packagesIniData[packageName]["hide"];
+                    // Check if the "star" key exists in packagesTransaction for packageName
+                    if (packagesTransaction.getValue(packageName, "hide", packagesValue)) {
+                        hide = packagesValue;
                     } else
-                        setIniFileValue(packagesIniFilePath, packageName, "hide", "false");
+                        packagesTransaction.setValue(packageName, "hide", "false");
                     
                     if (hide == "false") {
                         if (starred == "true")
@@ -2997,7 +2999,7 @@ public:
                     }
                 }
             }
-            packagesIniData.clear();
+            packagesTransaction.commit();
             subdirectories.clear();
             
             std::sort(packageList.begin(), packageList.end());
@@ -3047,7 +3049,7 @@ public:
                 
                 //tsl::elm::ListItem* listItem = nullptr;
                 if (isFileOrDirectory(packageFilePath)) {
-                    packageHeader = getPackageHeaderFromIni(packageFilePath+packageFileName);
+                    packageHeader = getCachedPackageHeader(packageFilePath+packageFileName);
                     
                     listItem = new tsl::elm::ListItem(newPackageName);
                     if (cleanVersionLabels == "true")
@@ -3090,7 +3092,7 @@ public:
                             return true;
                         } else if (keys & STAR_KEY) {
                             if (!packageName.empty())
-                                setIniFileValue(packagesIniFilePath, packageName, "star", newStarred); // Update the INI file with the new value
+                                queueIniFileValue(packagesIniFilePath, packageName, "star", newStarred); // Update the INI file with the new value
                             
                             if (inHiddenMode) {
                                 //tsl::goBack();
@@ -3119,6 +3121,7 @@ public:
                 }
             }
             packageList.clear();
+            savePackageCatalog(); // persist headers parsed for new or changed packages
             
             if (!hiddenPackageList.empty() && !inHiddenMode) {
                 listItem = new tsl::elm::ListItem(HIDDEN, DROPDOWN_SYMBOL);
@@ -3502,10 +3505,10 @@ public:
                                 toggleListItem->setStateChangedListener([this, i, pathPatternOn, pathPatternOff, commandsOn, commandsOff, toggleStateOn, packagePath = packageDirectory, keyName = option.first](bool state) {
                                     if (state) {
                                         interpretAndExecuteCommand(getSourceReplacement(commandsOn, preprocessPath(pathPatternOn), i), packagePath, keyName); // Execute modified
-                                        setIniFileValue((packagePath+configFileName).c_str(), keyName.c_str(), "footer", "On");
+                                        queueIniFileValue(packagePath+configFileName, keyName, "footer", "On");
                                     } else {
                                         interpretAndExecuteCommand(getSourceReplacement(commandsOff, preprocessPath(pathPatternOff), i), packagePath, keyName); // Execute modified
-                                        setIniFileValue((packagePath+configFileName).c_str(), keyName.c_str(), "footer", "Off");
+                                        queueIniFileValue(packagePath+configFileName, keyName, "footer", "Off");
                                     }
                                 });
                                 list->addItem(toggleListItem);
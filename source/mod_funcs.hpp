@@ -18,15 +18,142 @@
 
 #pragma once
 #include <vector>
+#include <algorithm>
 #include <cstring>
 #include <cstdlib>
 #include <cstdio>
 #include <sys/stat.h>
 #include <debug_funcs.hpp>
+#include <get_funcs.hpp>
+#include <hex_funcs.hpp>
 
 const std::string IPS32_HEAD_MAGIC = "IPS32";
 const std::string IPS32_FOOT_MAGIC = "EEOF";
 
+const std::string IPS_HEAD_MAGIC = "PATCH";
+const std::string IPS_FOOT_MAGIC = "EOF";
+
+/**
+ * @brief Reads a big-endian number of the given byte count from a patch file.
+ */
+static bool readIpsNumber(FILE* ipsFile, size_t byteCount, uint32_t& value) {
+    uint8_t bytes[4];
+    if (fread(bytes, 1, byteCount, ipsFile) != byteCount)
+        return false;
+    
+    value = 0;
+    for (size_t i = 0; i < byteCount; ++i)
+        value = (value << 8) | bytes[i];
+    return true;
+}
+
+/**
+ * @brief Writes a big-endian number of the given byte count to a patch file.
+ */
+static bool writeIpsNumber(FILE* ipsFile, size_t byteCount, uint32_t value) {
+    uint8_t bytes[4];
+    for (size_t i = 0; i < byteCount; ++i)
+        bytes[i] = static_cast<uint8_t>(value >> (8 * (byteCount - 1 - i)));
+    return fwrite(bytes, 1, byteCount, ipsFile) == byteCount;
+}
+
+/**
+ * @brief Streams the records of an IPS or IPS32 patch into a hex patch session.
+ *
+ * IPS uses 3-byte offsets and ends with "EOF", IPS32 uses 4-byte offsets and ends with "EEOF".
+ * RLE records (size 0) are expanded. The session sorts and merges the records, so nothing is
+ * written until it is flushed.
+ *
+ * @param ipsPath The path to the patch file.
+ * @param session The session that receives one edit per record.
+ * @return True if the patch was read up to its footer, false otherwise.
+ */
+bool readIpsPatch(const std::string& ipsPath, HexPatchSession& session) {
+    FILE* ipsFile = fopen(ipsPath.c_str(), "rb");
+    if (!ipsFile) {
+        logMessage("Error: Unable to open file " + ipsPath);
+        return false;
+    }
+    setvbuf(ipsFile, nullptr, _IOFBF, 65536);
+    
+    char magic[5];
+    if (fread(magic, 1, sizeof(magic), ipsFile) != sizeof(magic) ||
+        (std::memcmp(magic, IPS_HEAD_MAGIC.c_str(), 5) != 0 && std::memcmp(magic, IPS32_HEAD_MAGIC.c_str(), 5) != 0)) {
+        logMessage("Error: " + ipsPath + " is not an IPS patch");
+        fclose(ipsFile);
+        return false;
+    }
+    
+    const bool isIps32 = (std::memcmp(magic, IPS32_HEAD_MAGIC.c_str(), 5) == 0);
+    const size_t offsetSize = isIps32 ? 4 : 3;
+    const uint32_t footer = isIps32 ? 0x45454F46 : 0x454F46; // "EEOF" or "EOF"
+    
+    bool success = false;
+    uint32_t offset, size, runLength, value;
+    std::vector<uint8_t> data;
+    
+    while (readIpsNumber(ipsFile, offsetSize, offset)) {
+        if (offset == footer) {
+            success = true;
+            break;
+        }
+        
+        if (!readIpsNumber(ipsFile, 2, size))
+            break;
+        
+        if (size == 0) {
+            // RLE record: a 2-byte run length and the byte to repeat
+            if (!readIpsNumber(ipsFile, 2, runLength) || !readIpsNumber(ipsFile, 1, value))
+                break;
+            data.assign(runLength, static_cast<uint8_t>(value));
+        } else {
+            data.resize(size);
+            if (fread(data.data(), 1, size, ipsFile) != size)
+                break;
+        }
+        session.addEdit(offset, HexPattern::fromBytes(data.data(), data.size()));
+    }
+    fclose(ipsFile);
+    
+    if (!success)
+        logMessage("Error: " + ipsPath + " is truncated");
+    return success;
+}
+
+/**
+ * @brief Applies an IPS or IPS32 patch to a file, or checks whether it is already applied.
+ *
+ * All records are collected and checked against the file size first, then written through one
+ * handle in sorted, merged runs. A patch that does not fit the file is not applied at all.
+ *
+ * @param filePath The path to the file to patch.
+ * @param ipsPath The path to the patch file.
+ * @param verifyOnly Only checks whether every record already matches the file.
+ * @param journaling Records the original bytes in the file's hex undo journal.
+ * @return True if the patch was applied (or, with verifyOnly, is already applied), false otherwise.
+ */
+bool applyIpsPatch(const std::string& filePath, const std::string& ipsPath, bool verifyOnly = false, bool journaling = false) {
+    HexPatchSession session(filePath, journaling && !verifyOnly, verifyOnly);
+    if (!session.isOpen())
+        return false;
+    
+    if (!readIpsPatch(ipsPath, session)) {
+        session.discard(); // Never apply a partial patch
+        return false;
+    }
+    
+    // A record past the end would be refused alone while the others are written
+    if (!session.pendingEditsFit()) {
+        logMessage("Error: " + ipsPath + " patches past the end of " + filePath);
+        session.discard();
+        return false;
+    }
+    
+    if (verifyOnly)
+        return session.verify();
+    return session.commit();
+}
+
 /**
  * @brief Converts a .pchtxt file to an IPS file.
  *
@@ -144,18 +271,22 @@ bool pchtxt2ips(const std::string& pchtxtPath, const std::string& outputFolder)
 
     fwrite(IPS32_HEAD_MAGIC.c_str(), 1, IPS32_HEAD_MAGIC.size(), ipsFile);
 
+    // IPS32 numbers are big-endian, values longer than a record can hold are split
     for (const auto& patch : patches) {
         uint32_t address = patch.first;
         const std::vector<uint8_t>& value = patch.second;
-        fwrite(&address, sizeof(address), 1, ipsFile);  // Write address
-        uint16_t valueLength = value.size();
-        fwrite(&valueLength, sizeof(valueLength), 1, ipsFile);  // Write length of value
-        fwrite(value.data(), 1, value.size(), ipsFile);  // Write value
+        for (size_t pos = 0; pos < value.size(); pos += 0xFFFF) {
+            uint16_t valueLength = std::min<size_t>(value.size() - pos, 0xFFFF);
+            writeIpsNumber(ipsFile, 4, address + pos);  // Write address
+            writeIpsNumber(ipsFile, 2, valueLength);  // Write length of value
+            fwrite(value.data() + pos, 1, valueLength, ipsFile);  // Write value
+        }
     }
 
     fwrite(IPS32_FOOT_MAGIC.c_str(), 1, IPS32_FOOT_MAGIC.size(), ipsFile);
 
     fclose(ipsFile);
+    invalidateDirectoryListing(ipsFilePath);
 
     return success;
 }
@@ -20,6 +20,8 @@
 #pragma once
 #include <sys/stat.h>
 #include <dirent.h>
+#include <dir_walker.hpp>
+#include <copy_engine.hpp>
 
 /**
  * @brief Creates a single directory if it doesn't exist.
@@ -30,8 +32,8 @@
  */
 void createSingleDirectory(const std::string& directoryPath) {
     struct stat st;
-    if (stat(directoryPath.c_str(), &st) != 0)
-        mkdir(directoryPath.c_str(), 0777);
+    if (stat(directoryPath.c_str(), &st) != 0 && mkdir(directoryPath.c_str(), 0777) == 0)
+        invalidateDirectoryListing(directoryPath);
 }
 
 /**
@@ -89,6 +91,7 @@ void createTextFile(const std::string& filePath, const std::string& content) {
     if (file != nullptr) {
         std::fwrite(content.c_str(), 1, content.length(), file);
         std::fclose(file);
+        invalidateDirectoryListing(filePath);
     }
 }
 
@@ -110,18 +113,15 @@ void deleteFileOrDirectory(const std::string& pathToDelete) {
                 // Deletion successful
             }
         } else if (S_ISDIR(pathStat.st_mode)) {
-            // Delete all files in the directory
-            DIR* directory = opendir(pathToDelete.c_str());
-            if (directory != nullptr) {
-                dirent* entry;
-                while ((entry = readdir(directory)) != nullptr) {
-                    const std::string& fileName = entry->d_name;
-                    if (fileName != "." && fileName != "..") {
-                        std::string filePath = pathToDelete + "/" + fileName;
-                        deleteFileOrDirectory(filePath);
-                    }
-                }
-                closedir(directory);
+            // Delete all files in the directory, and each subdirectory once it is empty. The walk is
+            // iterative, so a deep tree does not grow the stack of the thread running the command,
+            // and entry types come from readdir instead of a stat per entry.
+            DirWalker walker(pathToDelete, true, true);
+            while (walker.next()) {
+                if (walker.isFile())
+                    std::remove(walker.getPath().c_str());
+                else if (walker.isLeaving())
+                    rmdir(walker.getPath().c_str());
             }
             
             // Remove the directory itself
@@ -129,6 +129,7 @@ void deleteFileOrDirectory(const std::string& pathToDelete) {
                 // Deletion successful
             }
         }
+        invalidateDirectoryListing(pathToDelete);
     }
 }
 
@@ -153,12 +154,86 @@ void deleteFileOrDirectoryByPattern(const std::string& pathPattern) {
 
 
 
+/**
+ * @brief Checks whether two paths are on the same mount, such as "sdmc:".
+ */
+static bool isSameMount(const std::string& firstPath, const std::string& secondPath) {
+    const size_t mountLength = firstPath.find(":/");
+    if (mountLength == std::string::npos)
+        return secondPath.find(":/") == std::string::npos;
+    return secondPath.find(":/") == mountLength && firstPath.compare(0, mountLength, secondPath, 0, mountLength) == 0;
+}
+
+/**
+ * @brief A file or directory that a merge move renames into place.
+ */
+struct MoveOperation {
+    std::string sourcePath;
+    std::string destinationPath;
+    bool isDirectory;
+};
+
+/**
+ * @brief Moves the contents of a directory into an existing directory.
+ *
+ * Subdirectories that are missing at the destination are renamed as a whole, existing ones
+ * are merged. The walk only plans the renames, which run once it is done. Entries that
+ * cannot be renamed because their destination exists go into a list of conflicts, and only
+ * those destinations are deleted before renaming again.
+ *
+ * @param sourcePath The source directory, without a trailing slash.
+ * @param destinationPath The existing destination directory, without a trailing slash.
+ */
+static void mergeMoveDirectory(const std::string& sourcePath, const std::string& destinationPath) {
+    std::vector<MoveOperation> operations;
+    std::string destinationEntryPath;
+    struct stat destinationInfo;
+    
+    DirWalker walker(sourcePath, true);
+    while (walker.next()) {
+        destinationEntryPath.assign(destinationPath).append("/").append(walker.getRelativePath());
+        
+        if (walker.isDirectory()) {
+            if (stat(destinationEntryPath.c_str(), &destinationInfo) == 0 && S_ISDIR(destinationInfo.st_mode))
+                continue; // Merge into the existing directory
+            walker.skipDirectory();
+        }
+        operations.push_back({walker.getPath(), destinationEntryPath, walker.isDirectory()});
+    }
+    
+    std::vector<MoveOperation> conflicts;
+    for (auto& operation : operations) {
+        if (rename(operation.sourcePath.c_str(), operation.destinationPath.c_str()) == 0)
+            continue;
+        
+        if (stat(operation.destinationPath.c_str(), &destinationInfo) == 0) {
+            conflicts.push_back(std::move(operation));
+        } else if (operation.isDirectory) {
+            // The directory cannot be renamed, so move its contents one by one
+            createSingleDirectory(operation.destinationPath);
+            mergeMoveDirectory(operation.sourcePath, operation.destinationPath);
+        } else {
+            logMessage("Failed to move " + operation.sourcePath + " to " + operation.destinationPath + ".");
+        }
+    }
+    
+    // Replace the destinations that were in the way
+    for (const auto& conflict : conflicts) {
+        deleteFileOrDirectory(conflict.destinationPath);
+        if (rename(conflict.sourcePath.c_str(), conflict.destinationPath.c_str()) != 0)
+            logMessage("Failed to move " + conflict.sourcePath + " to " + conflict.destinationPath + ".");
+    }
+}
+
 /**
  * @brief Moves a file or directory to a new destination.
  *
  * This function moves a file or directory from the `sourcePath` to the `destinationPath`. It can handle both
  * files and directories and ensures that the destination directory exists before moving.
  *
+ * A directory whose destination does not exist yet is moved with a single rename when both paths are on the
+ * same mount. Otherwise its contents are merged into the destination, see mergeMoveDirectory().
+ *
  * @param sourcePath The path of the source file or directory.
  * @param destinationPath The path of the destination where the file or directory will be moved.
  */
@@ -171,49 +246,52 @@ void moveFileOrDirectory(const std::string& sourcePath, const std::string& desti
     if (stat(sourcePath.c_str(), &sourceInfo) == 0) {
         // Source file or directory exists
         
-        // Check if the destination path exists
-        bool destinationExists = (stat(getParentDirFromPath(destinationPath).c_str(), &destinationInfo) == 0);
-        if (!destinationExists)
-            createDirectory(getParentDirFromPath(destinationPath).c_str()); // Create the destination directory
-        
         if (S_ISDIR(sourceInfo.st_mode)) {
-            // Source path is a directory
-            DIR* dir = opendir(sourcePath.c_str());
-            if (!dir) {
-                //logMessage("Failed to open source directory: "+sourcePath);
-                //printf("Failed to open source directory: %s\n", sourcePath.c_str());
+            // Source path is a directory, work on both paths without their trailing slashes
+            std::string fromDirectory = sourcePath;
+            std::string toDirectory = destinationPath;
+            if (fromDirectory.back() == '/')
+                fromDirectory.pop_back();
+            if (!toDirectory.empty() && toDirectory.back() == '/')
+                toDirectory.pop_back();
+            
+            if (toDirectory.compare(0, fromDirectory.size() + 1, fromDirectory + "/") == 0) {
+                logMessage("Cannot move " + sourcePath + " into itself.");
                 return;
             }
             
-            struct dirent* entry;
-            
-            std::string sourceFilePath, destinationFilePath;
-            
-            while ((entry = readdir(dir)) != NULL) {
-                const std::string& fileOrFolderName = entry->d_name;
+            if (stat(toDirectory.c_str(), &destinationInfo) != 0) {
+                createDirectory(getParentDirFromPath(toDirectory));
                 
-                if (fileOrFolderName != "." && fileOrFolderName != "..") {
-                    sourceFilePath = sourcePath + fileOrFolderName;
-                    destinationFilePath = destinationPath + fileOrFolderName;
-                    
-                    if (entry->d_type == DT_DIR) {
-                        // Append trailing slash to destination path for folders
-                        destinationFilePath += "/";
-                        sourceFilePath += "/";
-                    }
-                    
-                    moveFileOrDirectory(sourceFilePath, destinationFilePath);
+                // Nothing to merge with, so the whole directory can be renamed
+                if (isSameMount(fromDirectory, toDirectory) && rename(fromDirectory.c_str(), toDirectory.c_str()) == 0) {
+                    invalidateDirectoryListing(fromDirectory);
+                    invalidateDirectoryListing(toDirectory);
+                    return;
                 }
+                createSingleDirectory(toDirectory);
             }
             
-            closedir(dir);
+            mergeMoveDirectory(fromDirectory, toDirectory);
             
-            // Delete the source directory
-            deleteFileOrDirectory(sourcePath);
+            // Remove the emptied source folders, keeping anything that failed to move
+            DirWalker walker(fromDirectory, true, true);
+            while (walker.next())
+                if (walker.isLeaving())
+                    rmdir(walker.getPath().c_str());
+            rmdir(fromDirectory.c_str());
+            invalidateDirectoryListing(fromDirectory);
+            invalidateDirectoryListing(toDirectory);
             
             return;
         } else {
             // Source path is a regular file
+            
+            // Check if the destination path exists
+            bool destinationExists = (stat(getParentDirFromPath(destinationPath).c_str(), &destinationInfo) == 0);
+            if (!destinationExists)
+                createDirectory(getParentDirFromPath(destinationPath).c_str()); // Create the destination directory
+            
             std::string filename = getNameFromPath(sourcePath.c_str());
             
             std::string destinationFilePath = destinationPath;
@@ -226,12 +304,17 @@ void moveFileOrDirectory(const std::string& sourcePath, const std::string& desti
             //logMessage("sourcePath: "+sourcePath);
             //logMessage("destinationFilePath: "+destinationFilePath);
             
-            deleteFileOrDirectory(destinationFilePath); // delete destiantion file for overwriting
             if (rename(sourcePath.c_str(), destinationFilePath.c_str()) == -1) {
-                //printf("Failed to move file: %s\n", sourcePath.c_str());
-                //logMessage("Failed to move file: "+sourcePath);
-                return;
+                // The destination is in the way, replace it
+                deleteFileOrDirectory(destinationFilePath);
+                if (rename(sourcePath.c_str(), destinationFilePath.c_str()) == -1) {
+                    //printf("Failed to move file: %s\n", sourcePath.c_str());
+                    //logMessage("Failed to move file: "+sourcePath);
+                    return;
+                }
             }
+            invalidateDirectoryListing(sourcePath);
+            invalidateDirectoryListing(destinationFilePath);
             
             return;
         }
@@ -264,11 +347,11 @@ void moveFilesOrDirectoriesByPattern(const std::string& sourcePathPattern, const
     // Iterate through the file list
     for (const std::string& sourceFileOrDirectory : fileList) {
         //logMessage("sourceFileOrDirectory: "+sourceFileOrDirectory);
-        // if sourceFile is a file (Needs condition handling)
-        if (!isDirectory(sourceFileOrDirectory)) {
+        // Wildcard matches mark directories with a trailing slash
+        if (sourceFileOrDirectory.back() != '/' && !isDirectory(sourceFileOrDirectory)) {
             //logMessage("destinationPath: "+destinationPath);
             moveFileOrDirectory(sourceFileOrDirectory.c_str(), destinationPath.c_str());
-        } else if (isDirectory(sourceFileOrDirectory)) {
+        } else {
             // if sourceFile is a directory (needs conditoin handling)
             folderName = getNameFromPath(sourceFileOrDirectory);
             fixedDestinationPath = destinationPath + folderName + "/";
@@ -287,27 +370,15 @@ void moveFilesOrDirectoriesByPattern(const std::string& sourcePathPattern, const
  * @brief Copies a single file from the source path to the destination path.
  *
  * This function copies a single file specified by `fromFile` to the location specified by `toFile`.
+ * Reads and writes overlap for files larger than one copy buffer, see CopyPipeline.
  *
  * @param fromFile The path of the source file to be copied.
  * @param toFile The path of the destination where the file will be copied.
  */
 void copySingleFile(const std::string& fromFile, const std::string& toFile) {
-    FILE* srcFile = fopen(fromFile.c_str(), "rb");
-    FILE* destFile = fopen(toFile.c_str(), "wb");
-    if (srcFile && destFile) {
-        const size_t bufferSize = 131072; // Increase buffer size to 128 KB
-        char buffer[bufferSize];
-        size_t bytesRead;
-        
-        while ((bytesRead = fread(buffer, 1, bufferSize, srcFile)) > 0)
-            fwrite(buffer, 1, bytesRead, destFile);
-        
-        fclose(srcFile);
-        fclose(destFile);
-    } else {
-        // Error opening files or performing copy action.
-        // Handle the error accordingly.
-    }
+    CopyPipeline pipeline;
+    pipeline.copyFile(fromFile, toFile);
+    pipeline.finish();
 }
 
 /**
@@ -319,8 +390,9 @@ void copySingleFile(const std::string& fromFile, const std::string& toFile) {
  *
  * @param fromFileOrDirectory The path of the source file or directory to be copied.
  * @param toFileOrDirectory The path of the destination where the file or directory will be copied.
+ * @param pipeline The pipeline the files are copied through, finished by the caller.
  */
-void copyFileOrDirectory(const std::string& fromFileOrDirectory, const std::string& toFileOrDirectory) {
+void copyFileOrDirectory(const std::string& fromFileOrDirectory, const std::string& toFileOrDirectory, CopyPipeline& pipeline) {
     struct stat fromFileOrDirectoryInfo;
     if (stat(fromFileOrDirectory.c_str(), &fromFileOrDirectoryInfo) == 0) {
         if (S_ISREG(fromFileOrDirectoryInfo.st_mode)) {
@@ -330,19 +402,13 @@ void copyFileOrDirectory(const std::string& fromFileOrDirectory, const std::stri
             struct stat toFileOrDirectoryInfo;
             
             if (stat(toFileOrDirectory.c_str(), &toFileOrDirectoryInfo) == 0 && S_ISDIR(toFileOrDirectoryInfo.st_mode)) {
-                // Destination is a directory
+                // Destination is an existing directory
                 std::string toDirectory = toFileOrDirectory;
                 std::string fileName = fromFile.substr(fromFile.find_last_of('/') + 1);
                 std::string toFilePath = toDirectory + fileName;
                 
-                // Create the destination directory if it doesn't exist
-                createDirectory(toDirectory);
-                
-                // Check if the destination file exists and remove it
-                if (stat(toFilePath.c_str(), &toFileOrDirectoryInfo) == 0 && S_ISREG(toFileOrDirectoryInfo.st_mode))
-                    std::remove(toFilePath.c_str());
-                
-                copySingleFile(fromFile, toFilePath);
+                // An existing destination file is replaced by the copy
+                pipeline.copyFile(fromFile, toFilePath);
             } else {
                 std::string toFile = toFileOrDirectory;
                 // Destination is a file or doesn't exist
@@ -351,12 +417,8 @@ void copyFileOrDirectory(const std::string& fromFileOrDirectory, const std::stri
                 // Create the destination directory if it doesn't exist
                 createDirectory(toDirectory);
                 
-                // Destination is a file or doesn't exist
-                // Check if the destination file exists and remove it
-                if (stat(toFile.c_str(), &toFileOrDirectoryInfo) == 0 && S_ISREG(toFileOrDirectoryInfo.st_mode))
-                    std::remove(toFile.c_str());
-                
-                copySingleFile(fromFile, toFile);
+                // An existing destination file is replaced by the copy
+                pipeline.copyFile(fromFile, toFile);
             }
         } else if (S_ISDIR(fromFileOrDirectoryInfo.st_mode)) {
             // Source is a directory
@@ -378,28 +440,17 @@ void copyFileOrDirectory(const std::string& fromFileOrDirectory, const std::stri
                     createDirectory(toDirPath);
                     //mkdir(toDirPath.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
                     
-                    // Open the source directory
-                    DIR* dir = opendir(fromDirectory.c_str());
-                    if (dir != nullptr) {
-                        dirent* entry;
-                        std::string fromFilePath, subFolderPath;
+                    // Walk the source tree once, recreating folders before their contents
+                    DirWalker walker(fromDirectory, true);
+                    std::string toPath;
+                    
+                    while (walker.next()) {
+                        toPath.assign(toDirPath).append(walker.getRelativePath());
                         
-                        while ((entry = readdir(dir)) != nullptr) {
-                            const std::string& fileOrFolderName = entry->d_name;
-                            
-                            // handle cade for files
-                            if (fileOrFolderName != "." && fileOrFolderName != "..") {
-                                fromFilePath = fromDirectory + fileOrFolderName;
-                                copyFileOrDirectory(fromFilePath, toDirPath);
-                            }
-                            // handle case for subfolders within the from file path
-                            if (entry->d_type == DT_DIR && fileOrFolderName != "." && fileOrFolderName != "..") {
-                                subFolderPath = fromDirectory + fileOrFolderName + "/";
-                                copyFileOrDirectory(subFolderPath, toDirPath);
-                            }
-                            
-                        }
-                        closedir(dir);
+                        if (walker.isDirectory())
+                            createSingleDirectory(toPath);
+                        else
+                            pipeline.copyFile(walker.getPath(), toPath); // Replaces an existing file
                     }
                 }
             }
@@ -407,6 +458,20 @@ void copyFileOrDirectory(const std::string& fromFileOrDirectory, const std::stri
     }
 }
 
+/**
+ * @brief Copies a file or directory from the source path to the destination path.
+ *
+ * See copyFileOrDirectory() above, with all files of the copy sharing one pipeline.
+ *
+ * @param fromFileOrDirectory The path of the source file or directory to be copied.
+ * @param toFileOrDirectory The path of the destination where the file or directory will be copied.
+ */
+void copyFileOrDirectory(const std::string& fromFileOrDirectory, const std::string& toFileOrDirectory) {
+    CopyPipeline pipeline;
+    copyFileOrDirectory(fromFileOrDirectory, toFileOrDirectory, pipeline);
+    pipeline.finish();
+}
+
 /**
  * @brief Copies files or directories matching a specified pattern to a destination directory.
  *
@@ -419,12 +484,14 @@ void copyFileOrDirectory(const std::string& fromFileOrDirectory, const std::stri
 void copyFileOrDirectoryByPattern(const std::string& sourcePathPattern, const std::string& toDirectory) {
     std::vector<std::string> fileList = getFilesListByWildcards(sourcePathPattern);
     
+    CopyPipeline pipeline;
     for (const std::string& sourcePath : fileList) {
         //logMessage("sourcePath: "+sourcePath);
         //logMessage("toDirectory: "+toDirectory);
         if (sourcePath != toDirectory)
-            copyFileOrDirectory(sourcePath, toDirectory);
+            copyFileOrDirectory(sourcePath, toDirectory, pipeline);
     }
+    pipeline.finish();
 }
 
 
@@ -441,6 +508,7 @@ void copyFileOrDirectoryByPattern(const std::string& sourcePathPattern, const st
 void mirrorFiles(const std::string& sourcePath, const std::string targetPath, const std::string mode) {
     std::vector<std::string> fileList = getFilesListFromDirectory(sourcePath);
     std::string updatedPath;
+    CopyPipeline pipeline;
     for (const auto& path : fileList) {
         // Generate the corresponding path in the target directory by replacing the source path
         updatedPath = targetPath + path.substr(sourcePath.size());
@@ -449,9 +517,10 @@ void mirrorFiles(const std::string& sourcePath, const std::string targetPath, co
             deleteFileOrDirectory(updatedPath);
         else if (mode == "copy") {
             if (path != updatedPath)
-                copyFileOrDirectory(path, updatedPath);
+                copyFileOrDirectory(path, updatedPath, pipeline);
         }
     }
+    pipeline.finish();
     //fileList.clear();
 }
 
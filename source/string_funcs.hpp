@@ -19,6 +19,7 @@
 
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 #include <jansson.h>
 #include <regex>
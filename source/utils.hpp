@@ -74,126 +74,15 @@ static bool usingMariko = util::IsMariko();
 
 
 void initializeTheme(std::string themeIniPath = themeConfigIniPath) {
-    tsl::hlp::ini::IniData themesData;
-    bool initialize = false;
-    
-    // write default theme
-    if (isFileOrDirectory(themeIniPath)) {
-        themesData = getParsedDataFromIniFile(themeIniPath);
-        if (themesData.count("theme") > 0) {
-            auto& themedSection = themesData["theme"];
-            
-            if (themedSection.count("clock_color") == 0)
-                setIniFileValue(themeIniPath, "theme", "clock_color", "#FFFFFF");
-            
-            if (themedSection.count("bg_alpha") == 0)
-                setIniFileValue(themeIniPath, "theme", "bg_alpha", "13");
-            
-            if (themedSection.count("bg_color") == 0)
-                setIniFileValue(themeIniPath, "theme", "bg_color", "#000000");
-            
-            if (themedSection.count("seperator_alpha") == 0)
-                setIniFileValue(themeIniPath, "theme", "seperator_alpha", "7");
-            
-            if (themedSection.count("seperator_color") == 0)
-                setIniFileValue(themeIniPath, "theme", "seperator_color", "#777777");
-            
-            if (themedSection.count("battery_color") == 0)
-                setIniFileValue(themeIniPath, "theme", "battery_color", "#FFFFFF");
-            
-            if (themedSection.count("text_color") == 0)
-                setIniFileValue(themeIniPath, "theme", "text_color", "#FFFFFF");
-            
-            if (themedSection.count("info_text_color") == 0)
-                setIniFileValue(themeIniPath, "theme", "info_text_color", "#FFFFFF");
-            
-            if (themedSection.count("version_text_color") == 0)
-                setIniFileValue(themeIniPath, "theme", "version_text_color", "#AAAAAA");
-            
-            if (themedSection.count("on_text_color") == 0)
-                setIniFileValue(themeIniPath, "theme", "on_text_color", "#00FFDD");
-            
-            if (themedSection.count("off_text_color") == 0)
-                setIniFileValue(themeIniPath, "theme", "off_text_color", "#AAAAAA");
-            
-            if (themedSection.count("invalid_text_color") == 0)
-                setIniFileValue(themeIniPath, "theme", "invalid_text_color", "#FF0000");
-            
-            if (themedSection.count("selection_text_color") == 0)
-                setIniFileValue(themeIniPath, "theme", "selection_text_color", "#FFFFFF");
-            
-            if (themedSection.count("selection_bg_color") == 0)
-                setIniFileValue(themeIniPath, "theme", "selection_bg_color", "#000000");
-            
-            if (themedSection.count("trackbar_color") == 0)
-                setIniFileValue(themeIniPath, "theme", "trackbar_color", "#555555");
-            
-            if (themedSection.count("highlight_color_1") == 0)
-                setIniFileValue(themeIniPath, "theme", "highlight_color_1", "#2288CC");
-            
-            if (themedSection.count("highlight_color_2") == 0)
-                setIniFileValue(themeIniPath, "theme", "highlight_color_2", "#88FFFF");
-            
-            if (themedSection.count("click_text_color") == 0)
-                setIniFileValue(themeIniPath, "theme", "click_text_color", "#000000");
-
-            if (themedSection.count("click_color") == 0)
-                setIniFileValue(themeIniPath, "theme", "click_color", "#F7253E");
-            
-            if (themedSection.count("invert_bg_click_color") == 0)
-                setIniFileValue(themeIniPath, "theme", "invert_bg_click_color", "false");
-            
-            if (themedSection.count("disable_selection_bg") == 0)
-                setIniFileValue(themeIniPath, "theme", "disable_selection_bg", "true");
-            
-            // For disabling colorful logo
-            if (themedSection.count("disable_colorful_logo") == 0)
-                setIniFileValue(themeIniPath, "theme", "disable_colorful_logo", "false");
-            
-            if (themedSection.count("logo_color_1") == 0)
-                setIniFileValue(themeIniPath, "theme", "logo_color_1", "#FFFFFF");
-            
-            if (themedSection.count("logo_color_2") == 0)
-                setIniFileValue(themeIniPath, "theme", "logo_color_2", "#FF0000");
-            
-            if (themedSection.count("dynamic_logo_color_1") == 0)
-                setIniFileValue(themeIniPath, "theme", "dynamic_logo_color_1", "#00E669");
-            
-            if (themedSection.count("dynamic_logo_color_2") == 0)
-                setIniFileValue(themeIniPath, "theme", "dynamic_logo_color_2", "#8080EA");
-            
-        } else
-            initialize = true;
-    } else
-        initialize = true;
-    
-    if (initialize) {
-        setIniFileValue(themeIniPath, "theme", "clock_color", "#FFFFFF");
-        setIniFileValue(themeIniPath, "theme", "battery_color", "#FFFFFF");
-        setIniFileValue(themeIniPath, "theme", "bg_alpha", "13");
-        setIniFileValue(themeIniPath, "theme", "bg_color", "#000000");
-        setIniFileValue(themeIniPath, "theme", "seperator_alpha", "7");
-        setIniFileValue(themeIniPath, "theme", "seperator_color", "#777777");
-        setIniFileValue(themeIniPath, "theme", "text_color", "#FFFFFF");
-        setIniFileValue(themeIniPath, "theme", "info_text_color", "#FFFFFF");
-        setIniFileValue(themeIniPath, "theme", "version_text_color", "#AAAAAA");
-        setIniFileValue(themeIniPath, "theme", "on_text_color", "#00FFDD");
-        setIniFileValue(themeIniPath, "theme", "off_text_color", "#AAAAAA");
-        setIniFileValue(themeIniPath, "theme", "invalid_text_color", "#FF0000");
-        setIniFileValue(themeIniPath, "theme", "selection_text_color", "#FFFFFF");
-        setIniFileValue(themeIniPath, "theme", "selection_bg_color", "#000000");
-        setIniFileValue(themeIniPath, "theme", "trackbar_color", "#555555");
-        setIniFileValue(themeIniPath, "theme", "highlight_color_1", "#2288CC");
-        setIniFileValue(themeIniPath, "theme", "highlight_color_2", "#88FFFF");
-        setIniFileValue(themeIniPath, "theme", "click_color", "#F7253E");
-        setIniFileValue(themeIniPath, "theme", "invert_bg_click_color", "false");
-        setIniFileValue(themeIniPath, "theme", "disable_selection_bg", "true");
-        setIniFileValue(themeIniPath, "theme", "disable_colorful_logo", "false");
-        setIniFileValue(themeIniPath, "theme", "logo_color_1", "#FFFFFF");
-        setIniFileValue(themeIniPath, "theme", "logo_color_2", "#F7253E");
-        setIniFileValue(themeIniPath, "theme", "dynamic_logo_color_1", "#00E669");
-        setIniFileValue(themeIniPath, "theme", "dynamic_logo_color_2", "#8080EA");
+    IniTransaction themeTransaction(themeIniPath);
+    
+    // write default theme entries that are missing
+    for (const auto& [key, value] : tsl::defaultThemeSettings) {
+        if (!themeTransaction.hasKey("theme", key))
+            themeTransaction.setValue("theme", key, value);
     }
+    
+    themeTransaction.commit();
 }
 
 
@@ -247,8 +136,8 @@ void copyTeslaKeyComboToUltrahand() {
 
 
 void addHelpInfo(auto& list) {
-    tsl::Color infoTextColor = tsl::RGB888(parseValueFromIniSection(themeConfigIniPath, "theme", "info_text_color"), "#FFFFFF");
-    tsl::Color onTextColor = tsl::RGB888(parseValueFromIniSection(themeConfigIniPath, "theme", "on_text_color"), "#00FFDD");
+    tsl::Color infoTextColor = tsl::getThemeTable().infoTextColor;
+    tsl::Color onTextColor = tsl::getThemeTable().onTextColor;
     
     // Add a section break with small text to indicate the "Commands" section
     list->addItem(new tsl::elm::CategoryHeader(USER_GUIDE));
@@ -300,7 +189,7 @@ void addAppInfo(auto& list, auto& packageHeader, std::string type = "package") {
     else
         list->addItem(new tsl::elm::CategoryHeader(OVERLAY_INFO));
     
-    tsl::Color infoTextColor = tsl::RGB888(parseValueFromIniSection(themeConfigIniPath, "theme", "info_text_color"), "#FFFFFF");
+    tsl::Color infoTextColor = tsl::getThemeTable().infoTextColor;
     
     constexpr int maxLineLength = 28;  // Adjust the maximum line length as needed
     constexpr int lineHeight = 20;  // Adjust the line height as needed
@@ -568,6 +457,71 @@ bool isDangerousCombination(const std::string& patternPath) {
 
 
 
+/**
+ * @brief Writes the default options INI file if it does not exist yet.
+ *
+ * @param configIniPath The path to the INI file.
+ * @param makeConfig A flag indicating whether to write the default reboot and shutdown commands.
+ */
+static void createDefaultOptionsIni(const std::string& configIniPath, bool makeConfig) {
+    FILE* configFileOut = fopen(configIniPath.c_str(), "w");
+    if (!configFileOut)
+        return;
+    
+    std::string commands;
+    if (makeConfig) {
+        commands = "["+REBOOT+"]\n"
+                   "reboot\n"
+                   "["+SHUTDOWN+"]\n"
+                   "shutdown\n";
+    } else
+        commands = "";
+    fprintf(configFileOut, "%s", commands.c_str());
+    
+    fclose(configFileOut);
+    invalidateDirectoryListing(configIniPath);
+}
+
+/**
+ * @brief Splits a command line into its arguments.
+ *
+ * Arguments are separated by spaces, text within single quotes is kept as one argument.
+ *
+ * @param commandLine The command line without its line ending.
+ * @param commandParts Receives the arguments.
+ */
+static void splitCommandLine(const std::string& commandLine, std::vector<std::string>& commandParts) {
+    commandParts.clear();
+    
+    bool inQuotes = false;
+    size_t partStart = 0, partEnd, argStart, argEnd;
+    while (partStart <= commandLine.size()) {
+        partEnd = commandLine.find('\'', partStart);
+        if (partEnd == std::string::npos)
+            partEnd = commandLine.size();
+        
+        if (partEnd > partStart) {
+            if (!inQuotes) {
+                // Outside quotes, split on spaces
+                argStart = partStart;
+                while (argStart < partEnd) {
+                    while (argStart < partEnd && std::isspace(static_cast<unsigned char>(commandLine[argStart])))
+                        ++argStart;
+                    argEnd = argStart;
+                    while (argEnd < partEnd && !std::isspace(static_cast<unsigned char>(commandLine[argEnd])))
+                        ++argEnd;
+                    if (argEnd > argStart)
+                        commandParts.emplace_back(commandLine, argStart, argEnd - argStart);
+                    argStart = argEnd;
+                }
+            } else
+                commandParts.emplace_back(commandLine, partStart, partEnd - partStart); // Inside quotes, treat as a whole argument
+        }
+        inQuotes = !inQuotes;
+        partStart = partEnd + 1;
+    }
+}
+
 /**
  * @brief Loads and parses options from an INI file.
  *
@@ -583,20 +537,10 @@ std::vector<std::pair<std::string, std::vector<std::vector<std::string>>>> loadO
     FILE* configFile = fopen(configIniPath.c_str(), "r");
     if (!configFile ) {
         // Write the default INI file
-        FILE* configFileOut = fopen(configIniPath.c_str(), "w");
-        std::string commands;
-        if (makeConfig) {
-            commands = "["+REBOOT+"]\n"
-                       "reboot\n"
-                       "["+SHUTDOWN+"]\n"
-                       "shutdown\n";
-        } else
-            commands = "";
-        fprintf(configFileOut, "%s", commands.c_str());
-        
-        
-        fclose(configFileOut);
+        createDefaultOptionsIni(configIniPath, makeConfig);
         configFile = fopen(configIniPath.c_str(), "r");
+        if (!configFile)
+            return options;
     }
     
     //constexpr size_t BufferSize = 131072; // Choose a larger buffer size for reading lines
@@ -606,11 +550,8 @@ std::vector<std::pair<std::string, std::vector<std::vector<std::string>>>> loadO
     
     bool isFirstEntry = true;
     std::string trimmedLine;
-    std::string part, arg;
-    bool inQuotes;
     
     std::vector<std::string> commandParts;
-    std::istringstream iss, argIss; // Move this line outside the loop
     
     while (fgets(line, sizeof(line), configFile)) {
         trimmedLine = line;
@@ -633,29 +574,7 @@ std::vector<std::pair<std::string, std::vector<std::vector<std::string>>>> loadO
             currentOption = trimmedLine.substr(1, trimmedLine.size() - 2);  // Extract option name
         } else {
             // Command line
-            //std::istringstream iss(trimmedLine);
-            iss.clear(); // Reset stream state
-            iss.str(trimmedLine); // Set new content
-            
-            commandParts.clear();
-            
-            part = "";
-            inQuotes = false;
-            while (std::getline(iss, part, '\'')) {
-                if (!part.empty()) {
-                    if (!inQuotes) {
-                        // Outside quotes, split on spaces
-                        argIss.clear();
-                        argIss.str(part);
-                        //std::istringstream argIss(part);
-                        arg = "";
-                        while (argIss >> arg)
-                            commandParts.push_back(arg);
-                    } else
-                        commandParts.push_back(part); // Inside quotes, treat as a whole argument
-                }
-                inQuotes = !inQuotes;
-            }
+            splitCommandLine(trimmedLine, commandParts);
             commands.push_back(std::move(commandParts));
         }
     }
@@ -669,6 +588,318 @@ std::vector<std::pair<std::string, std::vector<std::vector<std::string>>>> loadO
 }
 
 
+/**
+ * @brief Name and byte range of one option section in an INI file.
+ *
+ * The range covers the section body, from the line after its header up to the next header.
+ */
+struct OptionSection {
+    std::string name;
+    u64 headerOffset; // Start of the "[name]" line
+    u64 offset;
+    u64 size;
+};
+
+static const std::string optionIndexPath = settingsPath + "option_index/";
+static constexpr u32 optionIndexMagic = 0x58494855; // "UHIX"
+static constexpr u32 optionIndexVersion = 2;
+static constexpr size_t optionIndexMinSections = 64; // Smaller files are scanned faster than the index is validated
+
+/**
+ * @brief The path of the stored index of an INI file, keyed by a hash of the INI path.
+ */
+static std::string getOptionIndexPath(const std::string& configIniPath) {
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hashHexData(configIniPath.data(), configIniPath.size())));
+    return optionIndexPath + name + ".idx";
+}
+
+/**
+ * @brief Reads the stored index of an INI file if it still matches the file.
+ *
+ * The index must carry the INI path and the file's size, mtime and content fingerprint. The
+ * section offsets are not read back here; loadOptionCommandsFromIni() checks the header of
+ * each section it loads.
+ *
+ * @param configIniPath The path to the INI file.
+ * @param identity The identity of the INI file from readHexFileIdentity().
+ * @param sections Receives the sections.
+ * @return True if the index was valid, false otherwise.
+ */
+static bool readOptionIndex(const std::string& configIniPath, const HexAnchorFile& identity, std::vector<OptionSection>& sections) {
+    FILE* indexFile = fopen(getOptionIndexPath(configIniPath).c_str(), "rb");
+    if (!indexFile)
+        return false;
+    
+    u32 magic = 0, version = 0, count = 0;
+    u16 pathLength = 0;
+    u64 fileSize = 0, fingerprint = 0;
+    s64 modifiedTime = 0;
+    std::string indexedPath;
+    bool valid = fread(&magic, sizeof(magic), 1, indexFile) == 1 && magic == optionIndexMagic &&
+                 fread(&version, sizeof(version), 1, indexFile) == 1 && version == optionIndexVersion &&
+                 fread(&pathLength, sizeof(pathLength), 1, indexFile) == 1 && pathLength == configIniPath.size();
+    if (valid) {
+        indexedPath.resize(pathLength);
+        valid = fread(&indexedPath[0], 1, pathLength, indexFile) == pathLength && indexedPath == configIniPath &&
+                fread(&fileSize, sizeof(fileSize), 1, indexFile) == 1 && fileSize == identity.fileSize &&
+                fread(&modifiedTime, sizeof(modifiedTime), 1, indexFile) == 1 && modifiedTime == identity.modifiedTime &&
+                fread(&fingerprint, sizeof(fingerprint), 1, indexFile) == 1 && fingerprint == identity.fingerprint &&
+                fread(&count, sizeof(count), 1, indexFile) == 1;
+    }
+    
+    if (valid) {
+        sections.clear();
+        sections.reserve(count);
+        
+        u16 nameLength;
+        OptionSection section;
+        for (u32 i = 0; i < count && valid; ++i) {
+            valid = fread(&nameLength, sizeof(nameLength), 1, indexFile) == 1;
+            if (valid) {
+                section.name.resize(nameLength);
+                valid = (nameLength == 0 || fread(&section.name[0], 1, nameLength, indexFile) == nameLength) &&
+                        fread(&section.headerOffset, sizeof(section.headerOffset), 1, indexFile) == 1 &&
+                        fread(&section.offset, sizeof(section.offset), 1, indexFile) == 1 &&
+                        fread(&section.size, sizeof(section.size), 1, indexFile) == 1 &&
+                        section.headerOffset < section.offset && section.offset + section.size <= fileSize;
+            }
+            if (valid)
+                sections.push_back(section);
+        }
+    }
+    fclose(indexFile);
+    
+    if (!valid)
+        sections.clear();
+    return valid;
+}
+
+/**
+ * @brief Writes the stored index of an INI file under optionIndexPath.
+ *
+ * @param configIniPath The path to the INI file.
+ * @param identity The identity of the INI file from readHexFileIdentity().
+ * @param sections The sections to store.
+ */
+static void writeOptionIndex(const std::string& configIniPath, const HexAnchorFile& identity, const std::vector<OptionSection>& sections) {
+    if (configIniPath.size() > UINT16_MAX)
+        return;
+    
+    createDirectory(optionIndexPath);
+    const std::string indexPath = getOptionIndexPath(configIniPath);
+    FILE* indexFile = fopen(indexPath.c_str(), "wb");
+    if (!indexFile)
+        return;
+    
+    const u16 pathLength = configIniPath.size();
+    const u32 count = sections.size();
+    bool success = fwrite(&optionIndexMagic, sizeof(optionIndexMagic), 1, indexFile) == 1 &&
+                   fwrite(&optionIndexVersion, sizeof(optionIndexVersion), 1, indexFile) == 1 &&
+                   fwrite(&pathLength, sizeof(pathLength), 1, indexFile) == 1 &&
+                   fwrite(configIniPath.data(), 1, pathLength, indexFile) == pathLength &&
+                   fwrite(&identity.fileSize, sizeof(identity.fileSize), 1, indexFile) == 1 &&
+                   fwrite(&identity.modifiedTime, sizeof(identity.modifiedTime), 1, indexFile) == 1 &&
+                   fwrite(&identity.fingerprint, sizeof(identity.fingerprint), 1, indexFile) == 1 &&
+                   fwrite(&count, sizeof(count), 1, indexFile) == 1;
+    
+    u16 nameLength;
+    for (const auto& section : sections) {
+        if (!success)
+            break;
+        nameLength = static_cast<u16>(std::min<size_t>(section.name.size(), UINT16_MAX));
+        success = fwrite(&nameLength, sizeof(nameLength), 1, indexFile) == 1 &&
+                  fwrite(section.name.data(), 1, nameLength, indexFile) == nameLength &&
+                  fwrite(&section.headerOffset, sizeof(section.headerOffset), 1, indexFile) == 1 &&
+                  fwrite(&section.offset, sizeof(section.offset), 1, indexFile) == 1 &&
+                  fwrite(&section.size, sizeof(section.size), 1, indexFile) == 1;
+    }
+    
+    success = (fclose(indexFile) == 0) && success;
+    if (!success)
+        remove(indexPath.c_str()); // A partial index would be rejected anyway
+}
+
+/**
+ * @brief Indexes the option sections of an INI file without parsing their commands.
+ *
+ * Uses one sequential scan that only looks for section headers, or no scan at all when the
+ * index stored under optionIndexPath still matches the file. Large files get their index
+ * written after the scan. Commands are loaded per section with loadOptionCommandsFromIni().
+ *
+ * @param configIniPath The path to the INI file.
+ * @param makeConfig A flag indicating whether to create a config if it doesn't exist.
+ * @return The sections in file order.
+ */
+std::vector<OptionSection> indexOptionsFromIni(const std::string& configIniPath, bool makeConfig = false) {
+    std::vector<OptionSection> sections;
+    
+    struct stat fileStat;
+    if (stat(configIniPath.c_str(), &fileStat) != 0) {
+        createDefaultOptionsIni(configIniPath, makeConfig);
+        if (stat(configIniPath.c_str(), &fileStat) != 0)
+            return sections;
+    }
+    
+    HexAnchorFile identity;
+    const bool hasIdentity = readHexFileIdentity(configIniPath, identity);
+    if (hasIdentity && readOptionIndex(configIniPath, identity, sections))
+        return sections;
+    
+    FILE* configFile = fopen(configIniPath.c_str(), "rb");
+    if (!configFile)
+        return sections;
+    
+    static constexpr size_t ChunkSize = 65536;
+    std::unique_ptr<char[]> chunk(new char[ChunkSize]);
+    std::string line; // Only holds a line while it is a section header candidate
+    
+    u64 offset = 0, lineStart = 0;
+    bool atLineStart = true, headerCandidate = false;
+    bool hasSection = false;
+    OptionSection currentSection;
+    
+    auto finishLine = [&](u64 lineEnd) {
+        if (headerCandidate) {
+            line.erase(line.find_last_not_of("\r\n") + 1);
+            if (line.size() > 1 && line.back() == ']') {
+                if (hasSection && !currentSection.name.empty()) {
+                    currentSection.size = lineStart - currentSection.offset;
+                    sections.push_back(std::move(currentSection));
+                }
+                currentSection.name = line.substr(1, line.size() - 2);
+                currentSection.headerOffset = lineStart;
+                currentSection.offset = lineEnd;
+                hasSection = true;
+            }
+        }
+        line.clear();
+        headerCandidate = false;
+    };
+    
+    size_t bytesRead;
+    while ((bytesRead = fread(chunk.get(), 1, ChunkSize, configFile)) > 0) {
+        for (size_t i = 0; i < bytesRead; ++i) {
+            const char c = chunk[i];
+            if (atLineStart) {
+                lineStart = offset + i;
+                headerCandidate = (c == '[');
+                atLineStart = false;
+            }
+            if (c == '\n') {
+                if (headerCandidate)
+                    line.push_back(c);
+                finishLine(offset + i + 1);
+                atLineStart = true;
+            } else if (headerCandidate)
+                line.push_back(c);
+        }
+        offset += bytesRead;
+    }
+    fclose(configFile);
+    
+    if (!atLineStart)
+        finishLine(offset);
+    if (hasSection && !currentSection.name.empty()) {
+        currentSection.size = offset - currentSection.offset;
+        sections.push_back(std::move(currentSection));
+    }
+    
+    if (hasIdentity && sections.size() >= optionIndexMinSections)
+        writeOptionIndex(configIniPath, identity, sections);
+    
+    return sections;
+}
+
+/**
+ * @brief Opens an INI file for loading the commands of its option sections.
+ *
+ * Sections loaded in file order through the returned handle are mostly served from its buffer,
+ * so loading every section of a page costs one open and one sequential read.
+ *
+ * @param configIniPath The path to the INI file.
+ * @return The handle for loadOptionCommandsFromIni(), or nullptr. Close it with fclose().
+ */
+FILE* openOptionsIni(const std::string& configIniPath) {
+    FILE* configFile = fopen(configIniPath.c_str(), "rb");
+    if (configFile)
+        setvbuf(configFile, nullptr, _IOFBF, 16384);
+    return configFile;
+}
+
+/**
+ * @brief Reads the header line and body of a section, checking that the header is still "[name]".
+ *
+ * @param configFile The INI file, opened with openOptionsIni().
+ * @param section The section to read.
+ * @param content Receives the header line followed by the body.
+ * @return True if the header matched, false otherwise.
+ */
+static bool readOptionSection(FILE* configFile, const OptionSection& section, std::string& content) {
+    const u64 headerSize = section.offset - section.headerOffset;
+    content.assign(headerSize + section.size, '\0');
+    if (fseek(configFile, section.headerOffset, SEEK_SET) != 0 ||
+        fread(&content[0], 1, content.size(), configFile) != content.size())
+        return false;
+    
+    size_t headerEnd = content.find_last_not_of("\r\n", headerSize - 1);
+    return headerEnd != std::string::npos && headerEnd == section.name.size() + 1 &&
+           content[0] == '[' && content[headerEnd] == ']' && content.compare(1, section.name.size(), section.name) == 0;
+}
+
+/**
+ * @brief Loads the commands of a single option section.
+ *
+ * Only the header line and body of the section are read from the file. If the header is not
+ * where the index put it, the stored index is dropped and the file is scanned again.
+ *
+ * @param configFile The INI file, opened with openOptionsIni().
+ * @param section The section from indexOptionsFromIni().
+ * @param configIniPath The path to the INI file, for the rescan.
+ * @return The section's commands, split into their arguments.
+ */
+std::vector<std::vector<std::string>> loadOptionCommandsFromIni(FILE* configFile, const OptionSection& section, const std::string& configIniPath) {
+    std::vector<std::vector<std::string>> commands;
+    if (!configFile || section.size == 0)
+        return commands;
+    
+    std::string content;
+    if (!readOptionSection(configFile, section, content)) {
+        logMessage("Stale option index for " + configIniPath + ", rescanning.");
+        remove(getOptionIndexPath(configIniPath).c_str());
+        
+        content.clear();
+        for (const auto& rescannedSection : indexOptionsFromIni(configIniPath)) {
+            if (rescannedSection.name == section.name) {
+                if (!readOptionSection(configFile, rescannedSection, content))
+                    content.clear();
+                break;
+            }
+        }
+    }
+    
+    std::string trimmedLine;
+    std::vector<std::string> commandParts;
+    size_t lineStart = content.find('\n'), lineEnd; // Skip the header line
+    lineStart = (lineStart == std::string::npos) ? content.size() : lineStart + 1;
+    while (lineStart < content.size()) {
+        lineEnd = content.find('\n', lineStart);
+        if (lineEnd == std::string::npos)
+            lineEnd = content.size();
+        trimmedLine.assign(content, lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+        
+        trimmedLine.erase(trimmedLine.find_last_not_of("\r\n") + 1);  // Remove trailing carriage return
+        if (trimmedLine.empty() || trimmedLine[0] == '#')
+            continue; // Skip empty lines and comment lines
+        
+        splitCommandLine(trimmedLine, commandParts);
+        commands.push_back(std::move(commandParts));
+    }
+    return commands;
+}
+
+
 
 
 // Function to populate selectedItemsListOff from a JSON array based on a key
@@ -789,10 +1020,10 @@ std::vector<std::vector<std::string>> getSourceReplacement(const std::vector<std
         
         //modifiedCmd.reserve(cmd.size()); // Reserve memory for efficiency
         commandName = cmd[0];
-
+        
         if (commandName == "download")
             isDownloadCommand = true;
-
+        
         if (stringToLowercase(commandName) == "erista:") {
             inEristaSection = true;
             inMarikoSection = false;
@@ -885,6 +1116,67 @@ std::vector<std::vector<std::string>> getSourceReplacement(const std::vector<std
 
 
 
+/**
+ * @brief Collects the anchors that commands look up in a binary file.
+ *
+ * Both hex-by-custom-*offset commands and {hex_file(...)} placeholders are collected, starting
+ * at the given command. Arguments that still contain placeholders are skipped, since their
+ * values are only known once they run.
+ *
+ * @param commands The list of commands.
+ * @param startIndex The index of the first command to look at.
+ * @param filePath The preprocessed path of the binary file.
+ * @param hexPath The hex_file path in effect at startIndex.
+ * @return Pairs of the pattern as written in the command and its compiled pattern.
+ */
+std::vector<std::pair<std::string, HexPattern>> collectHexAnchors(const std::vector<std::vector<std::string>>& commands, size_t startIndex, const std::string& filePath, std::string hexPath) {
+    std::vector<std::pair<std::string, HexPattern>> anchors;
+    std::string customPattern, placeholderContent;
+    size_t startPos, endPos, commaPos;
+    
+    for (size_t i = startIndex; i < commands.size(); ++i) {
+        const auto& cmd = commands[i];
+        if (cmd.empty())
+            continue;
+        
+        const std::string& commandName = cmd[0];
+        if (commandName == "hex_file" && cmd.size() >= 2) {
+            hexPath = preprocessPath(cmd[1]);
+        } else if ((commandName == "hex-by-custom-offset" ||
+                    commandName == "hex-by-custom-decimal-offset" ||
+                    commandName == "hex-by-custom-rdecimal-offset") && cmd.size() >= 5) {
+            if (cmd[1].find('{') != std::string::npos || cmd[2].find('{') != std::string::npos ||
+                preprocessPath(cmd[1]) != filePath)
+                continue;
+            
+            customPattern = removeQuotes(cmd[2]);
+            anchors.emplace_back(customPattern, compileCustomPattern(customPattern));
+        }
+        
+        if (hexPath != filePath)
+            continue;
+        
+        for (const auto& arg : cmd) {
+            startPos = arg.find("{hex_file(");
+            while (startPos != std::string::npos) {
+                endPos = arg.find(")}", startPos);
+                if (endPos == std::string::npos)
+                    break;
+                
+                placeholderContent = arg.substr(startPos + 10, endPos - startPos - 10);
+                commaPos = placeholderContent.find(',');
+                if (commaPos != std::string::npos && placeholderContent.find('{') == std::string::npos) {
+                    customPattern = trim(placeholderContent.substr(0, commaPos));
+                    anchors.emplace_back(customPattern, compileCustomPattern(customPattern));
+                }
+                startPos = arg.find("{hex_file(", endPos);
+            }
+        }
+    }
+    return anchors;
+}
+
+
 /**
  * @brief Interpret and execute a list of commands.
  *
@@ -907,6 +1199,8 @@ void interpretAndExecuteCommand(const std::vector<std::vector<std::string>>& com
     
     size_t cmdSize;
     size_t occurrence;
+    u64 hexOffset;
+    s64 relativeOffset;
     size_t tryCounter = 0;
     size_t startPos, endPos;
     size_t listIndex;
@@ -923,6 +1217,23 @@ void interpretAndExecuteCommand(const std::vector<std::vector<std::string>>& com
     
     std::string message;
     
+    // Pending edits of the current run of hex-by-* commands, written when the run ends
+    std::unique_ptr<HexPatchSession> hexSession;
+    resetBinaryReadStats(); // Logged at the end when logging is on
+    resetCopyStats();
+    bool hexJournaling = false; // Set by hex-journal, records original bytes for hex-revert
+    
+    // Files whose anchors were already resolved in one pass by prefetchHexSums
+    std::vector<std::string> prefetchedHexPaths;
+    auto prefetchHexAnchors = [&](const std::string& filePath, size_t commandIndex) {
+        if (std::find(prefetchedHexPaths.begin(), prefetchedHexPaths.end(), filePath) != prefetchedHexPaths.end())
+            return;
+        prefetchedHexPaths.push_back(filePath);
+        if (hexSession && hexSession->getFilePath() == filePath)
+            hexSession->flush(); // The prefetch reads the file through its own handle
+        prefetchHexSums(filePath, collectHexAnchors(commands, commandIndex, filePath, hexPath));
+    };
+    
     for (const auto& cmd : commands) {
         
         // Check the command and perform the appropriate action
@@ -957,23 +1268,20 @@ void interpretAndExecuteCommand(const std::vector<std::vector<std::string>>& com
                 //std::vector<std::string> modifiedCmd = cmd;
                 modifiedCmd = std::move(cmd);
                 
+                // Write pending hex edits before any other command, or a {hex_file(...)} read, can see the file
+                if (hexSession && (commandName.compare(0, 7, "hex-by-") != 0 ||
+                    std::any_of(modifiedCmd.begin(), modifiedCmd.end(), [](const std::string& arg) { return arg.find("{hex_file(") != std::string::npos; })))
+                    hexSession.reset();
+                
+                // All {hex_file(...)} placeholders of the command are read with one open of the file
+                if (!hexPath.empty() && std::any_of(modifiedCmd.begin(), modifiedCmd.end(), [](const std::string& arg) { return arg.find("{hex_file(") != std::string::npos; })) {
+                    prefetchHexAnchors(hexPath, &cmd - commands.data());
+                    if (!replaceHexPlaceholders(modifiedCmd, hexPath))
+                        commandSuccess = false;
+                }
+                
                 for (auto& arg : modifiedCmd) {
                     lastArg = "";
-                    while ((!hexPath.empty() && (arg.find("{hex_file(") != std::string::npos))) {
-                        startPos = arg.find("{hex_file(");
-                        endPos = arg.find(")}");
-                        if (endPos != std::string::npos && endPos > startPos) {
-                            replacement = replaceHexPlaceholder(arg.substr(startPos, endPos - startPos + 2), hexPath);
-                            arg.replace(startPos, endPos - startPos + 2, replacement);
-                            if (arg == lastArg) {
-                                arg.replace(startPos, endPos - startPos + 2, "null"); // fall back replacement value of null
-                                commandSuccess = false;
-                                break;
-                            }
-                        } else
-                            break;
-                        lastArg = arg;
-                    }
                     while ((!iniPath.empty() && (arg.find("{ini_file(") != std::string::npos))) {
                         startPos = arg.find("{ini_file(");
                         endPos = arg.find(")}");
@@ -1166,51 +1474,69 @@ void interpretAndExecuteCommand(const std::vector<std::vector<std::string>>& com
                         const std::string& secondArg = removeQuotes(modifiedCmd[2]);
                         const std::string& thirdArg = removeQuotes(modifiedCmd[3]);
                         
+                        // Consecutive hex-by-* commands on the same file share one session
+                        if (hexSession && hexSession->getFilePath() != sourcePath)
+                            hexSession.reset();
+                        if (!hexSession)
+                            hexSession = std::make_unique<HexPatchSession>(sourcePath, hexJournaling);
+                        
                         if (commandName == "hex-by-offset") {
-                            hexEditByOffset(sourcePath.c_str(), secondArg.c_str(), thirdArg.c_str());
-                        } else if (commandName == "hex-by-swap") {
-                            if (cmdSize >= 5) {
-                                occurrence = std::stoul(removeQuotes(modifiedCmd[4]));
-                                hexEditFindReplace(sourcePath, secondArg, thirdArg, occurrence);
-                            } else {
-                                hexEditFindReplace(sourcePath, secondArg, thirdArg);
-                            }
-                        } else if (commandName == "hex-by-string") {
-                            hexDataToReplace = asciiToHex(secondArg);
-                            hexDataReplacement = asciiToHex(thirdArg);
-                            
-                            // Fix miss-matched string sizes
-                            if (hexDataReplacement.length() < hexDataToReplace.length()) {
-                                hexDataReplacement += std::string(hexDataToReplace.length() - hexDataReplacement.length(), '\0');
-                            } else if (hexDataReplacement.length() > hexDataToReplace.length()) {
-                                hexDataToReplace += std::string(hexDataReplacement.length() - hexDataToReplace.length(), '\0');
-                            }
-                            
-                            if (cmdSize >= 5) {
-                                occurrence = std::stoul(removeQuotes(modifiedCmd[4]));
-                                hexEditFindReplace(sourcePath, hexDataToReplace, hexDataReplacement, occurrence);
+                            if (!parseOffsetNumber(secondArg, hexOffset)) {
+                                logMessage("Invalid offset " + secondArg + ".");
+                                commandSuccess = false;
+                            } else
+                                hexSession->addEdit(hexOffset, HexPattern(thirdArg));
+                        } else if (commandName == "hex-by-swap" || commandName == "hex-by-string" ||
+                                   commandName == "hex-by-decimal" || commandName == "hex-by-rdecimal") {
+                            if (commandName == "hex-by-swap") {
+                                hexDataToReplace = secondArg;
+                                hexDataReplacement = thirdArg;
+                            } else if (commandName == "hex-by-string") {
+                                hexDataToReplace = asciiToHex(secondArg);
+                                hexDataReplacement = asciiToHex(thirdArg);
+                                
+                                // Fix miss-matched string sizes by padding with null bytes
+                                if (hexDataReplacement.length() < hexDataToReplace.length()) {
+                                    hexDataReplacement += std::string(hexDataToReplace.length() - hexDataReplacement.length(), '0');
+                                } else if (hexDataReplacement.length() > hexDataToReplace.length()) {
+                                    hexDataToReplace += std::string(hexDataReplacement.length() - hexDataToReplace.length(), '0');
+                                }
+                            } else if (commandName == "hex-by-decimal") {
+                                hexDataToReplace = decimalToHex(secondArg);
+                                hexDataReplacement = decimalToHex(thirdArg);
                             } else {
-                                hexEditFindReplace(sourcePath, hexDataToReplace, hexDataReplacement);
+                                hexDataToReplace = decimalToReversedHex(secondArg);
+                                hexDataReplacement = decimalToReversedHex(thirdArg);
                             }
-                        } else if (commandName == "hex-by-decimal") {
-                            hexDataToReplace = decimalToHex(secondArg);
-                            hexDataReplacement = decimalToHex(thirdArg);
                             
-                            if (cmdSize >= 5) {
-                                occurrence = std::stoul(removeQuotes(modifiedCmd[4]));
-                                hexEditFindReplace(sourcePath, hexDataToReplace, hexDataReplacement, occurrence);
-                            } else {
-                                hexEditFindReplace(sourcePath, hexDataToReplace, hexDataReplacement);
-                            }
-                        } else if (commandName == "hex-by-rdecimal") {
-                            hexDataToReplace = decimalToReversedHex(secondArg);
-                            hexDataReplacement = decimalToReversedHex(thirdArg);
+                            occurrence = 0;
+                            if (commandName != "hex-by-swap" && commandName != "hex-by-string" &&
+                                (hexDataToReplace.empty() || hexDataReplacement.empty())) {
+                                logMessage("Invalid decimal " + secondArg + " or " + thirdArg + ".");
+                                commandSuccess = false;
+                            } else if (cmdSize >= 5 && !parseOffsetNumber(removeQuotes(modifiedCmd[4]), occurrence)) {
+                                logMessage("Invalid occurrence " + modifiedCmd[4] + ".");
+                                commandSuccess = false;
+                            } else
+                                hexSession->addFindReplace(HexPattern(hexDataToReplace), HexPattern(hexDataReplacement), occurrence);
+                        } else if (commandName == "hex-by-pattern") {
+                            // Hexadecimal data with "??" wildcards, a shorter replacement keeps the remaining bytes
+                            HexPattern findPattern(secondArg), replacementPattern(thirdArg);
                             
-                            if (cmdSize >= 5) {
-                                occurrence = std::stoul(removeQuotes(modifiedCmd[4]));
-                                hexEditFindReplace(sourcePath, hexDataToReplace, hexDataReplacement, occurrence);
+                            occurrence = 0;
+                            if (findPattern.empty() || replacementPattern.empty()) {
+                                logMessage("Invalid pattern " + secondArg + " or " + thirdArg + ".");
+                                commandSuccess = false;
+                            } else if (cmdSize >= 5 && !parseOffsetNumber(removeQuotes(modifiedCmd[4]), occurrence)) {
+                                logMessage("Invalid occurrence " + modifiedCmd[4] + ".");
+                                commandSuccess = false;
                             } else {
-                                hexEditFindReplace(sourcePath, hexDataToReplace, hexDataReplacement);
+                                if (replacementPattern.size() < findPattern.size()) {
+                                    replacementPattern.bytes.resize(findPattern.size(), 0x00);
+                                    replacementPattern.mask.resize(findPattern.size(), 0x00);
+                                    replacementPattern.hasWildcards = true;
+                                }
+                                hexSession->addFindReplace(findPattern, replacementPattern, occurrence);
                             }
                         } else if (commandName == "hex-by-custom-offset" ||
                                    commandName == "hex-by-custom-decimal-offset" ||
@@ -1226,10 +1552,39 @@ void interpretAndExecuteCommand(const std::vector<std::vector<std::string>>& com
                                     hexDataReplacement = decimalToReversedHex(hexDataReplacement);
                                 }
                                 
-                                hexEditByCustomOffset(sourcePath.c_str(), customPattern.c_str(), offset.c_str(), hexDataReplacement.c_str());
+                                if (commandName != "hex-by-custom-offset" && hexDataReplacement.empty()) {
+                                    logMessage("Invalid decimal " + removeQuotes(modifiedCmd[4]) + ".");
+                                    commandSuccess = false;
+                                } else if (!parseOffsetNumber(offset, relativeOffset)) {
+                                    logMessage("Invalid offset " + offset + ".");
+                                    commandSuccess = false;
+                                } else {
+                                    prefetchHexAnchors(sourcePath, &cmd - commands.data());
+                                    if (!hexSession->addCustomOffsetEdit(customPattern, relativeOffset, HexPattern(hexDataReplacement)))
+                                        logMessage("Failed to find " + customPattern + ".");
+                                }
                             }
                         }
                     }
+                } else if (commandName == "hex-journal") {
+                    hexJournaling = (cmdSize < 2 || removeQuotes(modifiedCmd[1]) != "off");
+                } else if (commandName == "hex-revert") {
+                    if (cmdSize >= 2) {
+                        sourcePath = preprocessPath(modifiedCmd[1]);
+                        commandSuccess = revertHexJournal(sourcePath) && commandSuccess;
+                    }
+                } else if (commandName == "hex-commit") {
+                    if (cmdSize >= 2) {
+                        sourcePath = preprocessPath(modifiedCmd[1]);
+                        commitHexJournal(sourcePath);
+                    }
+                } else if (commandName == "ips-apply") {
+                    if (cmdSize >= 3) {
+                        sourcePath = preprocessPath(modifiedCmd[1]);
+                        destinationPath = preprocessPath(modifiedCmd[2]);
+                        const bool verifyOnly = (cmdSize >= 4 && removeQuotes(modifiedCmd[3]) == "verify");
+                        commandSuccess = applyIpsPatch(sourcePath, destinationPath, verifyOnly, hexJournaling) && commandSuccess;
+                    }
                 } else if (commandName == "download") {
                     if (cmdSize >= 3) {
                         fileUrl = preprocessUrl(modifiedCmd[1]);
@@ -1389,7 +1744,7 @@ void interpretAndExecuteCommand(const std::vector<std::vector<std::string>>& com
                     splExit();
                     fsdevUnmountAll();
                     spsmShutdown(SpsmShutdownMode_Reboot);
-                    
+                
                 } else if (commandName == "shutdown") {
                     // Reboot command
                     splExit();
@@ -1411,7 +1766,11 @@ void interpretAndExecuteCommand(const std::vector<std::vector<std::string>>& com
                         if (clearOption == "log")
                             deleteFileOrDirectory(logFilePath);
                         else if (clearOption == "hex_sum_cache")
-                            hexSumCache.clear();
+                            clearHexAnchorCache();
+                        else if (clearOption == "ini_cache")
+                            clearIniCache();
+                        else if (clearOption == "listing_cache")
+                            clearDirectoryListingCache();
                     }
                 }
                 
@@ -1426,4 +1785,24 @@ void interpretAndExecuteCommand(const std::vector<std::vector<std::string>>& com
             }
         }
     }
+    
+    hexSession.reset();
+    saveHexAnchorCache();
+    tsl::refreshThemeTable(themeConfigIniPath); // Commands may have copied over or edited theme.ini
+    
+    if (logging) {
+        const BinaryReadStats& readStats = getBinaryReadStats();
+        logMessage("Binary reads: " + std::to_string(readStats.bytesRead) + " bytes in " + std::to_string(readStats.readCalls) +
+            " reads, " + std::to_string(readStats.elapsedUs) + " us (" + std::to_string(binaryReaderBufferSize / 1024) + " KB buffer)");
+        const CopyStats& copyStats = getCopyStats();
+        if (copyStats.filesCopied > 0 || copyStats.filesFailed > 0)
+            logMessage("Copies: " + std::to_string(copyStats.bytesCopied) + " bytes in " + std::to_string(copyStats.filesCopied) + " files (" +
+                std::to_string(copyStats.filesFailed) + " failed), " + std::to_string(copyStats.elapsedUs) + " us (" + std::to_string(copyBufferSize / 1024) + " KB buffers)");
+        size_t iniHits, iniMisses;
+        getIniCacheStats(iniHits, iniMisses);
+        logMessage("INI cache: " + std::to_string(iniHits) + " hits, " + std::to_string(iniMisses) + " misses");
+        size_t listingHits, listingMisses;
+        getDirectoryListingCacheStats(listingHits, listingMisses);
+        logMessage("Listing cache: " + std::to_string(listingHits) + " hits, " + std::to_string(listingMisses) + " misses");
+    }
 }
@@ -0,0 +1,332 @@
+/********************************************************************************
+ * File: bench.hpp
+ * Author: ppkantorski
+ * Description:
+ *   This header file provides the small benchmark runner used by the host
+ *   benchmarks. Benchmarks are written like Google Benchmark ones: a function
+ *   loops while state.keepRunning() and reports the bytes or items it handled.
+ *   Each one is rerun with more iterations until it takes at least the minimum
+ *   time, and the results can be written as Google Benchmark style JSON.
+ *
+ *   Usage:
+ *     bench_ini [--filter=<substring>] [--min-time=<seconds>] [--json=<file>]
+ *
+ *   For the latest updates and contributions, visit the project's GitHub repository.
+ *   (GitHub Repository: https://github.com/ppkantorski/Ultrahand-Overlay)
+ *
+ *   Note: Please be aware that this notice cannot be altered or removed. It is a part
+ *   of the project's documentation and must remain intact.
+ *
+ *  Licensed under both GPLv2 and CC-BY-4.0
+ *  Copyright (c) 2024 ppkantorski
+ ********************************************************************************/
+
+#pragma once
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+/**
+ * @brief Iteration state handed to a benchmark function.
+ */
+class BenchState {
+public:
+    explicit BenchState(uint64_t maxIterations) : maxIterations(maxIterations) {}
+    
+    /**
+     * @brief Starts the clock on the first call and stops it after the last iteration.
+     *
+     * @return True while iterations are left.
+     */
+    bool keepRunning() {
+        if (iterations == 0 && !running)
+            resumeTiming();
+        if (iterations < maxIterations) {
+            ++iterations;
+            return true;
+        }
+        pauseTiming();
+        return false;
+    }
+    
+    /**
+     * @brief Excludes setup work inside the loop from the measured time.
+     */
+    void pauseTiming() {
+        if (running) {
+            elapsed += std::chrono::steady_clock::now() - start;
+            running = false;
+        }
+    }
+    
+    void resumeTiming() {
+        if (!running) {
+            start = std::chrono::steady_clock::now();
+            running = true;
+        }
+    }
+    
+    void setBytesProcessed(uint64_t bytes) { bytesProcessed = bytes; }
+    void setItemsProcessed(uint64_t items) { itemsProcessed = items; }
+    void setLabel(const std::string& text) { label = text; }
+    
+    /**
+     * @brief Marks the run as failed, for example when its input could not be prepared.
+     */
+    void skipWithError(const std::string& message) {
+        error = message;
+        maxIterations = iterations;
+    }
+    
+    uint64_t getIterations() const { return iterations; }
+
+private:
+    friend class BenchRunner;
+    
+    uint64_t maxIterations;
+    uint64_t iterations = 0;
+    uint64_t bytesProcessed = 0;
+    uint64_t itemsProcessed = 0;
+    std::string label;
+    std::string error;
+    bool running = false;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::duration elapsed{0};
+};
+
+/**
+ * @brief Keeps the compiler from dropping a result that is otherwise unused.
+ */
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * @brief Registers, runs and reports benchmarks.
+ */
+class BenchRunner {
+public:
+    using BenchFunction = std::function<void(BenchState&)>;
+    
+    void add(const std::string& name, BenchFunction function) {
+        benchmarks.push_back({name, std::move(function)});
+    }
+    
+    /**
+     * @brief Parses the command line, runs the matching benchmarks and writes the report.
+     *
+     * @return The process exit code, non-zero if a benchmark failed or the JSON could not be written.
+     */
+    int run(int argc, char* argv[]) {
+        std::string filter, jsonPath;
+        double minTime = 0.5;
+        for (int i = 1; i < argc; ++i) {
+            if (std::strncmp(argv[i], "--filter=", 9) == 0)
+                filter = argv[i] + 9;
+            else if (std::strncmp(argv[i], "--min-time=", 11) == 0)
+                minTime = std::atof(argv[i] + 11);
+            else if (std::strncmp(argv[i], "--json=", 7) == 0)
+                jsonPath = argv[i] + 7;
+            else {
+                fprintf(stderr, "Usage: %s [--filter=<substring>] [--min-time=<seconds>] [--json=<file>]\n", argv[0]);
+                return 2;
+            }
+        }
+        
+        printf("%-48s %14s %12s %14s %14s\n", "Benchmark", "Time", "Iterations", "Bytes/s", "Items/s");
+        printf("%s\n", std::string(106, '-').c_str());
+        
+        bool failed = false;
+        for (const auto& benchmark : benchmarks) {
+            if (!filter.empty() && benchmark.name.find(filter) == std::string::npos)
+                continue;
+            
+            Result result = measure(benchmark, minTime);
+            failed = failed || !result.error.empty();
+            print(result);
+            results.push_back(std::move(result));
+        }
+        
+        if (!jsonPath.empty() && !writeJson(jsonPath, argv[0])) {
+            fprintf(stderr, "Failed to write %s\n", jsonPath.c_str());
+            return 1;
+        }
+        return failed ? 1 : 0;
+    }
+
+private:
+    struct Benchmark {
+        std::string name;
+        BenchFunction function;
+    };
+    
+    struct Result {
+        std::string name;
+        uint64_t iterations = 0;
+        double nsPerIteration = 0;
+        double bytesPerSecond = 0;
+        double itemsPerSecond = 0;
+        std::string label;
+        std::string error;
+    };
+    
+    std::vector<Benchmark> benchmarks;
+    std::vector<Result> results;
+    
+    /**
+     * @brief Runs a benchmark with growing iteration counts until it takes at least minTime.
+     */
+    static Result measure(const Benchmark& benchmark, double minTime) {
+        Result result;
+        result.name = benchmark.name;
+        
+        uint64_t iterations = 1;
+        while (true) {
+            BenchState state(iterations);
+            benchmark.function(state);
+            state.pauseTiming();
+            
+            const double seconds = std::chrono::duration<double>(state.elapsed).count();
+            if (!state.error.empty()) {
+                result.error = state.error;
+                return result;
+            }
+            
+            if (seconds >= minTime || iterations >= 1000000000ULL) {
+                result.iterations = state.iterations;
+                result.nsPerIteration = seconds * 1e9 / std::max<uint64_t>(state.iterations, 1);
+                result.bytesPerSecond = seconds > 0 ? state.bytesProcessed / seconds : 0;
+                result.itemsPerSecond = seconds > 0 ? state.itemsProcessed / seconds : 0;
+                result.label = state.label;
+                return result;
+            }
+            
+            // Aim a bit past minTime, growing at most tenfold per round like Google Benchmark
+            const double scale = (seconds > 0) ? minTime * 1.4 / seconds : 10.0;
+            iterations = std::max<uint64_t>(iterations + 1, iterations * std::min(scale, 10.0));
+        }
+    }
+    
+    static std::string formatRate(double value, const char* unit) {
+        static const char* prefixes[] = {"", "k", "M", "G", "T"};
+        size_t prefix = 0;
+        while (value >= 1000.0 && prefix + 1 < sizeof(prefixes) / sizeof(prefixes[0])) {
+            value /= 1000.0;
+            ++prefix;
+        }
+        char text[32];
+        snprintf(text, sizeof(text), "%.2f %s%s", value, prefixes[prefix], unit);
+        return text;
+    }
+    
+    static void print(const Result& result) {
+        if (!result.error.empty()) {
+            printf("%-48s ERROR: %s\n", result.name.c_str(), result.error.c_str());
+            return;
+        }
+        
+        char time[32];
+        if (result.nsPerIteration >= 1e6)
+            snprintf(time, sizeof(time), "%.3f ms", result.nsPerIteration / 1e6);
+        else if (result.nsPerIteration >= 1e3)
+            snprintf(time, sizeof(time), "%.3f us", result.nsPerIteration / 1e3);
+        else
+            snprintf(time, sizeof(time), "%.1f ns", result.nsPerIteration);
+        
+        printf("%-48s %14s %12llu %14s %14s %s\n", result.name.c_str(), time, static_cast<unsigned long long>(result.iterations),
+            result.bytesPerSecond > 0 ? formatRate(result.bytesPerSecond, "B/s").c_str() : "",
+            result.itemsPerSecond > 0 ? formatRate(result.itemsPerSecond, "/s").c_str() : "",
+            result.label.c_str());
+    }
+    
+    static std::string escapeJson(const std::string& text) {
+        std::string escaped;
+        for (char c : text) {
+            if (c == '"' || c == '\\')
+                escaped.push_back('\\');
+            if (static_cast<unsigned char>(c) < 0x20)
+                continue;
+            escaped.push_back(c);
+        }
+        return escaped;
+    }
+    
+    /**
+     * @brief Writes the results in the layout of Google Benchmark's --benchmark_format=json.
+     */
+    bool writeJson(const std::string& jsonPath, const char* executable) const {
+        FILE* jsonFile = fopen(jsonPath.c_str(), "w");
+        if (!jsonFile)
+            return false;
+        
+        char date[32];
+        const std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+        
+        fprintf(jsonFile, "{\n  \"context\": {\n");
+        fprintf(jsonFile, "    \"date\": \"%s\",\n", date);
+        fprintf(jsonFile, "    \"executable\": \"%s\",\n", escapeJson(executable).c_str());
+        fprintf(jsonFile, "    \"num_cpus\": %u\n", std::thread::hardware_concurrency());
+        fprintf(jsonFile, "  },\n  \"benchmarks\": [");
+        
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& result = results[i];
+            fprintf(jsonFile, "%s\n    {\n", i == 0 ? "" : ",");
+            fprintf(jsonFile, "      \"name\": \"%s\",\n", escapeJson(result.name).c_str());
+            if (!result.error.empty()) {
+                fprintf(jsonFile, "      \"error_occurred\": true,\n");
+                fprintf(jsonFile, "      \"error_message\": \"%s\"\n    }", escapeJson(result.error).c_str());
+                continue;
+            }
+            fprintf(jsonFile, "      \"iterations\": %llu,\n", static_cast<unsigned long long>(result.iterations));
+            fprintf(jsonFile, "      \"real_time\": %.3f,\n", result.nsPerIteration);
+            fprintf(jsonFile, "      \"time_unit\": \"ns\"");
+            if (result.bytesPerSecond > 0)
+                fprintf(jsonFile, ",\n      \"bytes_per_second\": %.3f", result.bytesPerSecond);
+            if (result.itemsPerSecond > 0)
+                fprintf(jsonFile, ",\n      \"items_per_second\": %.3f", result.itemsPerSecond);
+            if (!result.label.empty())
+                fprintf(jsonFile, ",\n      \"label\": \"%s\"", escapeJson(result.label).c_str());
+            fprintf(jsonFile, "\n    }");
+        }
+        fprintf(jsonFile, "\n  ]\n}\n");
+        
+        return fclose(jsonFile) == 0;
+    }
+};
+
+/**
+ * @brief Builds synthetic package.ini style content of about the given size.
+ *
+ * Sections hold a few commands each, like the options of a large mod package.
+ *
+ * @param targetSize The size to reach, in bytes.
+ * @return The INI content.
+ */
+inline std::string makeSyntheticIni(size_t targetSize) {
+    std::string content;
+    content.reserve(targetSize + 256);
+    content += "; synthetic package\n[*Options]\n";
+    
+    size_t section = 0;
+    while (content.size() < targetSize) {
+        content += "[Option " + std::to_string(section) + "]\n";
+        content += "mode = toggle\n";
+        content += "value_" + std::to_string(section) + " = " + std::to_string(section * 7919 % 100003) + "\n";
+        content += "copy /switch/.packages/Example/files/" + std::to_string(section) + ".bin /atmosphere/contents/0100000000000000/\n";
+        content += "set-ini-val /config/example/config.ini settings key_" + std::to_string(section) + " " + std::to_string(section) + "\n";
+        content += "\n";
+        ++section;
+    }
+    return content;
+}
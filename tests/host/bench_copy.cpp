@@ -0,0 +1,244 @@
+/********************************************************************************
+ * File: bench_copy.cpp
+ * Author: ppkantorski
+ * Description:
+ *   Benchmarks the CopyPipeline of copy_engine.hpp against the fread/fwrite
+ *   loop it replaced, on one large file and on 2000 small files spread over
+ *   20 folders. The fread loop below is copySingleFile() of the code before
+ *   the pipeline, kept here as the reference. Every run ends by comparing
+ *   each copy with its source, byte for byte.
+ *
+ *   Large - bytes per second copied from one 64 MB file
+ *   Small - bytes per second copied from 2000 files of 1 - 32 KB
+ *
+ *   Usage:
+ *     bench_copy [--buffer-size=<bytes>[K|M]] [--buffer-count=<count>] [bench options]
+ *
+ *   The buffer size and count are those of the pipeline, 512K and 2 by default.
+ *
+ *   For the latest updates and contributions, visit the project's GitHub repository.
+ *   (GitHub Repository: https://github.com/ppkantorski/Ultrahand-Overlay)
+ *
+ *   Note: Please be aware that this notice cannot be altered or removed. It is a part
+ *   of the project's documentation and must remain intact.
+ *
+ *  Licensed under both GPLv2 and CC-BY-4.0
+ *  Copyright (c) 2024 ppkantorski
+ ********************************************************************************/
+
+#include "host.hpp"
+#include "bench.hpp"
+
+
+static constexpr size_t LARGE_FILE_SIZE = 64 * 1024 * 1024;
+static constexpr size_t SMALL_FILE_COUNT = 2000;
+static constexpr size_t SMALL_FOLDER_COUNT = 20;
+
+struct CopyJob {
+    std::string fromFile;
+    std::string toFile;
+};
+
+static std::vector<CopyJob> largeJobs, smallJobs;
+static uint64_t largeBytes = 0, smallBytes = 0;
+static size_t pipelineBufferSize = copyBufferSize;
+static size_t pipelineBufferCount = copyBufferCount;
+
+/**
+ * @brief The fread/fwrite loop that copySingleFile() used to be.
+ */
+static void freadCopySingleFile(const std::string& fromFile, const std::string& toFile) {
+    FILE* srcFile = fopen(fromFile.c_str(), "rb");
+    FILE* destFile = fopen(toFile.c_str(), "wb");
+    if (srcFile && destFile) {
+        const size_t bufferSize = 131072; // Increase buffer size to 128 KB
+        char buffer[bufferSize];
+        size_t bytesRead;
+        
+        while ((bytesRead = fread(buffer, 1, bufferSize, srcFile)) > 0)
+            fwrite(buffer, 1, bytesRead, destFile);
+    }
+    if (srcFile)
+        fclose(srcFile);
+    if (destFile)
+        fclose(destFile);
+}
+
+/**
+ * @brief Fills a file with bytes from a fixed seed, so every run copies the same data.
+ */
+static bool writeSeededFile(const std::string& filePath, size_t size, uint32_t seed) {
+    std::string content(size, '\0');
+    uint32_t state = seed | 1;
+    for (size_t i = 0; i < size; ++i) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        content[i] = static_cast<char>(state);
+    }
+    return writeHostFile(filePath, content);
+}
+
+/**
+ * @brief Writes the source files and creates the destination folders.
+ */
+static bool makeSources(const std::string& scratchPath) {
+    namespace fs = std::filesystem;
+    std::error_code error;
+    
+    const std::string sourcePath = scratchPath + "source/";
+    const std::string destinationPath = scratchPath + "destination/";
+    fs::create_directories(sourcePath, error);
+    fs::create_directories(destinationPath, error);
+    
+    largeJobs.push_back({sourcePath + "large.bin", destinationPath + "large.bin"});
+    largeBytes = LARGE_FILE_SIZE;
+    if (!writeSeededFile(largeJobs[0].fromFile, LARGE_FILE_SIZE, 0x9E3779B9))
+        return false;
+    
+    std::string folder;
+    size_t size;
+    for (size_t file = 0; file < SMALL_FILE_COUNT; ++file) {
+        folder = "folder_" + std::to_string(file % SMALL_FOLDER_COUNT) + "/";
+        if (file < SMALL_FOLDER_COUNT) {
+            fs::create_directories(sourcePath + folder, error);
+            fs::create_directories(destinationPath + folder, error);
+        }
+        
+        const std::string name = folder + "file_" + std::to_string(file) + ".bin";
+        size = 1024 + (file * 7919) % (31 * 1024);
+        if (!writeSeededFile(sourcePath + name, size, static_cast<uint32_t>(file)))
+            return false;
+        smallJobs.push_back({sourcePath + name, destinationPath + name});
+        smallBytes += size;
+    }
+    return true;
+}
+
+/**
+ * @brief Checks that every copy exists and matches its source.
+ */
+static bool copiesMatch(const std::vector<CopyJob>& jobs) {
+    for (const auto& job : jobs) {
+        struct stat fileStat;
+        if (stat(job.toFile.c_str(), &fileStat) != 0 || readHostFile(job.toFile) != readHostFile(job.fromFile))
+            return false;
+    }
+    return true;
+}
+
+static void removeCopies(const std::vector<CopyJob>& jobs) {
+    for (const auto& job : jobs)
+        remove(job.toFile.c_str());
+}
+
+/**
+ * @brief Copies all jobs to fresh destinations per iteration and checks the copies after the last one.
+ */
+template <typename Copy>
+static void benchCopy(BenchState& state, const std::vector<CopyJob>& jobs, uint64_t bytes, Copy&& copyJobs) {
+    while (state.keepRunning()) {
+        state.pauseTiming();
+        removeCopies(jobs);
+        sync(); // Start each copy without the writeback of the previous one
+        state.resumeTiming();
+        
+        copyJobs(jobs);
+    }
+    state.setBytesProcessed(state.getIterations() * bytes);
+    state.setItemsProcessed(state.getIterations() * jobs.size());
+    
+    if (!copiesMatch(jobs))
+        state.skipWithError("a copy differs from its source");
+}
+
+static void copyWithFread(const std::vector<CopyJob>& jobs) {
+    for (const auto& job : jobs)
+        freadCopySingleFile(job.fromFile, job.toFile);
+}
+
+/**
+ * @brief Copies all jobs through one pipeline, as a directory copy does.
+ */
+static void copyWithPipeline(const std::vector<CopyJob>& jobs) {
+    CopyPipeline pipeline(pipelineBufferSize, pipelineBufferCount);
+    for (const auto& job : jobs)
+        pipeline.copyFile(job.fromFile, job.toFile);
+    pipeline.finish();
+}
+
+static void registerCopyBenchmarks(BenchRunner& runner) {
+    const std::string pipelineName = "CopyPipeline_" + std::to_string(pipelineBufferSize / 1024) + "Kx" + std::to_string(pipelineBufferCount);
+    
+    runner.add("Large/fread_baseline/64MB", [](BenchState& state) {
+        benchCopy(state, largeJobs, largeBytes, copyWithFread);
+    });
+    
+    runner.add("Large/" + pipelineName + "/64MB", [](BenchState& state) {
+        benchCopy(state, largeJobs, largeBytes, copyWithPipeline);
+    });
+    
+    runner.add("Small/fread_baseline/2000_files", [](BenchState& state) {
+        benchCopy(state, smallJobs, smallBytes, copyWithFread);
+    });
+    
+    runner.add("Small/" + pipelineName + "/2000_files", [](BenchState& state) {
+        benchCopy(state, smallJobs, smallBytes, copyWithPipeline);
+    });
+}
+
+/**
+ * @brief Parses a byte count with an optional K or M suffix.
+ */
+static bool parseByteCount(const char* text, size_t& value) {
+    char* end;
+    const unsigned long long number = std::strtoull(text, &end, 10);
+    if (end == text)
+        return false;
+    
+    value = number;
+    if (*end == 'K' || *end == 'k') {
+        value *= 1024;
+        ++end;
+    } else if (*end == 'M' || *end == 'm') {
+        value *= 1024 * 1024;
+        ++end;
+    }
+    return *end == '\0' && value > 0;
+}
+
+int main(int argc, char* argv[]) {
+    // Take the pipeline options out, the rest goes to the runner
+    std::vector<char*> runnerArgs{argv[0]};
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--buffer-size=", 14) == 0) {
+            if (!parseByteCount(argv[i] + 14, pipelineBufferSize)) {
+                fprintf(stderr, "Invalid buffer size %s\n", argv[i] + 14);
+                return 2;
+            }
+        } else if (std::strncmp(argv[i], "--buffer-count=", 15) == 0) {
+            if (!parseByteCount(argv[i] + 15, pipelineBufferCount)) {
+                fprintf(stderr, "Invalid buffer count %s\n", argv[i] + 15);
+                return 2;
+            }
+        } else
+            runnerArgs.push_back(argv[i]);
+    }
+    
+    const std::string scratchPath = makeScratchDirectory("bench_copy");
+    if (!makeSources(scratchPath)) {
+        fprintf(stderr, "Failed to write the source files to %s\n", scratchPath.c_str());
+        return 1;
+    }
+    
+    BenchRunner runner;
+    registerCopyBenchmarks(runner);
+    const int result = runner.run(static_cast<int>(runnerArgs.size()), runnerArgs.data());
+    
+    const CopyStats& stats = getCopyStats();
+    printf("\nCopyPipeline totals: %llu files, %llu failed\n",
+        static_cast<unsigned long long>(stats.filesCopied), static_cast<unsigned long long>(stats.filesFailed));
+    
+    removeScratchDirectory(scratchPath);
+    return (result == 0 && stats.filesFailed == 0) ? 0 : 1;
+}
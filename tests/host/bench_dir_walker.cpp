@@ -0,0 +1,223 @@
+/********************************************************************************
+ * File: bench_dir_walker.cpp
+ * Author: ppkantorski
+ * Description:
+ *   Benchmarks the listing and delete functions built on DirWalker against the
+ *   readdir + stat versions they replaced, on a synthetic tree of 50 folders
+ *   of 100 files. The stat functions below are getSubdirectories(),
+ *   getFilesListFromDirectory() and deleteFileOrDirectory() of the code
+ *   before dir_walker.hpp, kept here as the reference.
+ *
+ *   List   - entries per second listed from one directory and from the tree
+ *   Delete - entries per second removed from a copy of the tree
+ *
+ *   For the latest updates and contributions, visit the project's GitHub repository.
+ *   (GitHub Repository: https://github.com/ppkantorski/Ultrahand-Overlay)
+ *
+ *   Note: Please be aware that this notice cannot be altered or removed. It is a part
+ *   of the project's documentation and must remain intact.
+ *
+ *  Licensed under both GPLv2 and CC-BY-4.0
+ *  Copyright (c) 2024 ppkantorski
+ ********************************************************************************/
+
+#include "host.hpp"
+#include "bench.hpp"
+
+
+static constexpr size_t FOLDER_COUNT = 50;
+static constexpr size_t FILES_PER_FOLDER = 100;
+
+static std::string treePath, deletePath;
+
+/**
+ * @brief The readdir + stat subdirectory listing that getSubdirectories() used to be.
+ */
+static std::vector<std::string> statGetSubdirectories(const std::string& directoryPath) {
+    std::vector<std::string> subdirectories;
+    
+    DIR* dir = opendir(directoryPath.c_str());
+    if (dir != nullptr) {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            std::string entryName = entry->d_name;
+            if (entryName != "." && entryName != "..") {
+                struct stat entryStat;
+                std::string fullPath = directoryPath + "/" + entryName;
+                if (stat(fullPath.c_str(), &entryStat) == 0 && S_ISDIR(entryStat.st_mode))
+                    subdirectories.push_back(entryName);
+            }
+        }
+        closedir(dir);
+    }
+    return subdirectories;
+}
+
+/**
+ * @brief The recursive readdir + stat file listing that getFilesListFromDirectory() used to be.
+ */
+static std::vector<std::string> statGetFilesListFromDirectory(const std::string& directoryPath) {
+    std::vector<std::string> fileList;
+    
+    DIR* dir = opendir(directoryPath.c_str());
+    if (dir != nullptr) {
+        dirent* entry;
+        std::string entryName, entryPath;
+        std::vector<std::string> subDirFiles;
+        while ((entry = readdir(dir)) != nullptr) {
+            entryName = entry->d_name;
+            entryPath = directoryPath;
+            if (entryPath.back() != '/')
+                entryPath += '/';
+            entryPath += entryName;
+            
+            if (entryName != "." && entryName != "..") {
+                if (isDirectory(entryPath)) {
+                    subDirFiles = statGetFilesListFromDirectory(entryPath);
+                    fileList.insert(fileList.end(), subDirFiles.begin(), subDirFiles.end());
+                } else
+                    fileList.push_back(entryPath);
+            }
+        }
+        closedir(dir);
+    }
+    return fileList;
+}
+
+/**
+ * @brief The recursive stat based delete that deleteFileOrDirectory() used to be.
+ */
+static void statDeleteFileOrDirectory(const std::string& pathToDelete) {
+    struct stat pathStat;
+    if (stat(pathToDelete.c_str(), &pathStat) != 0)
+        return;
+    
+    if (S_ISREG(pathStat.st_mode))
+        std::remove(pathToDelete.c_str());
+    else if (S_ISDIR(pathStat.st_mode)) {
+        DIR* directory = opendir(pathToDelete.c_str());
+        if (directory != nullptr) {
+            dirent* entry;
+            while ((entry = readdir(directory)) != nullptr) {
+                const std::string fileName = entry->d_name;
+                if (fileName != "." && fileName != "..")
+                    statDeleteFileOrDirectory(pathToDelete + "/" + fileName);
+            }
+            closedir(directory);
+        }
+        rmdir(pathToDelete.c_str());
+    }
+}
+
+/**
+ * @brief Creates FOLDER_COUNT folders of FILES_PER_FOLDER small files, plus as many files beside them.
+ */
+static bool makeTree(const std::string& rootPath) {
+    namespace fs = std::filesystem;
+    std::error_code error;
+    fs::create_directories(rootPath, error);
+    
+    for (size_t folder = 0; folder < FOLDER_COUNT; ++folder) {
+        const std::string folderPath = rootPath + "folder_" + std::to_string(folder) + "/";
+        if (!fs::create_directory(folderPath, error) && error)
+            return false;
+        
+        for (size_t file = 0; file < FILES_PER_FOLDER; ++file) {
+            if (!writeHostFile(folderPath + "file_" + std::to_string(file) + ".bin", "data"))
+                return false;
+        }
+        if (!writeHostFile(rootPath + "file_" + std::to_string(folder) + ".bin", "data"))
+            return false;
+    }
+    return true;
+}
+
+static constexpr uint64_t treeEntryCount() {
+    return FOLDER_COUNT * (FILES_PER_FOLDER + 2);
+}
+
+static void registerListBenchmarks(BenchRunner& runner) {
+    runner.add("List/stat_baseline/getSubdirectories", [](BenchState& state) {
+        while (state.keepRunning())
+            doNotOptimize(statGetSubdirectories(treePath).size());
+        state.setItemsProcessed(state.getIterations() * FOLDER_COUNT * 2);
+    });
+    
+    runner.add("List/DirWalker/getSubdirectories", [](BenchState& state) {
+        while (state.keepRunning())
+            doNotOptimize(getSubdirectories(treePath).size());
+        state.setItemsProcessed(state.getIterations() * FOLDER_COUNT * 2);
+    });
+    
+    runner.add("List/stat_baseline/getFilesListFromDirectory", [](BenchState& state) {
+        while (state.keepRunning())
+            doNotOptimize(statGetFilesListFromDirectory(treePath).size());
+        state.setItemsProcessed(state.getIterations() * treeEntryCount());
+    });
+    
+    runner.add("List/DirWalker/getFilesListFromDirectory", [](BenchState& state) {
+        while (state.keepRunning())
+            doNotOptimize(getFilesListFromDirectory(treePath).size());
+        state.setItemsProcessed(state.getIterations() * treeEntryCount());
+    });
+}
+
+/**
+ * @brief Deletes a fresh copy of the tree per iteration, building the copy outside the timing.
+ */
+template <typename Delete>
+static void benchDelete(BenchState& state, Delete&& deleteTree) {
+    while (state.keepRunning()) {
+        state.pauseTiming();
+        if (!makeTree(deletePath)) {
+            state.skipWithError("failed to build the tree to delete");
+            return;
+        }
+        state.resumeTiming();
+        
+        deleteTree(deletePath);
+    }
+    state.setItemsProcessed(state.getIterations() * treeEntryCount());
+    
+    if (isDirectory(deletePath))
+        state.skipWithError("the tree was not deleted");
+}
+
+static void registerDeleteBenchmarks(BenchRunner& runner) {
+    runner.add("Delete/stat_baseline/deleteFileOrDirectory", [](BenchState& state) {
+        benchDelete(state, statDeleteFileOrDirectory);
+    });
+    
+    runner.add("Delete/DirWalker/deleteFileOrDirectory", [](BenchState& state) {
+        benchDelete(state, deleteFileOrDirectory);
+    });
+}
+
+int main(int argc, char* argv[]) {
+    const std::string scratchPath = makeScratchDirectory("bench_dir_walker");
+    treePath = scratchPath + "tree/";
+    deletePath = scratchPath + "delete/";
+    
+    if (!makeTree(treePath)) {
+        fprintf(stderr, "Failed to build the tree in %s\n", scratchPath.c_str());
+        return 1;
+    }
+    
+    // Both versions must agree before their timings mean anything
+    std::vector<std::string> statFiles = statGetFilesListFromDirectory(treePath);
+    std::vector<std::string> walkerFiles = getFilesListFromDirectory(treePath);
+    std::sort(statFiles.begin(), statFiles.end());
+    std::sort(walkerFiles.begin(), walkerFiles.end());
+    if (statFiles != walkerFiles || statFiles.size() != FOLDER_COUNT * (FILES_PER_FOLDER + 1)) {
+        fprintf(stderr, "The stat and DirWalker listings differ\n");
+        return 1;
+    }
+    
+    BenchRunner runner;
+    registerListBenchmarks(runner);
+    registerDeleteBenchmarks(runner);
+    const int result = runner.run(argc, argv);
+    
+    removeScratchDirectory(scratchPath);
+    return result;
+}
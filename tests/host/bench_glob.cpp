@@ -0,0 +1,301 @@
+/********************************************************************************
+ * File: bench_glob.cpp
+ * Author: ppkantorski
+ * Description:
+ *   Benchmarks the wildcard listing of get_funcs.hpp against the recursive
+ *   version it replaced, on a synthetic tree of 80 mod folders laid out the
+ *   way packages address them. The recursive functions below are
+ *   getFilesListByWildcard() and getFilesListByWildcards() of the code
+ *   before GlobPattern, kept here as the reference. Before anything is
+ *   timed, both must return the same paths in the same order, and so must
+ *   the listing cache, before and after a file is added to a cached folder.
+ *
+ *   Glob   - paths per second matched by each pattern
+ *   Cached - the same through the directory listing cache, cold and warm
+ *
+ *   For the latest updates and contributions, visit the project's GitHub repository.
+ *   (GitHub Repository: https://github.com/ppkantorski/Ultrahand-Overlay)
+ *
+ *   Note: Please be aware that this notice cannot be altered or removed. It is a part
+ *   of the project's documentation and must remain intact.
+ *
+ *  Licensed under both GPLv2 and CC-BY-4.0
+ *  Copyright (c) 2024 ppkantorski
+ ********************************************************************************/
+
+#include "host.hpp"
+#include "bench.hpp"
+
+
+static constexpr size_t MOD_COUNT = 80;
+static constexpr size_t ROMFS_FOLDER_COUNT = 4;
+static constexpr size_t FILES_PER_FOLDER = 6;
+
+/**
+ * @brief A pattern relative to the tree, named for the benchmark.
+ */
+struct GlobCase {
+    std::string name;
+    std::string pattern;
+    size_t matchCount = 0;
+};
+
+static std::string treePath;
+static std::vector<GlobCase> globCases = {
+    {"mod_folders", "*/"},
+    {"romfs_arc", "*/romfs/*/*.arc"},
+    {"prefixed_romfs_arc", "mod_1*/romfs/data_*/*.arc"},
+    {"exefs_ips", "*/exefs/*.ips"}
+};
+
+/**
+ * @brief The single wildcard listing that getFilesListByWildcard() used to be.
+ */
+static std::vector<std::string> recursiveGetFilesListByWildcard(const std::string& pathPattern) {
+    std::string dirPath = "";
+    std::string wildcard = "";
+    
+    size_t wildcardPos = pathPattern.find('*');
+    if (wildcardPos != std::string::npos) {
+        size_t slashPos = pathPattern.rfind('/', wildcardPos);
+        
+        if (slashPos != std::string::npos) {
+            dirPath = pathPattern.substr(0, slashPos + 1);
+            wildcard = pathPattern.substr(slashPos + 1);
+        } else {
+            dirPath = "";
+            wildcard = pathPattern;
+        }
+    } else {
+        dirPath = pathPattern + "/";
+    }
+    
+    std::vector<std::string> fileList;
+    
+    bool isFolderWildcard = !wildcard.empty() && wildcard.back() == '/';
+    if (isFolderWildcard) {
+        wildcard = wildcard.substr(0, wildcard.size() - 1);  // Remove the trailing slash
+    }
+    
+    DirWalker walker(dirPath);
+    
+    std::string entryName, prefix, suffix;
+    wildcardPos = wildcard.find('*');
+    if (wildcardPos != std::string::npos) {
+        prefix = wildcard.substr(0, wildcardPos);
+        suffix = wildcard.substr(wildcardPos + 1);
+    }
+    
+    while (walker.next()) {
+        if (isFolderWildcard != walker.isDirectory())
+            continue;
+        entryName = walker.getName();
+        
+        if (isFolderWildcard) {
+            if (fnmatch(wildcard.c_str(), entryName.c_str(), FNM_NOESCAPE) == 0)
+                fileList.push_back(walker.getPath() + "/");
+        } else if (wildcardPos != std::string::npos) {
+            if (entryName.compare(0, prefix.size(), prefix) == 0 && entryName.size() >= suffix.size() &&
+                entryName.compare(entryName.size() - suffix.size(), suffix.size(), suffix) == 0)
+                fileList.push_back(walker.getPath());
+        } else if (fnmatch(wildcard.c_str(), entryName.c_str(), FNM_NOESCAPE) == 0) {
+            fileList.push_back(walker.getPath());
+        }
+    }
+    
+    return fileList;
+}
+
+/**
+ * @brief The recursive multi wildcard listing that getFilesListByWildcards() used to be.
+ */
+static std::vector<std::string> recursiveGetFilesListByWildcards(const std::string& pathPattern) {
+    std::vector<std::string> fileList;
+    
+    // Check if the pattern contains multiple wildcards
+    size_t wildcardPos = pathPattern.find('*');
+    if (wildcardPos != std::string::npos && pathPattern.find('*', wildcardPos + 1) != std::string::npos) {
+        std::string dirPath = "";
+        std::string wildcard = "";
+        
+        // Extract the directory path and the first wildcard
+        size_t slashPos = pathPattern.rfind('/', wildcardPos);
+        if (slashPos != std::string::npos) {
+            dirPath = pathPattern.substr(0, slashPos + 1);
+            wildcard = pathPattern.substr(slashPos + 1, wildcardPos - slashPos - 1);
+        } else {
+            dirPath = "";
+            wildcard = pathPattern.substr(0, wildcardPos);
+        }
+        
+        // Get the list of directories matching the first wildcard
+        std::vector<std::string> subDirs = recursiveGetFilesListByWildcard(dirPath + wildcard + "*/");
+        
+        std::string subPattern;
+        std::vector<std::string> subFileList;
+        
+        // Process each subdirectory recursively
+        for (const std::string& subDir : subDirs) {
+            subPattern = subDir + removeLeadingSlash(pathPattern.substr(wildcardPos + 1));
+            subFileList = recursiveGetFilesListByWildcards(subPattern);
+            fileList.insert(fileList.end(), subFileList.begin(), subFileList.end());
+        }
+    } else {
+        // Only one wildcard present, use getFilesListByWildcard directly
+        fileList = recursiveGetFilesListByWildcard(pathPattern);
+    }
+    
+    return fileList;
+}
+
+/**
+ * @brief Creates MOD_COUNT mod folders, each with romfs folders of .arc and .bin files and an exefs folder.
+ */
+static bool makeTree(const std::string& rootPath) {
+    namespace fs = std::filesystem;
+    std::error_code error;
+    
+    std::string modPath, folderPath;
+    for (size_t mod = 0; mod < MOD_COUNT; ++mod) {
+        modPath = rootPath + "mod_" + std::to_string(mod) + "/";
+        for (size_t folder = 0; folder < ROMFS_FOLDER_COUNT; ++folder) {
+            folderPath = modPath + "romfs/data_" + std::to_string(folder) + "/";
+            if (!fs::create_directories(folderPath, error) && error)
+                return false;
+            
+            for (size_t file = 0; file < FILES_PER_FOLDER; ++file) {
+                if (!writeHostFile(folderPath + "file_" + std::to_string(file) + ((file % 2 == 0) ? ".arc" : ".bin"), "data"))
+                    return false;
+            }
+        }
+        
+        if (!fs::create_directories(modPath + "exefs", error) && error)
+            return false;
+        if (!writeHostFile(modPath + "exefs/main.ips", "data") || !writeHostFile(modPath + "info.ini", "data"))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Checks that both versions return the same paths in the same order, and counts them.
+ *
+ * @return The name of the first case that differs, empty if all agree.
+ */
+static std::string checkGlobs() {
+    for (auto& globCase : globCases) {
+        const std::vector<std::string> expected = recursiveGetFilesListByWildcards(treePath + globCase.pattern);
+        if (expected.empty() || getFilesListByWildcards(treePath + globCase.pattern) != expected)
+            return globCase.name;
+        globCase.matchCount = expected.size();
+    }
+    return "";
+}
+
+/**
+ * @brief Checks the cached listings against the uncached ones, also after a cached folder changes.
+ *
+ * @return The name of the first check that failed, empty if all passed.
+ */
+static std::string checkListingCache() {
+    clearDirectoryListingCache();
+    for (const auto& globCase : globCases) {
+        const std::vector<std::string> expected = getFilesListByWildcards(treePath + globCase.pattern);
+        for (const char* pass : {"cold", "warm"}) {
+            if (getFilesListByWildcards(treePath + globCase.pattern, true) != expected)
+                return globCase.name + " " + pass;
+        }
+    }
+    
+    // Ultrahand's own file operations invalidate what they touch
+    const std::string pathPattern = treePath + "*/exefs/*.ips";
+    const std::string addedPath = treePath + "mod_0/exefs/added.ips";
+    const size_t matchCount = getFilesListByWildcards(pathPattern, true).size();
+    if (!writeHostFile(addedPath, "data"))
+        return "writing " + addedPath;
+    invalidateDirectoryListing(addedPath);
+    if (getFilesListByWildcards(pathPattern, true).size() != matchCount + 1)
+        return "added file";
+    
+    remove(addedPath.c_str());
+    invalidateDirectoryListing(addedPath);
+    if (getFilesListByWildcards(pathPattern, true).size() != matchCount)
+        return "removed file";
+    return "";
+}
+
+static void registerGlobBenchmarks(BenchRunner& runner) {
+    for (const auto& globCase : globCases) {
+        runner.add("Glob/recursive_baseline/" + globCase.name, [&globCase](BenchState& state) {
+            const std::string pathPattern = treePath + globCase.pattern;
+            while (state.keepRunning())
+                doNotOptimize(recursiveGetFilesListByWildcards(pathPattern).size());
+            state.setItemsProcessed(state.getIterations() * globCase.matchCount);
+        });
+        
+        runner.add("Glob/GlobPattern/" + globCase.name, [&globCase](BenchState& state) {
+            const std::string pathPattern = treePath + globCase.pattern;
+            while (state.keepRunning())
+                doNotOptimize(getFilesListByWildcards(pathPattern).size());
+            state.setItemsProcessed(state.getIterations() * globCase.matchCount);
+        });
+    }
+}
+
+static void registerCacheBenchmarks(BenchRunner& runner) {
+    for (const auto& globCase : globCases) {
+        runner.add("Cached/GlobPattern_cold/" + globCase.name, [&globCase](BenchState& state) {
+            const std::string pathPattern = treePath + globCase.pattern;
+            while (state.keepRunning()) {
+                state.pauseTiming();
+                clearDirectoryListingCache();
+                state.resumeTiming();
+                
+                doNotOptimize(getFilesListByWildcards(pathPattern, true).size());
+            }
+            state.setItemsProcessed(state.getIterations() * globCase.matchCount);
+        });
+        
+        runner.add("Cached/GlobPattern_warm/" + globCase.name, [&globCase](BenchState& state) {
+            const std::string pathPattern = treePath + globCase.pattern;
+            getFilesListByWildcards(pathPattern, true);
+            while (state.keepRunning())
+                doNotOptimize(getFilesListByWildcards(pathPattern, true).size());
+            state.setItemsProcessed(state.getIterations() * globCase.matchCount);
+        });
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const std::string scratchPath = makeScratchDirectory("bench_glob");
+    treePath = scratchPath + "mods/";
+    
+    if (!makeTree(treePath)) {
+        fprintf(stderr, "Failed to build the tree in %s\n", scratchPath.c_str());
+        removeScratchDirectory(scratchPath);
+        return 1;
+    }
+    
+    // Both versions must agree before their timings mean anything
+    std::string failedCase = checkGlobs();
+    if (!failedCase.empty()) {
+        fprintf(stderr, "GlobPattern differs from the recursive listing: %s\n", failedCase.c_str());
+        removeScratchDirectory(scratchPath);
+        return 1;
+    }
+    
+    failedCase = checkListingCache();
+    if (!failedCase.empty()) {
+        fprintf(stderr, "The cached listing differs from the uncached one: %s\n", failedCase.c_str());
+        removeScratchDirectory(scratchPath);
+        return 1;
+    }
+    
+    BenchRunner runner;
+    registerGlobBenchmarks(runner);
+    registerCacheBenchmarks(runner);
+    const int result = runner.run(argc, argv);
+    
+    removeScratchDirectory(scratchPath);
+    return result;
+}
@@ -0,0 +1,365 @@
+/********************************************************************************
+ * File: bench_hex.cpp
+ * Author: ppkantorski
+ * Description:
+ *   Benchmarks the hex search of hex_funcs.hpp against the per-position memcmp
+ *   scan it replaced, on a 16 MB file of seeded random bytes with patterns
+ *   planted across read chunk boundaries. The memcmp scan below is the loop of
+ *   findHexDataOffsets() before HexSearcher, with the chunk tail carried over
+ *   so that it finds matches across chunks and can serve as the reference.
+ *
+ *   Before anything is timed, every search is checked against the reference:
+ *   exact, short and "??" wildcard patterns, through the mapped file and
+ *   through the buffered reader, stopping after N matches, and the one-pass
+ *   anchor search of HexMultiSearcher.
+ *
+ *   Search  - bytes per second searched for a single pattern
+ *   Anchors - bytes per second resolving 8 anchors, one scan each or one pass
+ *   Reader  - bytes per second read through the BinaryReader buffer from a
+ *             stream without a descriptor, as on the console, by buffer size,
+ *             with the read calls as items
+ *   Stop    - bytes per second of the file searched for all matches or
+ *             only the first, which ends the read at the first chunk
+ *
+ *   For the latest updates and contributions, visit the project's GitHub repository.
+ *   (GitHub Repository: https://github.com/ppkantorski/Ultrahand-Overlay)
+ *
+ *   Note: Please be aware that this notice cannot be altered or removed. It is a part
+ *   of the project's documentation and must remain intact.
+ *
+ *  Licensed under both GPLv2 and CC-BY-4.0
+ *  Copyright (c) 2024 ppkantorski
+ ********************************************************************************/
+
+#include "host.hpp"
+#include "bench.hpp"
+#include <fcntl.h>
+
+
+static constexpr size_t TARGET_SIZE = 16 * 1024 * 1024;
+static constexpr size_t REFERENCE_CHUNK_SIZE = 65536;
+static constexpr size_t ANCHOR_COUNT = 8;
+
+/**
+ * @brief A pattern as the reference sees it, next to the hex string the searchers parse.
+ */
+struct SearchCase {
+    std::string name;
+    std::string hexData;
+    std::vector<unsigned char> bytes;
+    std::vector<unsigned char> mask; // 0x00 where the hex string has "??"
+};
+
+static std::string targetPath;
+static std::string targetContent;
+static std::vector<SearchCase> searchCases, anchorCases;
+
+/**
+ * @brief The chunked per-position memcmp scan that findHexDataOffsets() used to be.
+ *
+ * Each chunk starts with the last pattern length - 1 bytes of the previous one, which the
+ * original loop did not do, and masked bytes are compared through the mask.
+ */
+static std::vector<u64> memcmpFindHexDataOffsets(const std::string& filePath, const SearchCase& searchCase, size_t maxMatches = 0) {
+    std::vector<u64> offsets;
+    FILE* file = fopen(filePath.c_str(), "rb");
+    if (!file)
+        return offsets;
+    
+    const size_t length = searchCase.bytes.size();
+    const bool masked = std::find(searchCase.mask.begin(), searchCase.mask.end(), 0x00) != searchCase.mask.end();
+    std::vector<unsigned char> buffer(REFERENCE_CHUNK_SIZE + length);
+    size_t carry = 0, bytesRead, filled, j;
+    u64 chunkOffset = 0;
+    
+    while ((bytesRead = fread(buffer.data() + carry, 1, REFERENCE_CHUNK_SIZE, file)) > 0) {
+        filled = carry + bytesRead;
+        for (size_t i = 0; i + length <= filled; ++i) {
+            if (masked) {
+                for (j = 0; j < length && (buffer[i + j] & searchCase.mask[j]) == searchCase.bytes[j]; ++j) {}
+                if (j < length)
+                    continue;
+            } else if (std::memcmp(buffer.data() + i, searchCase.bytes.data(), length) != 0)
+                continue;
+            
+            offsets.push_back(chunkOffset + i);
+            if (maxMatches != 0 && offsets.size() == maxMatches) {
+                fclose(file);
+                return offsets;
+            }
+        }
+        
+        carry = std::min(filled, length - 1);
+        std::memmove(buffer.data(), buffer.data() + filled - carry, carry);
+        chunkOffset += filled - carry;
+    }
+    fclose(file);
+    return offsets;
+}
+
+/**
+ * @brief Builds a search case from raw bytes, masking the listed byte positions.
+ */
+static SearchCase makeSearchCase(const std::string& name, const std::vector<unsigned char>& bytes, const std::vector<size_t>& wildcards = {}) {
+    SearchCase searchCase{name, "", bytes, std::vector<unsigned char>(bytes.size(), 0xFF)};
+    for (size_t position : wildcards) {
+        searchCase.bytes[position] = 0x00;
+        searchCase.mask[position] = 0x00;
+    }
+    
+    // Spaced the way packages write them, "DE AD ?? EF"
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        if (i > 0)
+            searchCase.hexData += ' ';
+        if (searchCase.mask[i] == 0x00)
+            searchCase.hexData += "??";
+        else
+            appendHexString(searchCase.hexData, &bytes[i], 1);
+    }
+    return searchCase;
+}
+
+/**
+ * @brief Fills the target with seeded random bytes and plants the exact pattern across chunk boundaries.
+ */
+static void makeTarget() {
+    targetContent.resize(TARGET_SIZE);
+    uint32_t state = 0x2545F491;
+    for (auto& byte : targetContent) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        byte = static_cast<char>(state);
+    }
+    
+    const std::vector<unsigned char> planted = {0xDE, 0xAD, 0xBE, 0xEF, 0xCA, 0xFE, 0xF0, 0x0D, 0x13, 0x37, 0xC0, 0xDE};
+    for (size_t boundary = 65536; boundary < TARGET_SIZE; boundary += 65536 * 3) {
+        // Starting 5 bytes before a boundary of both the 64 KB and the 256 KB buffers
+        std::memcpy(&targetContent[boundary - 5], planted.data(), planted.size());
+    }
+    std::memcpy(&targetContent[TARGET_SIZE - planted.size()], planted.data(), planted.size()); // Ends the file
+    
+    searchCases.push_back(makeSearchCase("exact", planted));
+    searchCases.push_back(makeSearchCase("wildcard", planted, {2, 3, 9}));
+    searchCases.push_back(makeSearchCase("short", {0x4E, 0x4F}));
+    searchCases.push_back(makeSearchCase("short_wildcard", {0x4E, 0x00, 0x4F}, {1}));
+    
+    // Anchors are taken from the data, one of them with a wildcard in its first two bytes
+    for (size_t i = 0; i < ANCHOR_COUNT; ++i) {
+        const size_t offset = TARGET_SIZE / ANCHOR_COUNT * i + 4099 * (i + 1);
+        const std::vector<unsigned char> bytes(targetContent.begin() + offset, targetContent.begin() + offset + 10);
+        anchorCases.push_back(makeSearchCase("anchor_" + std::to_string(i), bytes, (i == 3) ? std::vector<size_t>{1} : std::vector<size_t>{}));
+    }
+}
+
+/**
+ * @brief Searches an in-memory copy of the target, which has no descriptor and is read through the buffer.
+ */
+static std::vector<u64> findBuffered(const SearchCase& searchCase, size_t maxMatches = 0) {
+    FILE* file = fmemopen(&targetContent[0], targetContent.size(), "rb");
+    std::vector<u64> offsets = findHexDataOffsetsF(file, searchCase.hexData, maxMatches);
+    if (file)
+        fclose(file);
+    return offsets;
+}
+
+static ssize_t readDescriptor(void* cookie, char* buffer, size_t size) {
+    return read(static_cast<int>(reinterpret_cast<intptr_t>(cookie)), buffer, size);
+}
+
+static int closeDescriptor(void* cookie) {
+    return close(static_cast<int>(reinterpret_cast<intptr_t>(cookie)));
+}
+
+/**
+ * @brief Opens a file as a stream without a descriptor.
+ *
+ * BinaryReader cannot map it and reads it through its own buffer, which is how every file
+ * is read on the console. Reads larger than the stream buffer go straight to read().
+ */
+static FILE* openUnmapped(const std::string& filePath) {
+    const int descriptor = open(filePath.c_str(), O_RDONLY);
+    if (descriptor < 0)
+        return nullptr;
+    
+    FILE* file = fopencookie(reinterpret_cast<void*>(static_cast<intptr_t>(descriptor)), "rb",
+        cookie_io_functions_t{readDescriptor, nullptr, nullptr, closeDescriptor});
+    if (!file) {
+        close(descriptor);
+        return nullptr;
+    }
+    return file;
+}
+
+/**
+ * @brief Checks every searcher against the reference.
+ *
+ * @return The name of the first check that failed, empty if all passed.
+ */
+static std::string checkSearches() {
+    for (const auto& searchCase : searchCases) {
+        const std::vector<u64> expected = memcmpFindHexDataOffsets(targetPath, searchCase);
+        if (expected.empty())
+            return searchCase.name + ": the reference found nothing";
+        
+        if (findHexDataOffsets(targetPath, searchCase.hexData) != expected)
+            return searchCase.name + ": findHexDataOffsets";
+        
+        for (size_t bufferSize : {binaryReaderMinBufferSize, size_t(262144)}) {
+            setBinaryReaderBufferSize(bufferSize);
+            if (findBuffered(searchCase) != expected)
+                return searchCase.name + ": buffered findHexDataOffsetsF with " + std::to_string(bufferSize / 1024) + " KB chunks";
+        }
+        
+        if (findHexDataOffsets(targetPath, searchCase.hexData, 3) != memcmpFindHexDataOffsets(targetPath, searchCase, 3))
+            return searchCase.name + ": findHexDataOffsets stopping after 3 matches";
+        
+        for (size_t maxMatches : {size_t(0), size_t(1)}) {
+            FILE* file = openUnmapped(targetPath);
+            const bool unmappedMatches = (findHexDataOffsetsF(file, searchCase.hexData, maxMatches) ==
+                ((maxMatches == 0) ? expected : std::vector<u64>{expected[0]}));
+            if (file)
+                fclose(file);
+            if (!unmappedMatches)
+                return searchCase.name + ": findHexDataOffsetsF on a stream without a descriptor, " + std::to_string(maxMatches) + " matches";
+        }
+    }
+    
+    HexMultiSearcher searcher;
+    for (const auto& anchorCase : anchorCases)
+        searcher.addPattern(HexPattern(anchorCase.hexData));
+    
+    std::vector<u64> firstOffsets(anchorCases.size(), UINT64_MAX);
+    FILE* file = fopen(targetPath.c_str(), "rb");
+    searcher.searchFile(file, [&](size_t index, u64 offset) {
+        if (firstOffsets[index] == UINT64_MAX)
+            firstOffsets[index] = offset;
+        return true;
+    });
+    if (file)
+        fclose(file);
+    
+    for (size_t i = 0; i < anchorCases.size(); ++i) {
+        const std::vector<u64> expected = memcmpFindHexDataOffsets(targetPath, anchorCases[i], 1);
+        if (expected.empty() || firstOffsets[i] != expected[0])
+            return anchorCases[i].name + ": HexMultiSearcher";
+    }
+    return "";
+}
+
+static void registerSearchBenchmarks(BenchRunner& runner) {
+    for (const auto& searchCase : searchCases) {
+        runner.add("Search/memcmp_baseline/" + searchCase.name + "_16MB", [&searchCase](BenchState& state) {
+            while (state.keepRunning())
+                doNotOptimize(memcmpFindHexDataOffsets(targetPath, searchCase).size());
+            state.setBytesProcessed(state.getIterations() * TARGET_SIZE);
+        });
+        
+        runner.add("Search/findHexDataOffsets/" + searchCase.name + "_16MB", [&searchCase](BenchState& state) {
+            while (state.keepRunning())
+                doNotOptimize(findHexDataOffsets(targetPath, searchCase.hexData).size());
+            state.setBytesProcessed(state.getIterations() * TARGET_SIZE);
+        });
+    }
+}
+
+static void registerAnchorBenchmarks(BenchRunner& runner) {
+    runner.add("Anchors/findHexDataOffsets/8_scans", [](BenchState& state) {
+        while (state.keepRunning()) {
+            for (const auto& anchorCase : anchorCases)
+                doNotOptimize(findHexDataOffsets(targetPath, anchorCase.hexData, 1).size());
+        }
+        state.setBytesProcessed(state.getIterations() * TARGET_SIZE);
+    });
+    
+    runner.add("Anchors/HexMultiSearcher/1_pass", [](BenchState& state) {
+        HexMultiSearcher searcher;
+        for (const auto& anchorCase : anchorCases)
+            searcher.addPattern(HexPattern(anchorCase.hexData));
+        
+        std::vector<bool> found(anchorCases.size());
+        size_t remaining;
+        while (state.keepRunning()) {
+            std::fill(found.begin(), found.end(), false);
+            remaining = found.size();
+            
+            FILE* file = fopen(targetPath.c_str(), "rb");
+            searcher.searchFile(file, [&](size_t index, u64) {
+                if (!found[index]) {
+                    found[index] = true;
+                    --remaining;
+                }
+                return remaining > 0;
+            });
+            fclose(file);
+        }
+        state.setBytesProcessed(state.getIterations() * TARGET_SIZE);
+    });
+}
+
+static void registerReaderBenchmarks(BenchRunner& runner) {
+    // 4 KB is the cluster size most reads used to be, 64 KB the old hexBufferSize
+    for (size_t bufferSize : {size_t(4096), size_t(65536), size_t(262144), size_t(1048576)}) {
+        runner.add("Reader/BinaryReader/" + std::to_string(bufferSize / 1024) + "KB_buffer", [bufferSize](BenchState& state) {
+            uint64_t bytesSeen = 0, readCalls = 0;
+            while (state.keepRunning()) {
+                FILE* file = openUnmapped(targetPath);
+                BinaryReader reader(file, bufferSize);
+                reader.forEachChunk(11, [&](const unsigned char* data, size_t size, u64, bool) {
+                    bytesSeen += size + data[0];
+                    return true;
+                });
+                readCalls += reader.getStats().readCalls;
+                if (file)
+                    fclose(file);
+            }
+            doNotOptimize(bytesSeen);
+            state.setBytesProcessed(state.getIterations() * TARGET_SIZE);
+            state.setItemsProcessed(readCalls);
+        });
+    }
+}
+
+static void registerStopBenchmarks(BenchRunner& runner) {
+    for (size_t maxMatches : {size_t(0), size_t(1)}) {
+        runner.add(std::string("Stop/findHexDataOffsetsF/") + ((maxMatches == 0) ? "all_matches" : "first_match"), [maxMatches](BenchState& state) {
+            while (state.keepRunning()) {
+                FILE* file = openUnmapped(targetPath);
+                doNotOptimize(findHexDataOffsetsF(file, searchCases[0].hexData, maxMatches).size());
+                if (file)
+                    fclose(file);
+            }
+            state.setBytesProcessed(state.getIterations() * TARGET_SIZE);
+        });
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const std::string scratchPath = makeScratchDirectory("bench_hex");
+    targetPath = scratchPath + "main";
+    
+    makeTarget();
+    if (!writeHostFile(targetPath, targetContent)) {
+        fprintf(stderr, "Failed to write %s\n", targetPath.c_str());
+        return 1;
+    }
+    
+    // The searches must agree with the reference before their timings mean anything
+    const std::string failedCheck = checkSearches();
+    setBinaryReaderBufferSize(262144);
+    if (!failedCheck.empty()) {
+        fprintf(stderr, "Search differs from the memcmp reference: %s\n", failedCheck.c_str());
+        removeScratchDirectory(scratchPath);
+        return 1;
+    }
+    
+    BenchRunner runner;
+    registerSearchBenchmarks(runner);
+    registerAnchorBenchmarks(runner);
+    registerReaderBenchmarks(runner);
+    registerStopBenchmarks(runner);
+    const int result = runner.run(argc, argv);
+    
+    removeScratchDirectory(scratchPath);
+    return result;
+}
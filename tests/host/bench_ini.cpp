@@ -0,0 +1,237 @@
+/********************************************************************************
+ * File: bench_ini.cpp
+ * Author: ppkantorski
+ * Description:
+ *   Throughput benchmarks for the INI layer of ini_funcs.hpp, which the
+ *   libtesla hlp::ini settings helpers share through parseIni(). Inputs are
+ *   the example package.ini files and the bundled themes, plus a synthetic
+ *   1 MB package.ini.
+ *
+ *   Parse   - MB/s of the whole-file parsers
+ *   Lookup  - key lookups per second on a parsed theme
+ *   Rewrite - single key rewrites per second, in memory and on disk
+ *
+ *   For the latest updates and contributions, visit the project's GitHub repository.
+ *   (GitHub Repository: https://github.com/ppkantorski/Ultrahand-Overlay)
+ *
+ *   Note: Please be aware that this notice cannot be altered or removed. It is a part
+ *   of the project's documentation and must remain intact.
+ *
+ *  Licensed under both GPLv2 and CC-BY-4.0
+ *  Copyright (c) 2024 ppkantorski
+ ********************************************************************************/
+
+#include "host.hpp"
+#include "bench.hpp"
+
+
+struct SeedFile {
+    std::string path;
+    std::string content;
+};
+
+static std::vector<SeedFile> seedFiles;
+static std::string syntheticIni;
+static std::string themeContent;
+static std::vector<std::pair<std::string, std::string>> themeKeys; // (section, key) of every theme entry
+static std::string scratchPath;
+
+/**
+ * @brief Runs a parser over every seed file per iteration.
+ */
+template <typename Parser>
+static void benchSeeds(BenchState& state, Parser&& parser) {
+    uint64_t seedBytes = 0;
+    for (const auto& seedFile : seedFiles)
+        seedBytes += seedFile.content.size();
+    if (seedBytes == 0) {
+        state.skipWithError("no seed files found under " REPO_ROOT);
+        return;
+    }
+    
+    while (state.keepRunning()) {
+        for (const auto& seedFile : seedFiles)
+            parser(seedFile);
+    }
+    state.setBytesProcessed(state.getIterations() * seedBytes);
+}
+
+static void registerParseBenchmarks(BenchRunner& runner) {
+    runner.add("Parse/IniTable/seeds", [](BenchState& state) {
+        benchSeeds(state, [](const SeedFile& seedFile) {
+            IniTable iniTable;
+            iniTable.parse(seedFile.content);
+            doNotOptimize(iniTable.getEntries().size());
+        });
+    });
+    
+    runner.add("Parse/parseIni/seeds", [](BenchState& state) {
+        benchSeeds(state, [](const SeedFile& seedFile) {
+            doNotOptimize(parseIni(seedFile.content).size());
+        });
+    });
+    
+    runner.add("Parse/IniDocument/seeds", [](BenchState& state) {
+        benchSeeds(state, [](const SeedFile& seedFile) {
+            IniDocument iniDocument;
+            iniDocument.loadFromString(seedFile.content);
+            doNotOptimize(iniDocument.empty());
+        });
+    });
+    
+    runner.add("Parse/getParsedDataFromIniFile/seeds", [](BenchState& state) {
+        benchSeeds(state, [](const SeedFile& seedFile) {
+            doNotOptimize(getParsedDataFromIniFile(seedFile.path).size());
+        });
+    });
+    
+    runner.add("Parse/parseSectionsFromIni/seeds", [](BenchState& state) {
+        benchSeeds(state, [](const SeedFile& seedFile) {
+            doNotOptimize(parseSectionsFromIni(seedFile.path).size());
+        });
+    });
+    
+    runner.add("Parse/IniTable/synthetic_1MB", [](BenchState& state) {
+        while (state.keepRunning()) {
+            IniTable iniTable;
+            iniTable.parse(syntheticIni);
+            doNotOptimize(iniTable.getEntries().size());
+        }
+        state.setBytesProcessed(state.getIterations() * syntheticIni.size());
+    });
+    
+    runner.add("Parse/IniDocument/synthetic_1MB", [](BenchState& state) {
+        while (state.keepRunning()) {
+            IniDocument iniDocument;
+            iniDocument.loadFromString(syntheticIni);
+            doNotOptimize(iniDocument.empty());
+        }
+        state.setBytesProcessed(state.getIterations() * syntheticIni.size());
+    });
+}
+
+static void registerLookupBenchmarks(BenchRunner& runner) {
+    runner.add("Lookup/IniTable/theme", [](BenchState& state) {
+        if (themeKeys.empty()) {
+            state.skipWithError("no theme keys");
+            return;
+        }
+        IniTable iniTable;
+        iniTable.parse(themeContent);
+        
+        size_t keyIndex = 0;
+        std::string_view value;
+        while (state.keepRunning()) {
+            const auto& sectionKey = themeKeys[keyIndex];
+            doNotOptimize(iniTable.getValue(sectionKey.first, sectionKey.second, value));
+            keyIndex = (keyIndex + 1 == themeKeys.size()) ? 0 : keyIndex + 1;
+        }
+        state.setItemsProcessed(state.getIterations());
+    });
+    
+    runner.add("Lookup/IniDocument/theme", [](BenchState& state) {
+        if (themeKeys.empty()) {
+            state.skipWithError("no theme keys");
+            return;
+        }
+        IniDocument iniDocument;
+        iniDocument.loadFromString(themeContent);
+        
+        size_t keyIndex = 0;
+        std::string value;
+        while (state.keepRunning()) {
+            const auto& sectionKey = themeKeys[keyIndex];
+            doNotOptimize(iniDocument.getValue(sectionKey.first, sectionKey.second, value));
+            keyIndex = (keyIndex + 1 == themeKeys.size()) ? 0 : keyIndex + 1;
+        }
+        state.setItemsProcessed(state.getIterations());
+    });
+    
+    runner.add("Lookup/parseValueFromIniSection/theme", [](BenchState& state) {
+        const std::string themePath = scratchPath + "lookup_theme.ini";
+        if (themeKeys.empty() || !writeHostFile(themePath, themeContent)) {
+            state.skipWithError("cannot prepare " + themePath);
+            return;
+        }
+        invalidateIniCache(themePath);
+        
+        size_t keyIndex = 0;
+        while (state.keepRunning()) {
+            const auto& sectionKey = themeKeys[keyIndex];
+            doNotOptimize(parseValueFromIniSection(themePath, sectionKey.first, sectionKey.second).size());
+            keyIndex = (keyIndex + 1 == themeKeys.size()) ? 0 : keyIndex + 1;
+        }
+        state.setItemsProcessed(state.getIterations());
+        
+        size_t hits, misses;
+        getIniCacheStats(hits, misses);
+        state.setLabel("cache " + std::to_string(hits) + " hits, " + std::to_string(misses) + " misses");
+    });
+}
+
+static void registerRewriteBenchmarks(BenchRunner& runner) {
+    runner.add("Rewrite/IniDocument/theme", [](BenchState& state) {
+        if (themeKeys.empty()) {
+            state.skipWithError("no theme keys");
+            return;
+        }
+        IniDocument iniDocument;
+        iniDocument.loadFromString(themeContent);
+        
+        size_t keyIndex = 0;
+        uint64_t bytesWritten = 0;
+        while (state.keepRunning()) {
+            const auto& sectionKey = themeKeys[keyIndex];
+            iniDocument.setValue(sectionKey.first, sectionKey.second, (state.getIterations() & 1) ? "#ffffff" : "#000000");
+            const std::string content = iniDocument.toString();
+            bytesWritten += content.size();
+            doNotOptimize(content.size());
+            keyIndex = (keyIndex + 1 == themeKeys.size()) ? 0 : keyIndex + 1;
+        }
+        state.setItemsProcessed(state.getIterations());
+        state.setBytesProcessed(bytesWritten);
+    });
+    
+    runner.add("Rewrite/setIniFileValue/theme", [](BenchState& state) {
+        const std::string themePath = scratchPath + "rewrite_theme.ini";
+        if (themeKeys.empty() || !writeHostFile(themePath, themeContent)) {
+            state.skipWithError("cannot prepare " + themePath);
+            return;
+        }
+        
+        size_t keyIndex = 0;
+        while (state.keepRunning()) {
+            const auto& sectionKey = themeKeys[keyIndex];
+            setIniFileValue(themePath, sectionKey.first, sectionKey.second, (state.getIterations() & 1) ? "#ffffff" : "#000000");
+            keyIndex = (keyIndex + 1 == themeKeys.size()) ? 0 : keyIndex + 1;
+        }
+        state.setItemsProcessed(state.getIterations());
+    });
+}
+
+int main(int argc, char* argv[]) {
+    for (const auto& seedPath : getSeedIniFiles())
+        seedFiles.push_back({seedPath, readHostFile(seedPath)});
+    syntheticIni = makeSyntheticIni(1024 * 1024);
+    
+    // The largest bundled theme drives the lookup and rewrite benchmarks
+    for (const auto& seedFile : seedFiles) {
+        if (seedFile.path.find("/themes/") != std::string::npos && seedFile.content.size() > themeContent.size())
+            themeContent = seedFile.content;
+    }
+    IniTable themeTable;
+    themeTable.parse(themeContent);
+    for (const auto& entry : themeTable.getEntries())
+        themeKeys.emplace_back(entry.section, entry.key);
+    
+    scratchPath = makeScratchDirectory("bench_ini");
+    
+    BenchRunner runner;
+    registerParseBenchmarks(runner);
+    registerLookupBenchmarks(runner);
+    registerRewriteBenchmarks(runner);
+    const int result = runner.run(argc, argv);
+    
+    removeScratchDirectory(scratchPath);
+    return result;
+}
@@ -0,0 +1,172 @@
+/********************************************************************************
+ * File: bench_ini_stream.cpp
+ * Author: ppkantorski
+ * Description:
+ *   Benchmarks the streaming INI reader of ini_stream.hpp against the line
+ *   readers it replaced, on a synthetic 1 MB package.ini. The fgets readers
+ *   below are the parseSectionsFromIni() and parseValueFromIniSectionF() of
+ *   the code before the stream reader, kept here as the reference.
+ *
+ *   Sections - listing all section headers, as the hekate loaders do
+ *   Stream   - reporting every header and key-value pair
+ *   Value    - looking up one key, near the start and at the end of the file
+ *
+ *   For the latest updates and contributions, visit the project's GitHub repository.
+ *   (GitHub Repository: https://github.com/ppkantorski/Ultrahand-Overlay)
+ *
+ *   Note: Please be aware that this notice cannot be altered or removed. It is a part
+ *   of the project's documentation and must remain intact.
+ *
+ *  Licensed under both GPLv2 and CC-BY-4.0
+ *  Copyright (c) 2024 ppkantorski
+ ********************************************************************************/
+
+#include "host.hpp"
+#include "bench.hpp"
+
+
+static std::string iniPath;
+static uint64_t iniSize = 0;
+static std::string firstSection, lastSection;
+
+/**
+ * @brief The fgets based section listing that parseSectionsFromIni() used to be.
+ */
+static std::vector<std::string> fgetsParseSections(const std::string& filePath) {
+    std::vector<std::string> sections;
+    
+    FILE* file = fopen(filePath.c_str(), "r");
+    if (file == nullptr)
+        return sections;
+    
+    char line[BufferSize];
+    std::string trimmedLine;
+    while (fgets(line, sizeof(line), file)) {
+        trimmedLine = trim(std::string(line));
+        if (!trimmedLine.empty() && trimmedLine[0] == '[' && trimmedLine.back() == ']')
+            sections.push_back(trimmedLine.substr(1, trimmedLine.size() - 2));
+    }
+    
+    fclose(file);
+    return sections;
+}
+
+/**
+ * @brief The fgets based key lookup that parseValueFromIniSectionF() used to be.
+ */
+static std::string fgetsParseValue(FILE* file, const std::string& sectionName, const std::string& keyName) {
+    std::string value = "";
+    std::string currentSection = "";
+    char line[BufferSize];
+    std::string trimmedLine;
+    size_t delimiterPos;
+    
+    while (fgets(line, sizeof(line), file)) {
+        trimmedLine = trim(std::string(line));
+        if (trimmedLine.empty())
+            continue;
+        
+        if (trimmedLine[0] == '[' && trimmedLine.back() == ']')
+            currentSection = trimmedLine.substr(1, trimmedLine.size() - 2);
+        else if (currentSection == sectionName) {
+            delimiterPos = trimmedLine.find('=');
+            if (delimiterPos != std::string::npos && trim(trimmedLine.substr(0, delimiterPos)) == keyName) {
+                value = trim(trimmedLine.substr(delimiterPos + 1));
+                break;
+            }
+        }
+    }
+    return value;
+}
+
+static void registerSectionBenchmarks(BenchRunner& runner) {
+    runner.add("Sections/fgets_baseline/synthetic_1MB", [](BenchState& state) {
+        while (state.keepRunning())
+            doNotOptimize(fgetsParseSections(iniPath).size());
+        state.setBytesProcessed(state.getIterations() * iniSize);
+    });
+    
+    runner.add("Sections/readIniSections/synthetic_1MB", [](BenchState& state) {
+        while (state.keepRunning()) {
+            size_t sectionCount = 0;
+            readIniSections(iniPath.c_str(), [&sectionCount](std::string_view) {
+                ++sectionCount;
+                return true;
+            });
+            doNotOptimize(sectionCount);
+        }
+        state.setBytesProcessed(state.getIterations() * iniSize);
+    });
+    
+    runner.add("Sections/parseSectionsFromIni/synthetic_1MB", [](BenchState& state) {
+        while (state.keepRunning())
+            doNotOptimize(parseSectionsFromIni(iniPath).size());
+        state.setBytesProcessed(state.getIterations() * iniSize);
+    });
+    
+    runner.add("Stream/readIniStream/synthetic_1MB", [](BenchState& state) {
+        while (state.keepRunning()) {
+            size_t pairCount = 0;
+            readIniStream(iniPath.c_str(),
+                [](std::string_view) { return true; },
+                [&pairCount](std::string_view, std::string_view, std::string_view) {
+                    ++pairCount;
+                    return true;
+                });
+            doNotOptimize(pairCount);
+        }
+        state.setBytesProcessed(state.getIterations() * iniSize);
+    });
+}
+
+/**
+ * @brief Looks up the "mode" key of a section with both the reference and the stream reader.
+ */
+static void registerValueBenchmarks(BenchRunner& runner, const std::string& name, const std::string& sectionName) {
+    runner.add("Value/fgets_baseline/" + name, [sectionName](BenchState& state) {
+        while (state.keepRunning()) {
+            FILE* file = fopen(iniPath.c_str(), "r");
+            doNotOptimize(fgetsParseValue(file, sectionName, "mode").size());
+            fclose(file);
+        }
+        state.setItemsProcessed(state.getIterations());
+    });
+    
+    runner.add("Value/parseValueFromIniSectionF/" + name, [sectionName](BenchState& state) {
+        while (state.keepRunning()) {
+            FILE* file = fopen(iniPath.c_str(), "rb");
+            doNotOptimize(parseValueFromIniSectionF(file, iniPath, sectionName, "mode").size());
+            fclose(file);
+        }
+        state.setItemsProcessed(state.getIterations());
+    });
+}
+
+int main(int argc, char* argv[]) {
+    const std::string scratchPath = makeScratchDirectory("bench_ini_stream");
+    iniPath = scratchPath + "synthetic.ini";
+    
+    const std::string content = makeSyntheticIni(1024 * 1024);
+    if (!writeHostFile(iniPath, content)) {
+        fprintf(stderr, "Failed to write %s\n", iniPath.c_str());
+        return 1;
+    }
+    iniSize = content.size();
+    
+    const std::vector<std::string> sections = parseSectionsFromIni(iniPath);
+    if (sections.size() < 2) {
+        fprintf(stderr, "The synthetic INI has no option sections\n");
+        return 1;
+    }
+    firstSection = sections[1]; // sections[0] is "*Options"
+    lastSection = sections.back();
+    
+    BenchRunner runner;
+    registerSectionBenchmarks(runner);
+    registerValueBenchmarks(runner, "first_section", firstSection);
+    registerValueBenchmarks(runner, "last_section", lastSection);
+    const int result = runner.run(argc, argv);
+    
+    removeScratchDirectory(scratchPath);
+    return result;
+}
@@ -0,0 +1,169 @@
+/********************************************************************************
+ * File: bench_ips.cpp
+ * Author: ppkantorski
+ * Description:
+ *   Benchmarks the IPS apply engine of mod_funcs.hpp against the per-record
+ *   hex-by-offset commands that patches used to be converted into. Each run
+ *   writes the same 5000 records, a fifth of them RLE, to an 8 MB file.
+ *
+ *   Apply  - records per second written by applyIpsPatch() and hexEditByOffset()
+ *   Verify - records per second checked by applyIpsPatch() with verifyOnly
+ *
+ *   For the latest updates and contributions, visit the project's GitHub repository.
+ *   (GitHub Repository: https://github.com/ppkantorski/Ultrahand-Overlay)
+ *
+ *   Note: Please be aware that this notice cannot be altered or removed. It is a part
+ *   of the project's documentation and must remain intact.
+ *
+ *  Licensed under both GPLv2 and CC-BY-4.0
+ *  Copyright (c) 2024 ppkantorski
+ ********************************************************************************/
+
+#include "host.hpp"
+#include "bench.hpp"
+
+
+static constexpr size_t TARGET_SIZE = 8 * 1024 * 1024;
+static constexpr size_t RECORD_COUNT = 5000;
+
+struct IpsRecord {
+    uint32_t offset;
+    std::vector<uint8_t> data;
+    bool runLength; // Stored as an RLE record, data holds the expanded run
+};
+
+static std::vector<IpsRecord> records;
+static std::vector<std::string> hexRecords; // The records as hex-by-offset arguments
+static std::string targetPath, ipsPath, ips32Path;
+
+/**
+ * @brief Builds the records from a fixed seed, so every run patches the same bytes.
+ */
+static void makeRecords() {
+    uint32_t state = 0x2545F491;
+    auto next = [&state]() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    };
+    
+    while (records.size() < RECORD_COUNT) {
+        IpsRecord record;
+        record.offset = next() % (TARGET_SIZE - 64);
+        if (record.offset == 0x454F46) // Would read as the IPS "EOF" footer
+            continue;
+        
+        record.runLength = (records.size() % 5 == 0);
+        if (record.runLength)
+            record.data.assign(8 + next() % 56, static_cast<uint8_t>(next()));
+        else {
+            record.data.resize(1 + next() % 16);
+            for (auto& byte : record.data)
+                byte = static_cast<uint8_t>(next());
+        }
+        
+        std::string hexData;
+        appendHexString(hexData, record.data.data(), record.data.size());
+        hexRecords.push_back(std::move(hexData));
+        records.push_back(std::move(record));
+    }
+}
+
+/**
+ * @brief Writes the records as an IPS or IPS32 patch.
+ */
+static bool writePatch(const std::string& patchPath, bool isIps32) {
+    FILE* patchFile = fopen(patchPath.c_str(), "wb");
+    if (!patchFile)
+        return false;
+    
+    const size_t offsetSize = isIps32 ? 4 : 3;
+    const std::string& head = isIps32 ? IPS32_HEAD_MAGIC : IPS_HEAD_MAGIC;
+    const std::string& foot = isIps32 ? IPS32_FOOT_MAGIC : IPS_FOOT_MAGIC;
+    
+    bool success = fwrite(head.data(), 1, head.size(), patchFile) == head.size();
+    for (const auto& record : records) {
+        success = success && writeIpsNumber(patchFile, offsetSize, record.offset);
+        if (record.runLength) {
+            success = success && writeIpsNumber(patchFile, 2, 0) &&
+                writeIpsNumber(patchFile, 2, record.data.size()) && writeIpsNumber(patchFile, 1, record.data[0]);
+        } else {
+            success = success && writeIpsNumber(patchFile, 2, record.data.size()) &&
+                fwrite(record.data.data(), 1, record.data.size(), patchFile) == record.data.size();
+        }
+    }
+    success = success && fwrite(foot.data(), 1, foot.size(), patchFile) == foot.size();
+    return (fclose(patchFile) == 0) && success;
+}
+
+static void registerApplyBenchmarks(BenchRunner& runner) {
+    runner.add("Apply/hexEditByOffset/5000_records", [](BenchState& state) {
+        while (state.keepRunning()) {
+            for (size_t i = 0; i < records.size(); ++i)
+                hexEditByOffset(targetPath, records[i].offset, hexRecords[i]);
+        }
+        state.setItemsProcessed(state.getIterations() * records.size());
+    });
+    
+    runner.add("Apply/applyIpsPatch/ips/5000_records", [](BenchState& state) {
+        while (state.keepRunning()) {
+            if (!applyIpsPatch(targetPath, ipsPath)) {
+                state.skipWithError("applyIpsPatch failed on the IPS patch");
+                return;
+            }
+        }
+        state.setItemsProcessed(state.getIterations() * records.size());
+    });
+    
+    runner.add("Apply/applyIpsPatch/ips32/5000_records", [](BenchState& state) {
+        while (state.keepRunning()) {
+            if (!applyIpsPatch(targetPath, ips32Path)) {
+                state.skipWithError("applyIpsPatch failed on the IPS32 patch");
+                return;
+            }
+        }
+        state.setItemsProcessed(state.getIterations() * records.size());
+    });
+    
+    // The Apply runs above leave the patch applied, so verification reads every record
+    runner.add("Verify/applyIpsPatch/ips/5000_records", [](BenchState& state) {
+        while (state.keepRunning()) {
+            if (!applyIpsPatch(targetPath, ipsPath, true)) {
+                state.skipWithError("the applied IPS patch did not verify");
+                return;
+            }
+        }
+        state.setItemsProcessed(state.getIterations() * records.size());
+    });
+}
+
+int main(int argc, char* argv[]) {
+    const std::string scratchPath = makeScratchDirectory("bench_ips");
+    targetPath = scratchPath + "main";
+    ipsPath = scratchPath + "patch.ips";
+    ips32Path = scratchPath + "patch.ips32";
+    
+    makeRecords();
+    if (!writeHostFile(targetPath, std::string(TARGET_SIZE, '\0')) ||
+        !writePatch(ipsPath, false) || !writePatch(ips32Path, true)) {
+        fprintf(stderr, "Failed to write the benchmark files to %s\n", scratchPath.c_str());
+        return 1;
+    }
+    applyIpsPatch(targetPath, ipsPath); // Verify also holds when only Verify is run
+    
+    // Verification must not need write access to the file
+    const std::string readOnlyPath = scratchPath + "main_read_only";
+    if (!writeHostFile(readOnlyPath, readHostFile(targetPath)) || chmod(readOnlyPath.c_str(), 0444) != 0 ||
+        !applyIpsPatch(readOnlyPath, ipsPath, true)) {
+        fprintf(stderr, "The applied IPS patch did not verify on a read-only copy\n");
+        return 1;
+    }
+    
+    BenchRunner runner;
+    registerApplyBenchmarks(runner);
+    const int result = runner.run(argc, argv);
+    
+    removeScratchDirectory(scratchPath);
+    return result;
+}
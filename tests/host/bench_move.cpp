@@ -0,0 +1,261 @@
+/********************************************************************************
+ * File: bench_move.cpp
+ * Author: ppkantorski
+ * Description:
+ *   Benchmarks moveFileOrDirectory() of path_funcs.hpp against the per-file
+ *   move it replaced. The per-file move below is moveFileOrDirectory() of the
+ *   code before the single rename and the merge move, kept here as the
+ *   reference. Before anything is timed, both must leave the same tree
+ *   behind, file contents included, and no source folder.
+ *
+ *   Move  - entries per second moved from a folder of 20 x 100 files to a
+ *           destination that does not exist yet
+ *   Merge - entries per second moved from a folder of 10 x 20 files into
+ *           a destination that already has half of its folders, with
+ *           files in the way and files of its own to keep
+ *
+ *   For the latest updates and contributions, visit the project's GitHub repository.
+ *   (GitHub Repository: https://github.com/ppkantorski/Ultrahand-Overlay)
+ *
+ *   Note: Please be aware that this notice cannot be altered or removed. It is a part
+ *   of the project's documentation and must remain intact.
+ *
+ *  Licensed under both GPLv2 and CC-BY-4.0
+ *  Copyright (c) 2024 ppkantorski
+ ********************************************************************************/
+
+#include "host.hpp"
+#include "bench.hpp"
+#include <algorithm>
+
+
+/**
+ * @brief The size of the source tree of a case, and whether its destination exists.
+ */
+struct MoveCase {
+    std::string name;
+    size_t folderCount;
+    size_t filesPerFolder;
+    bool merge;
+    std::string expectedTree; // Left behind by the per-file move
+};
+
+static std::string scratchPath, sourcePath, destinationPath;
+static std::vector<MoveCase> moveCases = {
+    {"Move", 20, 100, false, ""},
+    {"Merge", 10, 20, true, ""}
+};
+
+/**
+ * @brief The per-file move that moveFileOrDirectory() used to be.
+ */
+static void perFileMoveFileOrDirectory(const std::string& sourcePath, const std::string& destinationPath) {
+    struct stat sourceInfo, destinationInfo;
+    
+    if (stat(sourcePath.c_str(), &sourceInfo) == 0) {
+        // Source file or directory exists
+        
+        // Check if the destination path exists
+        bool destinationExists = (stat(getParentDirFromPath(destinationPath).c_str(), &destinationInfo) == 0);
+        if (!destinationExists)
+            createDirectory(getParentDirFromPath(destinationPath).c_str()); // Create the destination directory
+        
+        if (S_ISDIR(sourceInfo.st_mode)) {
+            // Source path is a directory, recreate its folders and move its files in one walk
+            DirWalker walker(sourcePath, true);
+            if (!walker.isOpen())
+                return;
+            
+            std::string destinationFilePath;
+            
+            while (walker.next()) {
+                destinationFilePath.assign(destinationPath).append(walker.getRelativePath());
+                
+                if (walker.isDirectory()) {
+                    // Parents are reported first, so only this level is missing
+                    createSingleDirectory(destinationFilePath);
+                } else {
+                    deleteFileOrDirectory(destinationFilePath); // delete destination file for overwriting
+                    rename(walker.getPath().c_str(), destinationFilePath.c_str());
+                }
+            }
+            
+            // Delete the source directory
+            deleteFileOrDirectory(sourcePath);
+            invalidateDirectoryListing(destinationPath);
+        } else {
+            // Source path is a regular file
+            std::string filename = getNameFromPath(sourcePath.c_str());
+            
+            std::string destinationFilePath = destinationPath;
+            
+            if (destinationPath[destinationPath.length() - 1] == '/') {
+                destinationFilePath += filename;
+            }
+            
+            deleteFileOrDirectory(destinationFilePath); // delete destiantion file for overwriting
+            if (rename(sourcePath.c_str(), destinationFilePath.c_str()) == -1)
+                return;
+            invalidateDirectoryListing(sourcePath);
+            invalidateDirectoryListing(destinationFilePath);
+        }
+    }
+}
+
+/**
+ * @brief Builds the source tree of a case, and for a merge, the destination it merges into.
+ *
+ * Every file holds its own relative path and which side it was written on, so a file that
+ * is not replaced, or replaced by the wrong one, shows in the tree snapshot.
+ */
+static bool makeTrees(const MoveCase& moveCase) {
+    namespace fs = std::filesystem;
+    std::error_code error;
+    fs::remove_all(sourcePath, error);
+    fs::remove_all(destinationPath, error);
+    
+    std::string folder, name;
+    for (size_t folderIndex = 0; folderIndex < moveCase.folderCount; ++folderIndex) {
+        folder = "folder_" + std::to_string(folderIndex) + "/";
+        if (!fs::create_directories(sourcePath + folder, error) && error)
+            return false;
+        
+        // A merge finds every other folder at the destination, with half of its files in the way
+        const bool existing = moveCase.merge && folderIndex % 2 == 0;
+        if (existing && !fs::create_directories(destinationPath + folder, error) && error)
+            return false;
+        if (existing && !writeHostFile(destinationPath + folder + "kept.bin", "destination " + folder + "kept.bin"))
+            return false;
+        
+        for (size_t fileIndex = 0; fileIndex < moveCase.filesPerFolder; ++fileIndex) {
+            name = folder + "file_" + std::to_string(fileIndex) + ".bin";
+            if (!writeHostFile(sourcePath + name, "source " + name))
+                return false;
+            if (existing && fileIndex % 2 == 0 && !writeHostFile(destinationPath + name, "destination " + name))
+                return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Lists a tree as its sorted relative paths, each file followed by its content.
+ */
+static std::string snapshotTree(const std::string& rootPath) {
+    std::vector<std::string> entries;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(rootPath, error)) {
+        const std::string relativePath = entry.path().string().substr(rootPath.size());
+        entries.push_back(entry.is_directory() ? relativePath + "/" : relativePath + "=" + readHostFile(entry.path().string()));
+    }
+    std::sort(entries.begin(), entries.end());
+    
+    std::string snapshot;
+    for (const auto& entry : entries)
+        snapshot.append(entry).append("\n");
+    return snapshot;
+}
+
+static bool sourceRemoved() {
+    struct stat sourceInfo;
+    return stat(sourcePath.c_str(), &sourceInfo) != 0;
+}
+
+/**
+ * @brief Runs both moves on fresh trees and checks that they leave the same tree behind.
+ *
+ * @return The name of the first case that differs, empty if all agree.
+ */
+static std::string checkMoves() {
+    for (auto& moveCase : moveCases) {
+        if (!makeTrees(moveCase))
+            return moveCase.name + ": building the trees";
+        perFileMoveFileOrDirectory(sourcePath, destinationPath);
+        moveCase.expectedTree = snapshotTree(destinationPath);
+        if (!sourceRemoved() || moveCase.expectedTree.empty())
+            return moveCase.name + ": per-file move";
+        
+        if (!makeTrees(moveCase))
+            return moveCase.name + ": building the trees";
+        moveFileOrDirectory(sourcePath, destinationPath);
+        if (!sourceRemoved() || snapshotTree(destinationPath) != moveCase.expectedTree)
+            return moveCase.name + ": moveFileOrDirectory";
+    }
+    return "";
+}
+
+/**
+ * @brief Moves a fresh copy of the case's trees per iteration and checks the result after the last one.
+ *
+ * A move to a missing destination is undone with one rename outside the timing, so the
+ * 2000 files are only written once. A merge rebuilds both trees.
+ */
+template <typename Move>
+static void benchMove(BenchState& state, const MoveCase& moveCase, Move&& moveTree) {
+    if (!makeTrees(moveCase)) {
+        state.skipWithError("failed to build the trees");
+        return;
+    }
+    
+    std::string undoPath = destinationPath;
+    undoPath.pop_back();
+    bool first = true;
+    while (state.keepRunning()) {
+        state.pauseTiming();
+        if (!first && !(moveCase.merge ? makeTrees(moveCase) : rename(undoPath.c_str(), sourcePath.c_str()) == 0)) {
+            state.skipWithError("failed to restore the trees");
+            return;
+        }
+        first = false;
+        sync(); // Start each move without the writeback of the rebuilt trees
+        state.resumeTiming();
+        
+        moveTree(sourcePath, destinationPath);
+    }
+    state.setItemsProcessed(state.getIterations() * moveCase.folderCount * (moveCase.filesPerFolder + 1));
+    
+    if (!sourceRemoved() || snapshotTree(destinationPath) != moveCase.expectedTree)
+        state.skipWithError("the moved tree differs from the per-file move");
+}
+
+static void registerMoveBenchmarks(BenchRunner& runner) {
+    for (const auto& moveCase : moveCases) {
+        const std::string size = std::to_string(moveCase.folderCount * moveCase.filesPerFolder) + "_files";
+        
+        runner.add(moveCase.name + "/per_file_baseline/" + size, [&moveCase](BenchState& state) {
+            benchMove(state, moveCase, perFileMoveFileOrDirectory);
+        });
+        
+        runner.add(moveCase.name + "/moveFileOrDirectory/" + size, [&moveCase](BenchState& state) {
+            benchMove(state, moveCase, moveFileOrDirectory);
+        });
+    }
+}
+
+int main(int argc, char* argv[]) {
+    scratchPath = makeScratchDirectory("bench_move");
+    
+    // createDirectory() builds its paths from "sdmc:/", so the trees live in a "sdmc:" folder
+    if (mkdir((scratchPath + "sdmc:").c_str(), 0777) != 0 || chdir(scratchPath.c_str()) != 0) {
+        fprintf(stderr, "Failed to prepare %s\n", scratchPath.c_str());
+        removeScratchDirectory(scratchPath);
+        return 1;
+    }
+    sourcePath = "sdmc:/source/";
+    destinationPath = "sdmc:/destination/";
+    
+    // Both moves must leave the same tree before their timings mean anything
+    const std::string failedCase = checkMoves();
+    if (!failedCase.empty()) {
+        fprintf(stderr, "The moved trees differ: %s\n", failedCase.c_str());
+        removeScratchDirectory(scratchPath);
+        return 1;
+    }
+    
+    BenchRunner runner;
+    registerMoveBenchmarks(runner);
+    const int result = runner.run(argc, argv);
+    
+    removeScratchDirectory(scratchPath);
+    return result;
+}
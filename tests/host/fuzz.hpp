@@ -0,0 +1,32 @@
+/********************************************************************************
+ * File: fuzz.hpp
+ * Author: ppkantorski
+ * Description:
+ *   This header file provides the checks used by the libFuzzer harnesses. A
+ *   failed check prints the condition and aborts, so libFuzzer saves the input
+ *   as a crash and fuzz_replay reports it.
+ *
+ *   For the latest updates and contributions, visit the project's GitHub repository.
+ *   (GitHub Repository: https://github.com/ppkantorski/Ultrahand-Overlay)
+ *
+ *   Note: Please be aware that this notice cannot be altered or removed. It is a part
+ *   of the project's documentation and must remain intact.
+ *
+ *  Licensed under both GPLv2 and CC-BY-4.0
+ *  Copyright (c) 2024 ppkantorski
+ ********************************************************************************/
+
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+
+#define FUZZ_CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            abort(); \
+        } \
+    } while (0)
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
@@ -0,0 +1,46 @@
+/********************************************************************************
+ * File: fuzz_parse_ini.cpp
+ * Author: ppkantorski
+ * Description:
+ *   libFuzzer harness for parseIni(), the parser behind the libtesla
+ *   hlp::ini settings helpers. Checks that parsing never keeps whitespace and
+ *   that writing the parsed data back out and parsing it again gives the
+ *   same data.
+ *
+ *   For the latest updates and contributions, visit the project's GitHub repository.
+ *   (GitHub Repository: https://github.com/ppkantorski/Ultrahand-Overlay)
+ *
+ *   Note: Please be aware that this notice cannot be altered or removed. It is a part
+ *   of the project's documentation and must remain intact.
+ *
+ *  Licensed under both GPLv2 and CC-BY-4.0
+ *  Copyright (c) 2024 ppkantorski
+ ********************************************************************************/
+
+#include "host.hpp"
+#include "fuzz.hpp"
+
+
+static bool hasWhitespace(const std::string& text) {
+    return std::any_of(text.begin(), text.end(), [](char c) { return std::isspace(static_cast<unsigned char>(c)); });
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    const std::string content(reinterpret_cast<const char*>(data), size);
+    const auto iniData = parseIni(content);
+    
+    std::string written;
+    for (const auto& section : iniData) {
+        FUZZ_CHECK(!hasWhitespace(section.first));
+        written += "[" + section.first + "]\n";
+        for (const auto& keyValue : section.second) {
+            FUZZ_CHECK(!hasWhitespace(keyValue.first));
+            FUZZ_CHECK(!hasWhitespace(keyValue.second));
+            FUZZ_CHECK(keyValue.first.find('=') == std::string::npos);
+            written += keyValue.first + "=" + keyValue.second + "\n";
+        }
+    }
+    
+    FUZZ_CHECK(parseIni(written) == iniData);
+    return 0;
+}
@@ -0,0 +1,49 @@
+/********************************************************************************
+ * File: fuzz_parsed_data.cpp
+ * Author: ppkantorski
+ * Description:
+ *   libFuzzer harness for getParsedDataFromIniFile(). The input is written to
+ *   a scratch file and read back through the file-based readers, which must
+ *   agree with each other: every value getParsedDataFromIniFile() returns is
+ *   the one IniDocument finds, and parseSectionsFromIni() lists the same
+ *   sections as IniDocument.
+ *
+ *   For the latest updates and contributions, visit the project's GitHub repository.
+ *   (GitHub Repository: https://github.com/ppkantorski/Ultrahand-Overlay)
+ *
+ *   Note: Please be aware that this notice cannot be altered or removed. It is a part
+ *   of the project's documentation and must remain intact.
+ *
+ *  Licensed under both GPLv2 and CC-BY-4.0
+ *  Copyright (c) 2024 ppkantorski
+ ********************************************************************************/
+
+#include "host.hpp"
+#include "fuzz.hpp"
+
+
+static const std::string iniPath = makeScratchDirectory("fuzz_parsed_data") + "input.ini";
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    const std::string_view content(reinterpret_cast<const char*>(data), size);
+    if (!writeHostFile(iniPath, content))
+        return 0;
+    invalidateIniCache(iniPath);
+    
+    const auto iniData = getParsedDataFromIniFile(iniPath);
+    
+    IniDocument iniDocument;
+    FUZZ_CHECK(iniDocument.load(iniPath));
+    
+    std::string value;
+    for (const auto& section : iniData) {
+        for (const auto& keyValue : section.second) {
+            FUZZ_CHECK(iniDocument.getValue(section.first, keyValue.first, value));
+            FUZZ_CHECK(value == keyValue.second);
+        }
+    }
+    
+    FUZZ_CHECK(parseSectionsFromIni(iniPath) == iniDocument.getSectionNames());
+    FUZZ_CHECK(parseValueFromIniSection(iniPath, "", "") == iniDocument.getValue("", ""));
+    return 0;
+}
@@ -0,0 +1,74 @@
+/********************************************************************************
+ * File: fuzz_replay.cpp
+ * Author: ppkantorski
+ * Description:
+ *   Stand-in for the libFuzzer driver, for compilers without -fsanitize=fuzzer.
+ *   Runs a harness once over every file given on the command line, and over
+ *   every file inside the directories given, so a corpus or a saved crash can
+ *   be replayed with plain GCC.
+ *
+ *   Usage:
+ *     fuzz_parse_ini.replay <file or directory>...
+ *
+ *   For the latest updates and contributions, visit the project's GitHub repository.
+ *   (GitHub Repository: https://github.com/ppkantorski/Ultrahand-Overlay)
+ *
+ *   Note: Please be aware that this notice cannot be altered or removed. It is a part
+ *   of the project's documentation and must remain intact.
+ *
+ *  Licensed under both GPLv2 and CC-BY-4.0
+ *  Copyright (c) 2024 ppkantorski
+ ********************************************************************************/
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include "fuzz.hpp"
+
+
+static bool runInput(const std::string& inputPath) {
+    FILE* file = fopen(inputPath.c_str(), "rb");
+    if (!file) {
+        fprintf(stderr, "Failed to open %s\n", inputPath.c_str());
+        return false;
+    }
+    
+    std::vector<uint8_t> input;
+    uint8_t buffer[65536];
+    size_t bytesRead;
+    while ((bytesRead = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        input.insert(input.end(), buffer, buffer + bytesRead);
+    fclose(file);
+    
+    LLVMFuzzerTestOneInput(input.data(), input.size());
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> inputPaths;
+    std::error_code error;
+    
+    for (int i = 1; i < argc; ++i) {
+        if (fs::is_directory(argv[i], error)) {
+            for (const auto& entry : fs::recursive_directory_iterator(argv[i], error)) {
+                if (entry.is_regular_file(error))
+                    inputPaths.push_back(entry.path().string());
+            }
+        } else
+            inputPaths.push_back(argv[i]);
+    }
+    std::sort(inputPaths.begin(), inputPaths.end());
+    
+    size_t inputsRun = 0;
+    for (const auto& inputPath : inputPaths) {
+        if (runInput(inputPath))
+            ++inputsRun;
+    }
+    
+    printf("%s: %zu of %zu inputs ran without a failed check\n", argv[0], inputsRun, inputPaths.size());
+    return inputsRun == inputPaths.size() ? 0 : 1;
+}
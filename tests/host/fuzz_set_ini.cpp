@@ -0,0 +1,94 @@
+/********************************************************************************
+ * File: fuzz_set_ini.cpp
+ * Author: ppkantorski
+ * Description:
+ *   libFuzzer harness for setIniFile() round-trips. The first line of the
+ *   input names a section, key and value separated by tabs, the rest is the
+ *   INI file. After setIniFileValue() the key must read back with the new
+ *   value in the matching sections, and every other key must keep the value
+ *   it had before.
+ *
+ *   For the latest updates and contributions, visit the project's GitHub repository.
+ *   (GitHub Repository: https://github.com/ppkantorski/Ultrahand-Overlay)
+ *
+ *   Note: Please be aware that this notice cannot be altered or removed. It is a part
+ *   of the project's documentation and must remain intact.
+ *
+ *  Licensed under both GPLv2 and CC-BY-4.0
+ *  Copyright (c) 2024 ppkantorski
+ ********************************************************************************/
+
+#include "host.hpp"
+#include "fuzz.hpp"
+
+
+static const std::string iniPath = makeScratchDirectory("fuzz_set_ini") + "input.ini";
+
+/**
+ * @brief Keeps the characters a section, key or value can hold in a written INI line.
+ *
+ * Quotes are dropped too, as setIniFile() unquotes the existing section names but not the desired one.
+ */
+static std::string sanitizeName(std::string_view text) {
+    std::string name;
+    for (char c : text) {
+        if (std::isprint(static_cast<unsigned char>(c)) && !std::strchr("[]=;#\"'", c))
+            name.push_back(c);
+    }
+    return trim(name);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    const std::string_view input(reinterpret_cast<const char*>(data), size);
+    const size_t headerEnd = std::min(input.find('\n'), input.size());
+    const std::string_view header = input.substr(0, headerEnd);
+    const std::string_view content = input.substr(std::min(headerEnd + 1, input.size()));
+    
+    const size_t keyStart = std::min(header.find('\t'), header.size());
+    const size_t valueStart = std::min(header.find('\t', std::min(keyStart + 1, header.size())), header.size());
+    const std::string section = sanitizeName(header.substr(0, keyStart));
+    std::string key = sanitizeName(header.substr(std::min(keyStart + 1, header.size()), valueStart - std::min(keyStart + 1, header.size())));
+    const std::string value = sanitizeName(header.substr(std::min(valueStart + 1, header.size())));
+    if (key.empty())
+        key = "key";
+    
+    if (!writeHostFile(iniPath, content))
+        return 0;
+    invalidateIniCache(iniPath);
+    const auto before = getParsedDataFromIniFile(iniPath);
+    
+    setIniFileValue(iniPath, section, key, value);
+    
+    const auto after = getParsedDataFromIniFile(iniPath);
+    
+    // Like setIniFile always did, the section is matched by its trimmed, unquoted name
+    auto isTarget = [&section](const std::string& sectionName) {
+        return trim(removeQuotes(sectionName)) == section;
+    };
+    
+    bool valueFound = false;
+    for (const auto& afterSection : after) {
+        auto beforeSection = before.find(afterSection.first);
+        for (const auto& keyValue : afterSection.second) {
+            if (isTarget(afterSection.first) && keyValue.first == key) {
+                FUZZ_CHECK(keyValue.second == value);
+                valueFound = true;
+                continue;
+            }
+            // Every other key must have been there before, with the same value
+            FUZZ_CHECK(beforeSection != before.end());
+            auto beforeKey = beforeSection->second.find(keyValue.first);
+            FUZZ_CHECK(beforeKey != beforeSection->second.end() && beforeKey->second == keyValue.second);
+        }
+    }
+    FUZZ_CHECK(valueFound);
+    
+    // ...and no key may have been dropped
+    for (const auto& beforeSection : before) {
+        auto afterSection = after.find(beforeSection.first);
+        FUZZ_CHECK(afterSection != after.end());
+        for (const auto& keyValue : beforeSection.second)
+            FUZZ_CHECK(afterSection->second.count(keyValue.first) == 1);
+    }
+    return 0;
+}
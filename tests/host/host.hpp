@@ -0,0 +1,128 @@
+/********************************************************************************
+ * File: host.hpp
+ * Author: ppkantorski
+ * Description:
+ *   This header file pulls in the Ultrahand INI, hex and file functions for
+ *   the Linux host harnesses in the order main.cpp sees them: ini_funcs.hpp
+ *   first, as tesla.hpp includes it, then the headers of utils.hpp. The libnx
+ *   and jansson shims from shim/ stand in for the Switch libraries. Each
+ *   harness is a single translation unit, as the functions are defined in
+ *   the headers.
+ *
+ *   For the latest updates and contributions, visit the project's GitHub repository.
+ *   (GitHub Repository: https://github.com/ppkantorski/Ultrahand-Overlay)
+ *
+ *   Note: Please be aware that this notice cannot be altered or removed. It is a part
+ *   of the project's documentation and must remain intact.
+ *
+ *  Licensed under both GPLv2 and CC-BY-4.0
+ *  Copyright (c) 2024 ppkantorski
+ ********************************************************************************/
+
+#pragma once
+#include <switch.h> // shim/switch.h
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <unistd.h>
+#include <ini_funcs.hpp>
+#include <path_funcs.hpp>
+#include <hex_funcs.hpp>
+#include <list_funcs.hpp>
+#include <mod_funcs.hpp>
+
+#ifndef REPO_ROOT
+#define REPO_ROOT "../.."
+#endif
+
+
+/**
+ * @brief Reads a whole file into a string.
+ *
+ * @param filePath The path to the file.
+ * @return The content, empty if the file cannot be read.
+ */
+inline std::string readHostFile(const std::string& filePath) {
+    std::string content;
+    FILE* file = fopen(filePath.c_str(), "rb");
+    if (!file)
+        return content;
+    
+    char buffer[65536];
+    size_t bytesRead;
+    while ((bytesRead = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        content.append(buffer, bytesRead);
+    fclose(file);
+    return content;
+}
+
+/**
+ * @brief Replaces a file with the given content.
+ *
+ * @param filePath The path to the file.
+ * @param content The content to write.
+ * @return True if the whole content was written.
+ */
+inline bool writeHostFile(const std::string& filePath, std::string_view content) {
+    FILE* file = fopen(filePath.c_str(), "wb");
+    if (!file)
+        return false;
+    
+    bool success = content.empty() || fwrite(content.data(), 1, content.size(), file) == content.size();
+    return (fclose(file) == 0) && success;
+}
+
+/**
+ * @brief Lists the seed INI files shipped with the repository.
+ *
+ * These are examples/package.ini, examples/<package>/package.ini and themes/<theme>.ini.
+ *
+ * @return The paths of the seed files, sorted.
+ */
+inline std::vector<std::string> getSeedIniFiles() {
+    namespace fs = std::filesystem;
+    std::vector<std::string> seedFiles;
+    std::error_code error;
+    
+    const fs::path examplesPath = fs::path(REPO_ROOT) / "examples";
+    if (fs::is_regular_file(examplesPath / "package.ini", error))
+        seedFiles.push_back((examplesPath / "package.ini").string());
+    for (const auto& entry : fs::directory_iterator(examplesPath, error)) {
+        if (entry.is_directory(error) && fs::is_regular_file(entry.path() / "package.ini", error))
+            seedFiles.push_back((entry.path() / "package.ini").string());
+    }
+    
+    for (const auto& entry : fs::directory_iterator(fs::path(REPO_ROOT) / "themes", error)) {
+        if (entry.is_regular_file(error) && entry.path().extension() == ".ini")
+            seedFiles.push_back(entry.path().string());
+    }
+    
+    std::sort(seedFiles.begin(), seedFiles.end());
+    return seedFiles;
+}
+
+/**
+ * @brief Creates an empty scratch directory for one harness run.
+ *
+ * @param name The name of the harness.
+ * @return The directory path, with a trailing slash.
+ */
+inline std::string makeScratchDirectory(const std::string& name) {
+    namespace fs = std::filesystem;
+    const fs::path scratchPath = fs::temp_directory_path() / ("ultrahand-" + name + "-" + std::to_string(getpid()));
+    std::error_code error;
+    fs::remove_all(scratchPath, error);
+    fs::create_directories(scratchPath, error);
+    return scratchPath.string() + "/";
+}
+
+/**
+ * @brief Removes a scratch directory made by makeScratchDirectory().
+ */
+inline void removeScratchDirectory(const std::string& scratchPath) {
+    std::error_code error;
+    std::filesystem::remove_all(scratchPath, error);
+}
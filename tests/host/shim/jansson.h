@@ -0,0 +1,39 @@
+/********************************************************************************
+ * File: jansson.h
+ * Author: ppkantorski
+ * Description:
+ *   This header file stands in for jansson in host builds. The INI harnesses
+ *   never parse JSON, so every function reports an empty document.
+ *
+ *   For the latest updates and contributions, visit the project's GitHub repository.
+ *   (GitHub Repository: https://github.com/ppkantorski/Ultrahand-Overlay)
+ *
+ *   Note: Please be aware that this notice cannot be altered or removed. It is a part
+ *   of the project's documentation and must remain intact.
+ *
+ *  Licensed under both GPLv2 and CC-BY-4.0
+ *  Copyright (c) 2024 ppkantorski
+ ********************************************************************************/
+
+#pragma once
+#include <cstddef>
+
+struct json_t;
+
+struct json_error_t {
+    int line;
+    int column;
+    char text[160];
+};
+
+inline json_t* json_loads(const char*, size_t, json_error_t*) { return nullptr; }
+inline json_t* json_load_file(const char*, size_t, json_error_t*) { return nullptr; }
+inline json_t* json_object() { return nullptr; }
+inline json_t* json_object_get(const json_t*, const char*) { return nullptr; }
+inline json_t* json_array_get(const json_t*, size_t) { return nullptr; }
+inline size_t json_array_size(const json_t*) { return 0; }
+inline bool json_is_string(const json_t*) { return false; }
+inline bool json_is_array(const json_t*) { return false; }
+inline bool json_is_object(const json_t*) { return false; }
+inline const char* json_string_value(const json_t*) { return nullptr; }
+inline void json_decref(json_t*) {}
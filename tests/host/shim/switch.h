@@ -0,0 +1,76 @@
+/********************************************************************************
+ * File: switch.h
+ * Author: ppkantorski
+ * Description:
+ *   This header file stands in for libnx when the INI, hex and file functions
+ *   are built for a Linux host. It only declares the integer types, result
+ *   macros and NRO/NACP structures that those headers refer to; nothing here
+ *   talks to Horizon services.
+ *
+ *   For the latest updates and contributions, visit the project's GitHub repository.
+ *   (GitHub Repository: https://github.com/ppkantorski/Ultrahand-Overlay)
+ *
+ *   Note: Please be aware that this notice cannot be altered or removed. It is a part
+ *   of the project's documentation and must remain intact.
+ *
+ *  Licensed under both GPLv2 and CC-BY-4.0
+ *  Copyright (c) 2024 ppkantorski
+ ********************************************************************************/
+
+#pragma once
+#include <cstdint>
+
+typedef uint8_t  u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t   s8;
+typedef int16_t  s16;
+typedef int32_t  s32;
+typedef int64_t  s64;
+
+typedef u32 Result;
+
+#define MAKERESULT(module, description) ((((module) & 0x1FF)) | ((description) & 0x1FFF) << 9)
+#define R_SUCCEEDED(res) ((res) == 0)
+#define R_FAILED(res) ((res) != 0)
+
+// Layouts as in libnx nro.h and nacp.h, only the fields read by getOverlayInfo() are named
+struct NroStart {
+    u32 unused;
+    u32 mod_offset;
+    u8 padding[8];
+};
+
+struct NroHeader {
+    u32 magic;
+    u32 unk1;
+    u32 size;
+    u32 unk2;
+    u8 reserved[0x60];
+};
+
+struct NroAssetSection {
+    u64 offset;
+    u64 size;
+};
+
+struct NroAssetHeader {
+    u32 magic;
+    u32 version;
+    NroAssetSection icon;
+    NroAssetSection nacp;
+    NroAssetSection romfs;
+};
+
+struct NacpLanguageEntry {
+    char name[0x200];
+    char author[0x100];
+};
+
+struct NacpStruct {
+    NacpLanguageEntry lang[16];
+    u8 reserved[0x60];
+    char display_version[0x10];
+    u8 reserved2[0xF90];
+};
@@ -0,0 +1,150 @@
+/********************************************************************************
+ * File: test_glob.cpp
+ * Author: ppkantorski
+ * Description:
+ *   Test for GlobPattern of get_funcs.hpp. Every pattern is matched over a
+ *   small tree and compared with a naive reference, which lists the whole
+ *   tree and matches each path segment by segment. Patterns with several
+ *   "**" can reach one directory through different splits of its path, so
+ *   each path must also be returned exactly once.
+ *
+ *   For the latest updates and contributions, visit the project's GitHub repository.
+ *   (GitHub Repository: https://github.com/ppkantorski/Ultrahand-Overlay)
+ *
+ *   Note: Please be aware that this notice cannot be altered or removed. It is a part
+ *   of the project's documentation and must remain intact.
+ *
+ *  Licensed under both GPLv2 and CC-BY-4.0
+ *  Copyright (c) 2024 ppkantorski
+ ********************************************************************************/
+
+#include "host.hpp"
+#include "fuzz.hpp"
+#include <algorithm>
+#include <set>
+
+
+static std::string rootPath;
+
+static std::vector<std::string> splitPath(const std::string& path) {
+    std::vector<std::string> parts;
+    size_t start = 0, end;
+    while (start <= path.size()) {
+        end = path.find('/', start);
+        if (end == std::string::npos)
+            end = path.size();
+        if (end > start)
+            parts.push_back(path.substr(start, end - start));
+        start = end + 1;
+    }
+    return parts;
+}
+
+/**
+ * @brief Matches one name against '*' and '?', with every other character literal.
+ */
+static bool referenceMatchesName(const char* pattern, const char* name) {
+    if (*pattern == '\0')
+        return *name == '\0';
+    if (*pattern == '*')
+        return referenceMatchesName(pattern + 1, name) || (*name != '\0' && referenceMatchesName(pattern, name + 1));
+    if (*name == '\0' || (*pattern != '?' && *pattern != *name))
+        return false;
+    return referenceMatchesName(pattern + 1, name + 1);
+}
+
+/**
+ * @brief Matches path segments against pattern segments, "**" taking any number of them.
+ *
+ * A trailing "**" needs at least one segment, as it matches the entries below a directory.
+ */
+static bool referenceMatchesPath(const std::vector<std::string>& pattern, size_t patternIndex,
+                                 const std::vector<std::string>& path, size_t pathIndex) {
+    if (patternIndex == pattern.size())
+        return pathIndex == path.size();
+    
+    if (pattern[patternIndex] == "**") {
+        if (patternIndex + 1 == pattern.size())
+            return pathIndex < path.size();
+        for (size_t skipped = pathIndex; skipped <= path.size(); ++skipped) {
+            if (referenceMatchesPath(pattern, patternIndex + 1, path, skipped))
+                return true;
+        }
+        return false;
+    }
+    
+    return pathIndex < path.size() &&
+        referenceMatchesName(pattern[patternIndex].c_str(), path[pathIndex].c_str()) &&
+        referenceMatchesPath(pattern, patternIndex + 1, path, pathIndex + 1);
+}
+
+/**
+ * @brief Lists the whole tree and keeps the paths the pattern matches, relative to the root.
+ */
+static std::vector<std::string> referenceMatch(const std::string& relativePattern) {
+    const bool matchDirectories = (relativePattern.back() == '/');
+    const std::vector<std::string> pattern = splitPath(relativePattern);
+    
+    std::vector<std::string> matches;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(rootPath)) {
+        if (entry.is_directory() != matchDirectories)
+            continue;
+        const std::string relativePath = entry.path().string().substr(rootPath.size());
+        if (referenceMatchesPath(pattern, 0, splitPath(relativePath), 0))
+            matches.push_back(matchDirectories ? relativePath + "/" : relativePath);
+    }
+    std::sort(matches.begin(), matches.end());
+    return matches;
+}
+
+static void makeTree() {
+    namespace fs = std::filesystem;
+    for (const char* directory : {"a/x/x/x", "a/b/x/c", "a/b/y", "a/[Mod] x", "a/q"})
+        fs::create_directories(rootPath + directory);
+    
+    for (const char* file : {"a/y", "a/x/y", "a/x/x/y", "a/x/x/x/y", "a/b/x/c/y", "a/b/x/c/z.bin",
+                             "a/b/y/x", "a/[Mod] x/y", "a/q/y", "a/x/z.bin"})
+        FUZZ_CHECK(writeHostFile(rootPath + file, "data"));
+}
+
+/**
+ * @brief Checks the matches of a pattern against the reference and for duplicates.
+ */
+static void checkPattern(const std::string& relativePattern, bool useListingCache) {
+    std::vector<std::string> matches = GlobPattern(rootPath + relativePattern).match(useListingCache);
+    for (auto& match : matches)
+        match.erase(0, rootPath.size());
+    
+    const std::set<std::string> uniqueMatches(matches.begin(), matches.end());
+    if (uniqueMatches.size() != matches.size()) {
+        fprintf(stderr, "%s: %zu matches, %zu of them unique\n", relativePattern.c_str(), matches.size(), uniqueMatches.size());
+        abort();
+    }
+    
+    std::sort(matches.begin(), matches.end());
+    const std::vector<std::string> expected = referenceMatch(relativePattern);
+    if (matches != expected) {
+        fprintf(stderr, "%s: %zu matches, the reference has %zu\n", relativePattern.c_str(), matches.size(), expected.size());
+        abort();
+    }
+}
+
+int main() {
+    rootPath = makeScratchDirectory("test_glob");
+    makeTree();
+    
+    const std::vector<std::string> patterns = {
+        "a/**/x/**/y", "a/**/x/**/y/", "a/x/**/x/**/x/**/y", "a/**/*/**/y", "a/**/**/y",
+        "a/**/y", "a/**", "a/**/", "a/**/x/**", "a/**/*.bin", "a/*/x/*/y", "a/**/x/*/",
+        "a/[Mod] */y", "a/?/y", "*/x/*"
+    };
+    
+    for (bool useListingCache : {false, true}) {
+        for (const auto& pattern : patterns)
+            checkPattern(pattern, useListingCache);
+    }
+    printf("glob patterns: %zu ok\n", patterns.size());
+    
+    removeScratchDirectory(rootPath);
+    return 0;
+}
@@ -0,0 +1,202 @@
+/********************************************************************************
+ * File: test_ini_flush.cpp
+ * Author: ppkantorski
+ * Description:
+ *   Crash-consistency test for the write-behind store of ini_funcs.hpp. A
+ *   flush replaces the file through a temp file, so however it is cut short,
+ *   the next load after recoverInterruptedIniSave() must find either the old
+ *   or the new file, byte for byte.
+ *
+ *   The interrupted states a save can leave behind are set up explicitly,
+ *   then real flushes in a child process are killed with SIGKILL after a
+ *   growing delay, which stops them at arbitrary points of the replace.
+ *   It also checks that reads see queued values without writing the file.
+ *
+ *   For the latest updates and contributions, visit the project's GitHub repository.
+ *   (GitHub Repository: https://github.com/ppkantorski/Ultrahand-Overlay)
+ *
+ *   Note: Please be aware that this notice cannot be altered or removed. It is a part
+ *   of the project's documentation and must remain intact.
+ *
+ *  Licensed under both GPLv2 and CC-BY-4.0
+ *  Copyright (c) 2024 ppkantorski
+ ********************************************************************************/
+
+#include "host.hpp"
+#include "bench.hpp" // makeSyntheticIni()
+#include "fuzz.hpp"
+#include <csignal>
+#include <sys/wait.h>
+
+
+static std::string scratchPath, iniPath, tempPath;
+static std::string oldContent, newContent;
+
+static bool fileExists(const std::string& filePath) {
+    struct stat fileStat;
+    return stat(filePath.c_str(), &fileStat) == 0;
+}
+
+/**
+ * @brief Resets the scratch directory to the old file and an empty write-behind store.
+ */
+static void resetFiles() {
+    remove(tempPath.c_str());
+    FUZZ_CHECK(writeHostFile(iniPath, oldContent));
+    invalidateIniCache(iniPath);
+}
+
+/**
+ * @brief Recovers the file and checks that it is exactly the old or the new content.
+ *
+ * @return True if the new content was found.
+ */
+static bool checkRecoveredFile() {
+    recoverInterruptedIniSave(iniPath);
+    const std::string content = readHostFile(iniPath);
+    FUZZ_CHECK(content == oldContent || content == newContent);
+    return content == newContent;
+}
+
+static void queueNewValue() {
+    queueIniFileValue(iniPath, "Option 0", "mode", "slider");
+}
+
+/**
+ * @brief The states a save leaves behind when it stops between two of its steps.
+ */
+static void testInterruptedStates() {
+    // Stopped while writing the temp file: the original is untouched
+    resetFiles();
+    FUZZ_CHECK(writeHostFile(tempPath, newContent.substr(0, newContent.size() / 2)));
+    FUZZ_CHECK(!checkRecoveredFile());
+    
+    // Stopped after the temp file was complete, before the original was removed
+    resetFiles();
+    FUZZ_CHECK(writeHostFile(tempPath, newContent));
+    FUZZ_CHECK(!checkRecoveredFile());
+    
+    // Stopped after the original was removed, before the rename
+    resetFiles();
+    FUZZ_CHECK(writeHostFile(tempPath, newContent));
+    remove(iniPath.c_str());
+    FUZZ_CHECK(checkRecoveredFile());
+    FUZZ_CHECK(!fileExists(tempPath));
+    
+    // The next load recovers the file on its own
+    resetFiles();
+    FUZZ_CHECK(writeHostFile(tempPath, newContent));
+    remove(iniPath.c_str());
+    IniDocument iniDocument;
+    FUZZ_CHECK(iniDocument.load(iniPath));
+    FUZZ_CHECK(iniDocument.toString() == newContent);
+    
+    printf("interrupted states: ok\n");
+}
+
+/**
+ * @brief Flushes the queued value in a child process and kills it after the given delay.
+ *
+ * @return The time the child ran, in microseconds.
+ */
+static int64_t runFlushChild(useconds_t killDelay) {
+    const auto start = std::chrono::steady_clock::now();
+    pid_t child = fork();
+    FUZZ_CHECK(child >= 0);
+    if (child == 0) {
+        queueNewValue();
+        _exit(flushPendingIniWrites(iniPath) ? 0 : 1);
+    }
+    
+    if (killDelay > 0) {
+        usleep(killDelay);
+        kill(child, SIGKILL);
+    }
+    int status;
+    waitpid(child, &status, 0);
+    FUZZ_CHECK(!WIFEXITED(status) || WEXITSTATUS(status) == 0);
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Kills flushes at delays spread over the time a whole flush takes and checks every outcome.
+ */
+static void testKilledFlushes() {
+    resetFiles();
+    const int64_t flushTime = runFlushChild(0);
+    FUZZ_CHECK(checkRecoveredFile());
+    
+    const size_t trials = 100;
+    size_t oldCount = 0, newCount = 0, inFlightCount = 0;
+    for (size_t trial = 0; trial < trials; ++trial) {
+        resetFiles();
+        runFlushChild(1 + flushTime * trial * 5 / (trials * 4)); // Up to 1.25 times the flush time
+        
+        if (fileExists(tempPath))
+            ++inFlightCount;
+        if (checkRecoveredFile())
+            ++newCount;
+        else
+            ++oldCount;
+    }
+    
+    // Both outcomes must have been reached, or the delays missed the flush
+    FUZZ_CHECK(oldCount > 0 && newCount > 0);
+    printf("killed flushes: %zu old, %zu new, %zu with a temp file left (a whole flush took %lld us)\n",
+        oldCount, newCount, inFlightCount, static_cast<long long>(flushTime));
+}
+
+/**
+ * @brief Queued values are read from the store and written once, by the flush.
+ */
+static void testReadsDoNotFlush() {
+    resetFiles();
+    queueNewValue();
+    
+    FUZZ_CHECK(getParsedDataFromIniFile(iniPath)["Option 0"]["mode"] == "slider");
+    FUZZ_CHECK(IniTransaction(iniPath).getValue("Option 0", "mode") == "slider");
+    FUZZ_CHECK(parseValueFromIniSection(iniPath, "Option 0", "mode") == "slider");
+    FUZZ_CHECK(readHostFile(iniPath) == oldContent);
+    
+    // A value queued again before the flush wins over the older one
+    queueIniFileValue(iniPath, "Option 0", "mode", "toggle");
+    queueNewValue();
+    FUZZ_CHECK(flushPendingIniWrites(iniPath));
+    FUZZ_CHECK(readHostFile(iniPath) == newContent);
+    
+    PendingIniValues pendingValues;
+    FUZZ_CHECK(!getPendingIniValues(iniPath, pendingValues));
+    
+    // A transaction that commits the file writes the queued values with it
+    resetFiles();
+    queueNewValue();
+    IniTransaction iniTransaction(iniPath);
+    iniTransaction.setValue("Option 1", "mode", "toggle"); // Unchanged
+    iniTransaction.setValue("Option 1", "extra", "1");
+    FUZZ_CHECK(iniTransaction.commit());
+    FUZZ_CHECK(!getPendingIniValues(iniPath, pendingValues));
+    FUZZ_CHECK(getParsedDataFromIniFile(iniPath)["Option 0"]["mode"] == "slider");
+    
+    printf("reads without flush: ok\n");
+}
+
+int main() {
+    scratchPath = makeScratchDirectory("test_ini_flush");
+    iniPath = scratchPath + "config.ini";
+    tempPath = iniPath + ".tmp";
+    
+    // Large enough that a flush takes a few milliseconds to write
+    oldContent = makeSyntheticIni(1024 * 1024);
+    IniDocument iniDocument;
+    iniDocument.loadFromString(oldContent);
+    iniDocument.setValue("Option 0", "mode", "slider");
+    newContent = iniDocument.toString();
+    FUZZ_CHECK(newContent != oldContent);
+    
+    testInterruptedStates();
+    testKilledFlushes();
+    testReadsDoNotFlush();
+    
+    removeScratchDirectory(scratchPath);
+    return 0;
+}